@@ -34,6 +34,8 @@ public:
 		return mRowPitch;
 	}
 
+	virtual void copy(Texture2D* source) = 0;
+
 	virtual auto map()-> MappedData = 0;
 
 	virtual void unmap() = 0;
@@ -36,6 +36,11 @@ void WindowsTexture2D::update(void * data)
 	static_cast<WindowsGraphics*>(mGraphics)->mDeviceContext->UpdateSubresource(mTexture2D, 0, nullptr, data, mRowPitch, 0);
 }
 
+void WindowsTexture2D::copy(Texture2D * source)
+{
+	static_cast<WindowsGraphics*>(mGraphics)->mDeviceContext->CopyResource(mTexture2D, static_cast<WindowsTexture2D*>(source)->mTexture2D);
+}
+
 auto WindowsTexture2D::map() -> MappedData {
 	D3D11_MAPPED_SUBRESOURCE mappedResource;
 
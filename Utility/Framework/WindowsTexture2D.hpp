@@ -22,6 +22,8 @@ public:
 
 	virtual void update(void* data)override;
 
+	virtual void copy(Texture2D* source)override;
+
 	virtual auto map()->MappedData override;
 
 	virtual void unmap()override;
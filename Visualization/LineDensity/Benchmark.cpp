@@ -0,0 +1,385 @@
+#include "Benchmark.hpp"
+#include "StreamDensityGenerator.hpp"
+#include "CpuDensityGenerator.hpp"
+#include "RandomLineGenerator.hpp"
+#include "ColorLookupTable.hpp"
+#include "LineBinaryFile.hpp"
+#include "ImageWriter.hpp"
+
+#ifdef LINE_DENSITY_GPU
+#include "DensityGenerator.hpp"
+#include "ImageGenerator.hpp"
+#endif
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <atomic>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+#undef max
+#undef min
+
+using time_point = std::chrono::high_resolution_clock;
+
+namespace {
+
+	auto seconds(time_point::time_point start, time_point::time_point end) -> double {
+		return std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+	}
+
+#ifdef LINE_DENSITY_GPU
+	auto wide_string(const std::string& str) -> std::wstring {
+		//only support english name, the same as main
+		return std::wstring(str.begin(), str.end());
+	}
+#endif
+
+	auto sum(const std::array<double, BENCHMARK_STAGE_COUNT>& times) -> double {
+		double result = 0;
+
+		for (auto time : times) result += time;
+
+		return result;
+	}
+
+	//{ "median": x, "p90": x, "min": x, "max": x }
+	void write_statistics(std::ostream& out, const std::vector<double>& values) {
+		out << "{ \"median\": " << Benchmark::percentile(values, 0.5) <<
+			", \"p90\": " << Benchmark::percentile(values, 0.9) <<
+			", \"min\": " << Benchmark::percentile(values, 0) <<
+			", \"max\": " << Benchmark::percentile(values, 1) << " }";
+	}
+}
+
+Benchmark::Benchmark(
+	const std::string& fileName,
+	const std::shared_ptr<ColorMapped>& colorMapped,
+	size_t thread_count,
+	const std::function<Factory*()>& factory) :
+	mColorMapped(colorMapped), mFactory(factory), mThreadCount(thread_count) {
+
+	std::ifstream file(fileName);
+	assert(file.is_open() == true);
+
+	std::string format = "binary";
+	std::string line;
+
+	while (std::getline(file, line)) {
+		std::istringstream stream(line);
+		std::string key;
+
+		if (!(stream >> key)) continue;
+
+		if (key == "series") { size_t value; while (stream >> value) mSeriesCounts.push_back(value); }
+		else if (key == "lines") { size_t value; while (stream >> value) mLineCounts.push_back(value); }
+		else if (key == "backend") { std::string value; while (stream >> value) mBackends.push_back(value); }
+		else if (key == "size") {
+			size_t width = 0, height = 0;
+
+			if (!(stream >> width >> height) || width == 0 || height == 0) {
+				std::cout << "error : benchmark size[" << line << "] should be \"size w h\" with positive w and h." << std::endl;
+
+				mValid = false;
+			}
+			else mSizes.push_back({ width, height });
+		}
+		else if (key == "repeat") stream >> mRepeat;
+		else if (key == "warmup") stream >> mWarmup;
+		else if (key == "budget") stream >> mStreamBudget;
+		else if (key == "seed") stream >> mSeed;
+		else if (key == "format") stream >> format;
+		else std::cout << "warning : unknown benchmark key[" << key << "]." << std::endl;
+	}
+
+	if (mSeriesCounts.empty() == true) mSeriesCounts.push_back(10000);
+	if (mLineCounts.empty() == true) mLineCounts.push_back(1000);
+	if (mSizes.empty() == true) mSizes.push_back({ 200, 200 });
+	if (mBackends.empty() == true) mBackends.push_back("cpu");
+
+#ifndef LINE_DENSITY_GPU
+	//the gpu backend is not built, see Common.hpp
+	const auto gpu_begin = std::remove(mBackends.begin(), mBackends.end(), std::string("gpu"));
+
+	if (gpu_begin != mBackends.end()) {
+		std::cout << "warning : gpu backend is not built, it is skipped." << std::endl;
+
+		mBackends.erase(gpu_begin, mBackends.end());
+	}
+#endif
+
+	mRepeat = std::max(mRepeat, static_cast<size_t>(1));
+
+	mDataName = fileName + (format == "text" ? ".data.txt" : ".data" LINE_BINARY_FILE_EXTENSION);
+	mImageName = fileName + ".image.png";
+}
+
+void Benchmark::run() {
+	mResults.clear();
+
+	for (auto series_count : mSeriesCounts) {
+		for (auto line_count : mLineCounts) {
+			for (auto& size : mSizes) {
+				//the data is generated once for the backends
+				const auto data = RandomLineGenerator::make(series_count, line_count, size.first, size.second, mSeed, mThreadCount);
+
+				LineSeriesBatch::save_to_file(mDataName, *data);
+
+				for (auto& backend : mBackends) {
+					BenchmarkResult result;
+
+					result.Case.SeriesCount = series_count;
+					result.Case.LineCount = line_count;
+					result.Case.Width = size.first;
+					result.Case.Height = size.second;
+					result.Case.Backend = backend;
+
+					run_case(result);
+
+					mResults.push_back(result);
+				}
+			}
+		}
+	}
+
+	std::remove(mDataName.c_str());
+	std::remove(mImageName.c_str());
+}
+
+void Benchmark::save(const std::string& fileName) const {
+	std::ofstream file(fileName);
+	assert(file.is_open() == true);
+
+	file << to_json();
+}
+
+auto Benchmark::to_json() const -> std::string {
+	std::ostringstream out;
+
+	out << "{" << std::endl;
+	out << "  \"threads\": " << mThreadCount << "," << std::endl;
+	out << "  \"repeat\": " << mRepeat << "," << std::endl;
+	out << "  \"seed\": " << mSeed << "," << std::endl;
+	out << "  \"cases\": [" << std::endl;
+
+	for (size_t index = 0; index < mResults.size(); index++) {
+		const auto& result = mResults[index];
+		const auto point_count = result.Case.SeriesCount * (result.Case.LineCount + 1);
+
+		std::vector<double> totals;
+		std::vector<double> density_times;
+
+		for (auto& times : result.Times) {
+			totals.push_back(sum(times));
+			density_times.push_back(
+				times[static_cast<size_t>(BenchmarkStage::Rasterize)] +
+				times[static_cast<size_t>(BenchmarkStage::Reduce)]);
+		}
+
+		const auto density_time = percentile(density_times, 0.5);
+
+		out << "    {" << std::endl;
+		out << "      \"series\": " << result.Case.SeriesCount << ", \"lines\": " << result.Case.LineCount <<
+			", \"points\": " << point_count << "," << std::endl;
+		out << "      \"width\": " << result.Case.Width << ", \"height\": " << result.Case.Height <<
+			", \"backend\": \"" << result.Case.Backend << "\"," << std::endl;
+		out << "      \"total\": ";
+
+		write_statistics(out, totals);
+
+		out << "," << std::endl << "      \"stages\": {" << std::endl;
+
+		for (size_t stage = 0; stage < BENCHMARK_STAGE_COUNT; stage++) {
+			std::vector<double> values;
+
+			for (auto& times : result.Times) values.push_back(times[stage]);
+
+			out << "        \"" << stage_name(static_cast<BenchmarkStage>(stage)) << "\": ";
+
+			write_statistics(out, values);
+
+			out << (stage + 1 == BENCHMARK_STAGE_COUNT ? "" : ",") << std::endl;
+		}
+
+		out << "      }," << std::endl;
+		out << "      \"points_per_second\": " << (density_time > 0 ? point_count / density_time : 0) << "," << std::endl;
+		out << "      \"base_memory\": " << result.BaseMemory << ", \"peak_memory\": " << result.PeakMemory << std::endl;
+		out << "    }" << (index + 1 == mResults.size() ? "" : ",") << std::endl;
+	}
+
+	out << "  ]" << std::endl;
+	out << "}" << std::endl;
+
+	return out.str();
+}
+
+auto Benchmark::is_valid() const -> bool {
+	return mValid;
+}
+
+auto Benchmark::results() const -> const std::vector<BenchmarkResult>& {
+	return mResults;
+}
+
+auto Benchmark::current_memory() -> size_t {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) == FALSE) return 0;
+
+	return static_cast<size_t>(counters.WorkingSetSize);
+#else
+	//the 2nd value is the resident pages, it is 0 if the system has no procfs
+	std::ifstream file("/proc/self/statm");
+
+	size_t size = 0;
+	size_t resident = 0;
+
+	if (!(file >> size >> resident)) return 0;
+
+	return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+auto Benchmark::stage_name(BenchmarkStage stage) -> std::string {
+	switch (stage) {
+	case BenchmarkStage::Generate: return "generate";
+	case BenchmarkStage::Parse: return "parse";
+	case BenchmarkStage::Rasterize: return "rasterize";
+	case BenchmarkStage::Reduce: return "reduce";
+	case BenchmarkStage::ColorMap: return "color_map";
+	case BenchmarkStage::Encode: return "encode";
+	default: return "unknown";
+	}
+}
+
+auto Benchmark::percentile(std::vector<double> values, double p) -> double {
+	if (values.empty() == true) return 0;
+
+	std::sort(values.begin(), values.end());
+
+	const auto position = p * static_cast<double>(values.size() - 1);
+	const auto index = static_cast<size_t>(position);
+
+	if (index + 1 >= values.size()) return values.back();
+
+	return values[index] + (values[index + 1] - values[index]) * (position - static_cast<double>(index));
+}
+
+void Benchmark::run_case(BenchmarkResult& result) {
+	const auto& benchmark_case = result.Case;
+
+	std::cout << "benchmark " << benchmark_case.SeriesCount << " line series with " << benchmark_case.LineCount <<
+		" lines to " << benchmark_case.Width << "x" << benchmark_case.Height << " heat map, backend " << benchmark_case.Backend << "." << std::endl;
+
+	//the memory of case is sampled by a thread, the peak of process lifetime would include the larger cases before it
+	std::atomic<bool> running(true);
+	std::atomic<size_t> peak_memory(current_memory());
+
+	result.BaseMemory = peak_memory;
+
+	std::thread sampler([&]()
+		{
+			while (running == true) {
+				const auto memory = current_memory();
+
+				if (memory > peak_memory) peak_memory = memory;
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(BENCHMARK_MEMORY_SAMPLE_INTERVAL));
+			}
+		});
+
+	for (size_t index = 0; index < mWarmup; index++) run_repeat(benchmark_case);
+
+	for (size_t index = 0; index < mRepeat; index++) result.Times.push_back(run_repeat(benchmark_case));
+
+	running = false;
+	sampler.join();
+
+	result.PeakMemory = peak_memory;
+
+	std::vector<double> totals;
+
+	for (auto& times : result.Times) totals.push_back(sum(times));
+
+	std::cout << "median " << percentile(totals, 0.5) << "s, p90 " << percentile(totals, 0.9) << "s." << std::endl;
+}
+
+auto Benchmark::run_repeat(const BenchmarkCase& benchmark_case) -> std::array<double, BENCHMARK_STAGE_COUNT> {
+	std::array<double, BENCHMARK_STAGE_COUNT> times = {};
+
+	const auto time = [&](BenchmarkStage stage, const std::function<void()>& function)
+	{
+		const auto start_time = time_point::now();
+
+		function();
+
+		times[static_cast<size_t>(stage)] = seconds(start_time, time_point::now());
+	};
+
+	time(BenchmarkStage::Generate, [&]()
+		{
+			RandomLineGenerator::make(benchmark_case.SeriesCount, benchmark_case.LineCount,
+				benchmark_case.Width, benchmark_case.Height, mSeed, mThreadCount);
+		});
+
+	std::vector<real> heatmap;
+
+	if (benchmark_case.Backend == "stream") {
+		StreamDensityGenerator generator(mDataName, mStreamBudget << 20, mThreadCount);
+
+		time(BenchmarkStage::Rasterize, [&]() { generator.run(); });
+
+		heatmap = generator.heatmap();
+	}
+	else {
+		std::shared_ptr<const LineSeriesBatch> data;
+
+		time(BenchmarkStage::Parse, [&]() { data = LineSeriesBatch::read_from_file(mDataName, mThreadCount); });
+
+#ifdef LINE_DENSITY_GPU
+		if (benchmark_case.Backend == "gpu") {
+			assert(mFactory != nullptr);
+
+			const auto density_generator = std::make_shared<DensityGenerator>(mFactory(), data, benchmark_case.Width, benchmark_case.Height);
+			const auto image_generator = std::make_shared<ImageGenerator>(density_generator, mColorMapped);
+
+			time(BenchmarkStage::Rasterize, [&]() { density_generator->run(); });
+			time(BenchmarkStage::ColorMap, [&]() { image_generator->run(); });
+			time(BenchmarkStage::Encode, [&]() { image_generator->save(wide_string(mImageName)); });
+
+			return times;
+		}
+#endif
+
+		CpuDensityGenerator generator(data, benchmark_case.Width, benchmark_case.Height, mThreadCount);
+
+		time(BenchmarkStage::Rasterize, [&]() { generator.rasterize(); });
+		time(BenchmarkStage::Reduce, [&]() { generator.reduce(); });
+
+		heatmap = generator.heatmap();
+	}
+
+	std::vector<uint32_t> image;
+
+	time(BenchmarkStage::ColorMap, [&]()
+		{
+			ColorLookupTable(*mColorMapped).map(heatmap, benchmark_case.Width, benchmark_case.Height, image, mThreadCount);
+		});
+
+	time(BenchmarkStage::Encode, [&]()
+		{
+			ImageWriter::save_png(mImageName, image, benchmark_case.Width, benchmark_case.Height, mThreadCount);
+		});
+
+	return times;
+}
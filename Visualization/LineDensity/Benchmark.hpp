@@ -0,0 +1,118 @@
+#pragma once
+
+#include "Common.hpp"
+#include "ColorMapped.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <array>
+
+//the device factory is only used by the gpu backend, see Common.hpp
+class Factory;
+
+#define BENCHMARK_STAGE_COUNT 6
+
+//the interval(ms) to sample the resident memory of process
+#define BENCHMARK_MEMORY_SAMPLE_INTERVAL 1
+
+//the stages of building a heat map image, the stage not used by backend is 0
+//gpu : the commands run asynchronously, so rasterize and color map only include submitting and encode waits for the device
+//stream : the file is read and rasterized together, so parse is in rasterize
+//reduce : the heat maps of threads are summed to the heat map, the density is normalized by column in rasterize
+enum class BenchmarkStage {
+	Generate = 0,
+	Parse = 1,
+	Rasterize = 2,
+	Reduce = 3,
+	ColorMap = 4,
+	Encode = 5
+};
+
+struct BenchmarkCase {
+	size_t SeriesCount = 0;
+	size_t LineCount = 0;
+	size_t Width = 0;
+	size_t Height = 0;
+
+	std::string Backend;
+};
+
+struct BenchmarkResult {
+	BenchmarkCase Case;
+
+	//the seconds of stages of each repeat
+	std::vector<std::array<double, BENCHMARK_STAGE_COUNT>> Times;
+
+	//the resident memory of process before the case and the max of it sampled during the case, bytes
+	//the memory is sampled every BENCHMARK_MEMORY_SAMPLE_INTERVAL ms while the case runs, so it is not the peak of process lifetime
+	size_t BaseMemory = 0;
+	size_t PeakMemory = 0;
+};
+
+//sweep the series count, line count, heat map size and backend, and measure the stages of each case
+//config file : each line is a key and values, the keys can be repeated
+//series n0 n1 ... : the number of line series(10000)
+//lines n0 n1 ... : the number of lines of series(1000)
+//size w h : the heat map size(200 200)
+//backend b0 b1 ... : cpu, stream or gpu(cpu)
+//repeat n : the number of measured repeats(5), warmup n : the number of repeats not measured(1)
+//format text|binary : the format of line data file that is parsed(binary), seed n : the seed of random data(0)
+//budget n : the memory budget(MB) of stream backend(64)
+class Benchmark {
+public:
+	//the factory is only used when the gpu backend is in the sweep, so the device is created only if it is needed
+	Benchmark(
+		const std::string& fileName,
+		const std::shared_ptr<ColorMapped>& colorMapped,
+		size_t thread_count = 0,
+		const std::function<Factory*()>& factory = nullptr);
+
+	//false if the config file has a bad value, the errors are printed when it is parsed
+	auto is_valid() const -> bool;
+
+	void run();
+
+	//the median, 90th percentile, min and max of total and stages, points per second and memory of each case
+	void save(const std::string& fileName) const;
+
+	auto to_json() const -> std::string;
+
+	auto results() const -> const std::vector<BenchmarkResult>&;
+
+	//the current resident memory of process, bytes
+	static auto current_memory() -> size_t;
+
+	static auto stage_name(BenchmarkStage stage) -> std::string;
+
+	//the linear interpolation of sorted values, p is in [0, 1]
+	static auto percentile(std::vector<double> values, double p) -> double;
+private:
+	void run_case(BenchmarkResult& result);
+
+	auto run_repeat(const BenchmarkCase& benchmark_case) -> std::array<double, BENCHMARK_STAGE_COUNT>;
+private:
+	std::shared_ptr<ColorMapped> mColorMapped;
+	std::function<Factory*()> mFactory;
+
+	size_t mThreadCount;
+
+	std::vector<size_t> mSeriesCounts;
+	std::vector<size_t> mLineCounts;
+	std::vector<std::pair<size_t, size_t>> mSizes;
+	std::vector<std::string> mBackends;
+
+	size_t mRepeat = 5;
+	size_t mWarmup = 1;
+	size_t mStreamBudget = 64;
+
+	uint64_t mSeed = 0;
+
+	bool mValid = true;
+
+	//the temporary files of line data and image
+	std::string mDataName;
+	std::string mImageName;
+
+	std::vector<BenchmarkResult> mResults;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+//the queue between two stages of pipeline, push is blocked when it is full
+//so the number of items in flight is bounded by the capacity
+template<typename T>
+class BoundedQueue {
+public:
+	explicit BoundedQueue(size_t capacity) : mCapacity(capacity) {}
+
+	//return false if the queue is closed, the value is dropped
+	bool push(T value);
+
+	//return false if the queue is closed and empty
+	bool pop(T& value);
+
+	//wake up the waiting threads, no more value can be pushed
+	void close();
+private:
+	std::deque<T> mQueue;
+
+	std::mutex mMutex;
+	std::condition_variable mPushCondition;
+	std::condition_variable mPopCondition;
+
+	size_t mCapacity;
+
+	bool mClosed = false;
+};
+
+template<typename T>
+bool BoundedQueue<T>::push(T value) {
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		mPushCondition.wait(lock, [this]() { return mClosed == true || mQueue.size() < mCapacity; });
+
+		if (mClosed == true) return false;
+
+		mQueue.push_back(std::move(value));
+	}
+
+	mPopCondition.notify_one();
+
+	return true;
+}
+
+template<typename T>
+bool BoundedQueue<T>::pop(T& value) {
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		mPopCondition.wait(lock, [this]() { return mClosed == true || mQueue.empty() == false; });
+
+		if (mQueue.empty() == true) return false;
+
+		value = std::move(mQueue.front());
+
+		mQueue.pop_front();
+	}
+
+	mPushCondition.notify_one();
+
+	return true;
+}
+
+template<typename T>
+void BoundedQueue<T>::close() {
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		mClosed = true;
+	}
+
+	mPushCondition.notify_all();
+	mPopCondition.notify_all();
+}
@@ -0,0 +1,281 @@
+#include "CategoryDensityGenerator.hpp"
+#include "ColorLookupTable.hpp"
+#include "LineBinaryFile.hpp"
+#include "LineRasterizer.hpp"
+#include "ImageWriter.hpp"
+
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#undef max
+#undef min
+
+CategoryDensityGenerator::CategoryDensityGenerator(
+	const std::shared_ptr<const LineSeriesBatch>& line_series,
+	size_t heatmap_width, size_t heatmap_height,
+	size_t thread_count,
+	size_t max_category_count,
+	DensityKernelType kernel_type) :
+	mLineSeries(line_series),
+	mWidth(heatmap_width), mHeight(heatmap_height),
+	mWordCount(DensityKernel::word_count(heatmap_height)),
+	mTileCount((heatmap_width + CATEGORY_DENSITY_TILE_SIZE - 1) / CATEGORY_DENSITY_TILE_SIZE),
+	mColumnHeight(mWordCount * DENSITY_KERNEL_WORD_BITS),
+	mMaxCategoryCount(max_category_count),
+	mThreadPool(thread_count), mKernel(kernel_type) {
+
+	//the series with the same RGBA8 color are in the same category
+	std::unordered_map<uint32_t, uint32_t> categories;
+
+	mCategories.resize(mLineSeries->size());
+
+	for (size_t index = 0; index < mLineSeries->size(); index++) {
+		const auto color = LineBinaryFile::pack_color(mLineSeries->colors()[index]);
+		const auto result = categories.insert({ color, static_cast<uint32_t>(mColors.size()) });
+
+		if (result.second == true) mColors.push_back(color);
+
+		//the tiles of K categories are K times of the tiles of heat map, stop at the first category over the limit
+		if (is_valid() == false) return;
+
+		mCategories[index] = result.first->second;
+	}
+
+	mScratches.resize(mThreadPool.size());
+}
+
+auto CategoryDensityGenerator::is_valid() const -> bool {
+	return mColors.size() <= mMaxCategoryCount;
+}
+
+void CategoryDensityGenerator::run() {
+	assert(is_valid() == true);
+
+	for (auto& scratch : mScratches) {
+		scratch.Bits.assign(mWidth * mWordCount, 0);
+		scratch.Touched.assign(mWidth, 0);
+		scratch.Tiles.clear();
+		scratch.Tiles.resize(mColors.size() * mTileCount);
+	}
+
+	//each part of series accumulates into its own tiles, see CpuDensityGenerator
+	const auto part_count = mScratches.size();
+
+	mThreadPool.parallel_for(part_count, [&](size_t, size_t part)
+		{
+			const auto series_end = mLineSeries->split(0, mLineSeries->size(), part + 1, part_count);
+
+			for (auto index = mLineSeries->split(0, mLineSeries->size(), part, part_count); index < series_end; index++)
+				run_line_series(index, mScratches[part]);
+		});
+
+	reduce();
+
+	for (auto& scratch : mScratches) {
+		scratch.Bits = std::vector<uint64_t>();
+		scratch.Tiles = std::vector<std::vector<real>>();
+	}
+}
+
+void CategoryDensityGenerator::save(const std::string& prefix, const ColorMapped& colorMapped) {
+	std::ofstream manifest(prefix + ".txt");
+	assert(manifest.is_open() == true);
+
+	manifest << mColors.size() << std::endl;
+
+	const ColorLookupTable table(colorMapped);
+
+	std::vector<uint32_t> image;
+
+	for (size_t category = 0; category < mColors.size(); category++) {
+		const auto channel = heatmap(category);
+		const auto color = mColors[category];
+
+		manifest <<
+			((color >> 0) & 0xFF) << " " << ((color >> 8) & 0xFF) << " " <<
+			((color >> 16) & 0xFF) << " " << ((color >> 24) & 0xFF) << " " <<
+			*std::max_element(channel.begin(), channel.end()) << std::endl;
+
+		table.map(channel, mWidth, mHeight, image, mThreadPool.size());
+
+		ImageWriter::save_png(prefix + "_" + std::to_string(category) + ".png", image, mWidth, mHeight, mThreadPool.size());
+	}
+}
+
+void CategoryDensityGenerator::save_blended(const std::string& fileName) {
+	ImageWriter::save(fileName, blend(), mWidth, mHeight, mThreadPool.size());
+}
+
+auto CategoryDensityGenerator::blend() -> std::vector<uint32_t> {
+	const auto pixel_count = mWidth * mHeight;
+
+	std::vector<real> totals(pixel_count, 0);
+
+	mThreadPool.parallel_for(mHeight, [&](size_t, size_t row)
+		{
+			for (size_t category = 0; category < mColors.size(); category++) add_row(category, row, &totals[row * mWidth]);
+		});
+
+	const auto max_total = totals.empty() == true ? static_cast<real>(0) : *std::max_element(totals.begin(), totals.end());
+
+	std::vector<vec4> colors(mColors.size());
+
+	for (size_t category = 0; category < mColors.size(); category++)
+		colors[category] = LineBinaryFile::unpack_color(mColors[category]);
+
+	std::vector<uint32_t> image(pixel_count);
+
+	mThreadPool.parallel_for(mHeight, [&](size_t, size_t row)
+		{
+			//the weighted colors of row, the tiles of categories are visited by row, so no dense heat map of category is built
+			std::vector<vec4> row_colors(mWidth, vec4(0));
+
+			for (size_t category = 0; category < mColors.size(); category++) {
+				for (size_t tile = 0; tile < mTileCount; tile++) {
+					const auto& source = mTiles[category * mTileCount + tile];
+
+					if (source.empty() == true) continue;
+
+					const auto column_begin = tile * CATEGORY_DENSITY_TILE_SIZE;
+					const auto column_end = std::min(column_begin + CATEGORY_DENSITY_TILE_SIZE, mWidth);
+
+					for (auto column = column_begin; column < column_end; column++)
+						row_colors[column] += colors[category] * source[(column - column_begin) * mColumnHeight + row];
+				}
+			}
+
+			for (size_t column = 0; column < mWidth; column++) {
+				const auto index = row * mWidth + column;
+
+				if (totals[index] == 0) { image[index] = 0xFFFFFFFF; continue; }
+
+				//the log scale keeps the sparse pixels visible when a few pixels are very dense
+				const auto factor = std::log1p(totals[index]) / std::log1p(max_total);
+
+				auto color = row_colors[column] / totals[index] * factor + vec4(1) * (1 - factor);
+				color.a = 1;
+
+				image[index] = LineBinaryFile::pack_color(color);
+			}
+		});
+
+	return image;
+}
+
+auto CategoryDensityGenerator::data() const -> const std::shared_ptr<const LineSeriesBatch>& {
+	return mLineSeries;
+}
+
+auto CategoryDensityGenerator::heatmap(size_t category) const -> std::vector<real> {
+	std::vector<real> heatmap(mWidth * mHeight, 0);
+
+	for (size_t row = 0; row < mHeight; row++) add_row(category, row, &heatmap[row * mWidth]);
+
+	return heatmap;
+}
+
+auto CategoryDensityGenerator::density(size_t category, size_t column, size_t row) const -> real {
+	const auto& tile = mTiles[category * mTileCount + column / CATEGORY_DENSITY_TILE_SIZE];
+
+	return tile.empty() == true ? static_cast<real>(0) : tile[(column % CATEGORY_DENSITY_TILE_SIZE) * mColumnHeight + row];
+}
+
+auto CategoryDensityGenerator::color(size_t category) const -> vec4 {
+	return LineBinaryFile::unpack_color(mColors[category]);
+}
+
+auto CategoryDensityGenerator::category(size_t series) const -> size_t {
+	return mCategories[series];
+}
+
+auto CategoryDensityGenerator::category_count() const -> size_t {
+	return mColors.size();
+}
+
+auto CategoryDensityGenerator::width() const -> size_t {
+	return mWidth;
+}
+
+auto CategoryDensityGenerator::height() const -> size_t {
+	return mHeight;
+}
+
+auto CategoryDensityGenerator::kernel() const -> DensityKernelType {
+	return mKernel.type();
+}
+
+void CategoryDensityGenerator::run_line_series(size_t series, Scratch& scratch) const {
+	const auto line_series = (*mLineSeries)[series];
+
+	assert(line_series.size() >= 1);
+
+	const auto word_count = mWordCount;
+	const auto column_height = mColumnHeight;
+
+	//draw pass, the same as CpuDensityGenerator
+	LineRasterizer::rasterize(line_series.data(), line_series.size() + 1, mWidth, mHeight,
+		[&](size_t column, size_t row_begin, size_t row_end)
+		{
+			DensityKernel::mark(&scratch.Bits[column * word_count], row_begin, row_end);
+
+			if (scratch.Touched[column] != 0) return;
+
+			scratch.Touched[column] = 1;
+			scratch.Columns.push_back(column);
+		});
+
+	//merge pass, the marks are added to the tiles of category
+	const auto tiles = &scratch.Tiles[mCategories[series] * mTileCount];
+
+	for (auto column : scratch.Columns) {
+		auto& tile = tiles[column / CATEGORY_DENSITY_TILE_SIZE];
+
+		if (tile.empty() == true) tile.resize(CATEGORY_DENSITY_TILE_SIZE * column_height, 0);
+
+		mKernel.merge(&scratch.Bits[column * word_count], word_count, &tile[(column % CATEGORY_DENSITY_TILE_SIZE) * column_height]);
+
+		scratch.Touched[column] = 0;
+	}
+
+	scratch.Columns.clear();
+}
+
+void CategoryDensityGenerator::reduce() {
+	mTiles.clear();
+	mTiles.resize(mColors.size() * mTileCount);
+
+	//sum the tiles of parts in the order of parts, each tile of category is a task
+	//the first touched tile of parts is moved to the result, so the result only has the touched tiles
+	mThreadPool.parallel_for(mTiles.size(), [&](size_t, size_t index)
+		{
+			auto& target = mTiles[index];
+
+			for (auto& scratch : mScratches) {
+				auto& source = scratch.Tiles[index];
+
+				if (source.empty() == true) continue;
+
+				if (target.empty() == true) { target = std::move(source); continue; }
+
+				for (size_t pixel = 0; pixel < target.size(); pixel++) target[pixel] += source[pixel];
+
+				source = std::vector<real>();
+			}
+		});
+}
+
+void CategoryDensityGenerator::add_row(size_t category, size_t row, real* target) const {
+	for (size_t tile = 0; tile < mTileCount; tile++) {
+		const auto& source = mTiles[category * mTileCount + tile];
+
+		if (source.empty() == true) continue;
+
+		const auto column_begin = tile * CATEGORY_DENSITY_TILE_SIZE;
+		const auto column_end = std::min(column_begin + CATEGORY_DENSITY_TILE_SIZE, mWidth);
+
+		for (auto column = column_begin; column < column_end; column++)
+			target[column] += source[(column - column_begin) * mColumnHeight + row];
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Common.hpp"
+#include "LineSeriesBatch.hpp"
+#include "DensityKernel.hpp"
+#include "ThreadPool.hpp"
+#include "ColorMapped.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#define CATEGORY_DENSITY_TILE_SIZE 16
+
+//the default max number of categories, each category has its own heat map and the tiles of it are allocated per thread
+#define CATEGORY_DENSITY_MAX_CATEGORY_COUNT 256
+
+//build one heat map per category with one pass, the category of series is its color(RGBA8)
+//each series is rasterized once and adds 1 / count to the pixels it marks in the channel of its category(see CpuDensityGenerator)
+//the channels of parts(one continuous part of series per thread) and the result are sparse, a tile(CATEGORY_DENSITY_TILE_SIZE columns) is allocated when a series of the category touches it
+//the data with more categories than max_category_count is rejected, see is_valid
+class CategoryDensityGenerator {
+public:
+	CategoryDensityGenerator(
+		const std::shared_ptr<const LineSeriesBatch>& line_series,
+		size_t heatmap_width, size_t heatmap_height,
+		size_t thread_count = 0,
+		size_t max_category_count = CATEGORY_DENSITY_MAX_CATEGORY_COUNT,
+		DensityKernelType kernel_type = DensityKernel::detect());
+
+	//the number of categories is not greater than max_category_count
+	auto is_valid() const -> bool;
+
+	void run();
+
+	//save the heat map of category k to prefix_k.png with color mapped, and the categories to prefix.txt
+	//prefix.txt : 1st line is the number of categories, the next lines are the RGBA8 color and max density of categories
+	void save(const std::string& prefix, const ColorMapped& colorMapped);
+
+	//save one image that blends the colors of categories by their densities, see blend
+	void save_blended(const std::string& fileName);
+
+	//the weighted average of category colors, it is mixed with white by log(1 + total density) / log(1 + max total density)
+	auto blend() -> std::vector<uint32_t>;
+
+	auto data() const -> const std::shared_ptr<const LineSeriesBatch>&;
+
+	//the row major heat map of category, it is built from the tiles, so only one category is dense at a time
+	auto heatmap(size_t category) const -> std::vector<real>;
+
+	//the density of pixel in the heat map of category
+	auto density(size_t category, size_t column, size_t row) const -> real;
+
+	//the color of category, the categories are ordered by the first series of them
+	auto color(size_t category) const -> vec4;
+
+	//the category of series
+	auto category(size_t series) const -> size_t;
+
+	auto category_count()const -> size_t;
+
+	auto width()const -> size_t;
+
+	auto height()const -> size_t;
+
+	auto kernel()const -> DensityKernelType;
+private:
+	struct Scratch {
+		std::vector<uint64_t> Bits;
+		std::vector<byte> Touched;
+		std::vector<size_t> Columns;
+
+		//the tiles of categories, tile t of category k is Tiles[k * tile count + t], column major
+		std::vector<std::vector<real>> Tiles;
+	};
+
+	void run_line_series(size_t series, Scratch& scratch) const;
+
+	void reduce();
+
+	//add the heat map of category in row to target(width values)
+	void add_row(size_t category, size_t row, real* target) const;
+private:
+	std::shared_ptr<const LineSeriesBatch> mLineSeries;
+
+	size_t mWidth;
+	size_t mHeight;
+
+	size_t mWordCount;
+	size_t mTileCount;
+	size_t mColumnHeight;
+	size_t mMaxCategoryCount;
+
+	ThreadPool mThreadPool;
+	DensityKernel mKernel;
+
+	std::vector<uint32_t> mCategories;
+	std::vector<uint32_t> mColors;
+
+	std::vector<Scratch> mScratches;
+
+	//the tiles of categories, the same layout as Scratch::Tiles, the untouched tiles are empty
+	std::vector<std::vector<real>> mTiles;
+};
@@ -0,0 +1,54 @@
+#include "ColorLookupTable.hpp"
+#include "LineBinaryFile.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+#undef max
+#undef min
+
+ColorLookupTable::ColorLookupTable(const ColorMapped& colorMapped, size_t size) {
+	const auto colors = colorMapped.colors();
+	const auto space = colorMapped.space();
+
+	assert(colors.empty() == false && size != 0);
+
+	mMaxDensity = space * static_cast<real>(colors.size() - 1);
+	mMaxColor = LineBinaryFile::pack_color(colors.back());
+	mScale = mMaxDensity > 0 ? static_cast<real>(size) / mMaxDensity : 0;
+
+	mTable.resize(size, mMaxColor);
+
+	//only one color or no space, all densities are mapped to the last color
+	if (colors.size() < 2 || mMaxDensity <= 0) return;
+
+	//the entry is the color at the center of its density range
+	for (size_t index = 0; index < size; index++) {
+		const auto density = (static_cast<real>(index) + 0.5f) / static_cast<real>(size) * mMaxDensity;
+		const auto mapped_index = std::min(static_cast<size_t>(density / space), colors.size() - 2);
+		const auto factor = std::clamp((density - mapped_index * space) / space, 0.0f, 1.0f);
+
+		mTable[index] = LineBinaryFile::pack_color(glm::mix(colors[mapped_index], colors[mapped_index + 1], factor));
+	}
+}
+
+void ColorLookupTable::map(const std::vector<real>& heatmap, size_t width, size_t height,
+	std::vector<uint32_t>& image, size_t thread_count) const {
+	assert(heatmap.size() == width * height);
+
+	image.resize(width * height);
+
+	ThreadPool thread_pool(thread_count);
+
+	thread_pool.parallel_for(height, [&](size_t, size_t row)
+		{
+			const auto source = &heatmap[row * width];
+			const auto target = &image[row * width];
+
+			for (size_t column = 0; column < width; column++) target[column] = map(source[column]);
+		});
+}
+
+auto ColorLookupTable::size() const -> size_t {
+	return mTable.size();
+}
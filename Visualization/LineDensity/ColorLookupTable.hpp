@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Common.hpp"
+#include "ColorMapped.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#undef max
+#undef min
+
+#define COLOR_LOOKUP_TABLE_SIZE 4096
+
+//the CPU version of color mapped in ImageGeneratorPixel.hlsl
+//the colors of densities in [0, space * (count - 1)) are precomputed, so mapping a pixel is a clamp and an index
+//the color is RGBA8(r is the lowest byte), the pixel without density is white
+class ColorLookupTable {
+public:
+	explicit ColorLookupTable(const ColorMapped& colorMapped, size_t size = COLOR_LOOKUP_TABLE_SIZE);
+
+	auto map(real density) const -> uint32_t;
+
+	//map the row major heat map to the row major image, each row is a task
+	void map(const std::vector<real>& heatmap, size_t width, size_t height,
+		std::vector<uint32_t>& image, size_t thread_count = 0) const;
+
+	auto size() const -> size_t;
+private:
+	std::vector<uint32_t> mTable;
+
+	//the color of density that is not less than max density
+	uint32_t mMaxColor;
+
+	real mMaxDensity;
+	real mScale;
+};
+
+inline auto ColorLookupTable::map(real density) const -> uint32_t {
+	if (density == 0) return 0xFFFFFFFF;
+	if (density >= mMaxDensity) return mMaxColor;
+
+	//the negative density is mapped to the first color as the shader does
+	const auto index = static_cast<size_t>(std::max(density * mScale, static_cast<real>(0)));
+
+	return mTable[std::min(index, mTable.size() - 1)];
+}
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "Utility.hpp"
+#include "Common.hpp"
 
 #include <map>
 #include <set>
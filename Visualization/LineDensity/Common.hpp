@@ -0,0 +1,34 @@
+#pragma once
+
+//the types shared by the CPU and device code, it does not depend on the device framework, so the CPU code builds on any platform
+//the device code includes Utility.hpp
+
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+//the device backends(Direct3D 11) are only built on Windows, the CPU backends are built on any platform
+//define LINE_DENSITY_CPU_ONLY to build the CPU backends only on Windows too, see CMakeLists.txt
+#if defined(_WIN32) && !defined(LINE_DENSITY_CPU_ONLY)
+#define LINE_DENSITY_GPU
+#endif
+
+using real = float;
+using vec2 = glm::vec<2, real, glm::defaultp>;
+using vec3 = glm::vec<3, real, glm::defaultp>;
+using vec4 = glm::vec<4, real, glm::defaultp>;
+using mat4 = glm::mat<4, 4, real, glm::defaultp>;
+using byte = unsigned char;
+
+//the binary files(line binary, line archive and tiled heat map) are little endian, the readers and writers reject the other hosts
+inline auto is_little_endian() -> bool {
+	const uint32_t value = 1;
+
+	return *reinterpret_cast<const unsigned char*>(&value) == 1;
+}
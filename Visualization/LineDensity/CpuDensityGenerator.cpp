@@ -0,0 +1,128 @@
+#include "CpuDensityGenerator.hpp"
+#include "LineRasterizer.hpp"
+#include "LineDecimator.hpp"
+
+#include <algorithm>
+
+CpuDensityGenerator::CpuDensityGenerator(
+	const std::shared_ptr<const LineSeriesBatch>& line_series,
+	size_t heatmap_width, size_t heatmap_height,
+	size_t thread_count,
+	bool decimation,
+	DensityKernelType kernel_type) :
+	mLineSeries(line_series),
+	mWidth(heatmap_width), mHeight(heatmap_height),
+	mWordCount(DensityKernel::word_count(heatmap_height)),
+	mDecimation(decimation),
+	mThreadPool(thread_count), mKernel(kernel_type) {
+
+	mScratches.resize(mThreadPool.size());
+	mHeatMap.resize(mWidth * mHeight, 0);
+}
+
+void CpuDensityGenerator::run() {
+	rasterize();
+	reduce();
+}
+
+void CpuDensityGenerator::rasterize() {
+	for (auto& scratch : mScratches) {
+		scratch.Bits.assign(mWidth * mWordCount, 0);
+		scratch.Touched.assign(mWidth, 0);
+		scratch.HeatMap.assign(mWidth * mWordCount * DENSITY_KERNEL_WORD_BITS, 0);
+	}
+
+	//each part of series accumulates into its own heat map, so no atomic is needed
+	//the parts do not depend on the schedule and they are summed in order, so the heat map is the same for the same thread count
+	const auto part_count = mScratches.size();
+
+	mThreadPool.parallel_for(part_count, [&](size_t, size_t part)
+		{
+			const auto series_end = mLineSeries->split(0, mLineSeries->size(), part + 1, part_count);
+
+			for (auto index = mLineSeries->split(0, mLineSeries->size(), part, part_count); index < series_end; index++)
+				run_line_series((*mLineSeries)[index], mScratches[part]);
+		});
+}
+
+auto CpuDensityGenerator::data() const -> const std::shared_ptr<const LineSeriesBatch>& {
+	return mLineSeries;
+}
+
+auto CpuDensityGenerator::heatmap() const -> const std::vector<real>& {
+	return mHeatMap;
+}
+
+auto CpuDensityGenerator::width() const -> size_t {
+	return mWidth;
+}
+
+auto CpuDensityGenerator::height() const -> size_t {
+	return mHeight;
+}
+
+auto CpuDensityGenerator::kernel() const -> DensityKernelType {
+	return mKernel.type();
+}
+
+void CpuDensityGenerator::run_line_series(const LineSeriesView& line_series, Scratch& scratch) const {
+	assert(line_series.size() >= 1);
+
+	const auto word_count = mWordCount;
+
+	auto points = line_series.data();
+	auto point_count = line_series.size() + 1;
+
+	//the series is denser than the heat map, most of points mark the same pixels
+	if (mDecimation == true && point_count > mWidth * 4 &&
+		LineDecimator::m4(points, point_count, scratch.Points) == true) {
+		points = scratch.Points.data();
+		point_count = scratch.Points.size();
+	}
+
+	//draw pass, mark the pixels in the bitsets of columns
+	LineRasterizer::rasterize(points, point_count, mWidth, mHeight,
+		[&](size_t column, size_t row_begin, size_t row_end)
+		{
+			DensityKernel::mark(&scratch.Bits[column * word_count], row_begin, row_end);
+
+			if (scratch.Touched[column] != 0) return;
+
+			scratch.Touched[column] = 1;
+			scratch.Columns.push_back(column);
+		});
+
+	//merge pass, only the touched columns are visited
+	const auto column_height = word_count * DENSITY_KERNEL_WORD_BITS;
+
+	for (auto column : scratch.Columns) {
+		mKernel.merge(&scratch.Bits[column * word_count], word_count, &scratch.HeatMap[column * column_height]);
+
+		scratch.Touched[column] = 0;
+	}
+
+	scratch.Columns.clear();
+}
+
+void CpuDensityGenerator::reduce() {
+	const auto column_height = mWordCount * DENSITY_KERNEL_WORD_BITS;
+
+	//sum the column major heat maps of parts into the row major heat map, each row is a task
+	mThreadPool.parallel_for(mHeight, [&](size_t, size_t row)
+		{
+			const auto target = &mHeatMap[row * mWidth];
+
+			std::fill(target, target + mWidth, static_cast<real>(0));
+
+			for (auto& scratch : mScratches) {
+				for (size_t column = 0; column < mWidth; column++)
+					target[column] += scratch.HeatMap[column * column_height + row];
+			}
+		});
+
+	for (auto& scratch : mScratches) {
+		scratch.Bits = std::vector<uint64_t>();
+		scratch.HeatMap = std::vector<real>();
+		scratch.Points = std::vector<vec2>();
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Common.hpp"
+#include "LineSeriesBatch.hpp"
+#include "DensityKernel.hpp"
+#include "ThreadPool.hpp"
+
+//the CPU version of DensityGenerator, no device is needed
+//each line series adds 1 / count to the pixels it marks, count is the number of marked pixels in the column
+//if decimation is enabled, the x-monotone series are decimated by LineDecimator::m4 first, the heat map is same
+class CpuDensityGenerator {
+public:
+	CpuDensityGenerator(
+		const std::shared_ptr<const LineSeriesBatch>& line_series,
+		size_t heatmap_width, size_t heatmap_height,
+		size_t thread_count = 0,
+		bool decimation = false,
+		DensityKernelType kernel_type = DensityKernel::detect());
+
+	void run();
+
+	//rasterize the series into the heat maps of parts, the series are split into one continuous part per thread
+	void rasterize();
+
+	//sum the heat maps of parts into the heat map in the order of parts and release them
+	void reduce();
+
+	auto data() const -> const std::shared_ptr<const LineSeriesBatch>&;
+
+	//row major, the same layout as the heat map texture
+	auto heatmap() const -> const std::vector<real>&;
+
+	auto width()const -> size_t;
+
+	auto height()const -> size_t;
+
+	auto kernel()const -> DensityKernelType;
+private:
+	//the marks of one line series, it is reused by the series of the same part
+	struct Scratch {
+		std::vector<uint64_t> Bits; //column major bitsets, see DensityKernel
+		std::vector<byte> Touched;
+		std::vector<size_t> Columns;
+		std::vector<vec2> Points; //the decimated series
+
+		std::vector<real> HeatMap; //column major, each column has mWordCount * DENSITY_KERNEL_WORD_BITS rows
+	};
+
+	void run_line_series(const LineSeriesView& line_series, Scratch& scratch) const;
+private:
+	std::shared_ptr<const LineSeriesBatch> mLineSeries;
+
+	size_t mWidth;
+	size_t mHeight;
+
+	size_t mWordCount;
+
+	bool mDecimation;
+
+	ThreadPool mThreadPool;
+	DensityKernel mKernel;
+
+	std::vector<Scratch> mScratches;
+	std::vector<real> mHeatMap;
+};
@@ -0,0 +1,282 @@
+#include "CpuSharpGenerator.hpp"
+#include "LineBinaryFile.hpp"
+#include "ImageWriter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#undef max
+#undef min
+
+//the segments out of the band are clipped first, so the subpixels and edge functions do not overflow
+#define CPU_SHARP_GUARD_BAND 1048576.0f
+
+namespace {
+
+	//clip the segment to the box, return false if it is outside(Liang-Barsky)
+	bool clip_segment(vec2& start, vec2& end, vec2 box_min, vec2 box_max) {
+		const auto vector = end - start;
+
+		real begin = 0, finish = 1;
+
+		for (int axis = 0; axis < 2; axis++) {
+			if (vector[axis] == 0) {
+				if (start[axis] < box_min[axis] || start[axis] > box_max[axis]) return false;
+
+				continue;
+			}
+
+			auto t0 = (box_min[axis] - start[axis]) / vector[axis];
+			auto t1 = (box_max[axis] - start[axis]) / vector[axis];
+
+			if (t0 > t1) std::swap(t0, t1);
+
+			begin = std::max(begin, t0);
+			finish = std::min(finish, t1);
+
+			if (begin > finish) return false;
+		}
+
+		end = start + vector * finish;
+		start = start + vector * begin;
+
+		return true;
+	}
+
+	auto to_subpixel(real value) -> int32_t {
+		return static_cast<int32_t>(std::lround(value * (1 << CPU_SHARP_SUBPIXEL_BITS)));
+	}
+
+	auto floor_divide(int64_t value, int64_t divisor) -> int64_t {
+		return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+	}
+
+	//the first pixel whose center is not less than value(in subpixels)
+	auto pixel_begin(int64_t value) -> int64_t {
+		const int64_t size = 1 << CPU_SHARP_SUBPIXEL_BITS;
+
+		return floor_divide(value - size / 2 + size - 1, size);
+	}
+
+	//the last pixel whose center is not greater than value(in subpixels)
+	auto pixel_end(int64_t value) -> int64_t {
+		const int64_t size = 1 << CPU_SHARP_SUBPIXEL_BITS;
+
+		return floor_divide(value - size / 2, size);
+	}
+}
+
+CpuSharpGenerator::CpuSharpGenerator(
+	const std::shared_ptr<const LineSeriesBatch>& line_series,
+	size_t w, size_t h,
+	size_t thread_count) :
+	mLineSeries(line_series),
+	mWidth(w), mHeight(h),
+	mTileColumns((w + CPU_SHARP_TILE_SIZE - 1) / CPU_SHARP_TILE_SIZE),
+	mTileRows((h + CPU_SHARP_TILE_SIZE - 1) / CPU_SHARP_TILE_SIZE),
+	mThreadPool(thread_count) {
+
+	mImage.resize(mWidth * mHeight, 0xFFFFFFFF);
+}
+
+void CpuSharpGenerator::run(real width) {
+	const auto& line_series = *mLineSeries;
+
+	//split the series into tasks with the same number of points
+	const auto task_count = std::min(mThreadPool.size() * 4, std::max(line_series.size(), static_cast<size_t>(1)));
+	const auto task_points = line_series.point_count() / task_count + 1;
+
+	mTasks.clear();
+	mTasks.emplace_back();
+
+	for (size_t index = 0; index < line_series.size(); index++) {
+		if (mTasks.back().End - mTasks.back().Begin != 0 &&
+			line_series.offsets()[index] - line_series.offsets()[mTasks.back().Begin] >= task_points) {
+			mTasks.emplace_back();
+			mTasks.back().Begin = index;
+		}
+
+		mTasks.back().End = index + 1;
+	}
+
+	mColors.resize(line_series.size());
+
+	for (size_t index = 0; index < line_series.size(); index++)
+		mColors[index] = LineBinaryFile::pack_color(line_series.colors()[index]);
+
+	const auto scale = vec2(
+		mWidth / static_cast<float>(line_series.width()),
+		mHeight / static_cast<float>(line_series.height()));
+
+	//bin pass, each task bins its quads into its own bins
+	mThreadPool.parallel_for(mTasks.size(), [&](size_t, size_t index) { bin_task(mTasks[index], scale, width); });
+
+	std::fill(mImage.begin(), mImage.end(), 0xFFFFFFFF);
+
+	//raster pass, the tiles are disjoint so each tile is a task
+	mThreadPool.parallel_for(mTileColumns * mTileRows, [&](size_t, size_t tile) { rasterize_tile(tile); });
+
+	mTasks.clear();
+}
+
+void CpuSharpGenerator::save(const std::string& fileName) {
+	ImageWriter::save(fileName, mImage, mWidth, mHeight, mThreadPool.size());
+}
+
+auto CpuSharpGenerator::image() const -> const std::vector<uint32_t>& {
+	return mImage;
+}
+
+auto CpuSharpGenerator::width() const -> size_t {
+	return mWidth;
+}
+
+auto CpuSharpGenerator::height() const -> size_t {
+	return mHeight;
+}
+
+void CpuSharpGenerator::bin_task(Task& task, vec2 scale, real width) {
+	task.Bins.resize(mTileColumns * mTileRows);
+
+	const auto half_width = width * 0.5f;
+
+	//the segment is culled if its quad can not cover any pixel center
+	const auto margin = half_width + 1.0f;
+	const auto box_min = vec2(-margin, -margin);
+	const auto box_max = vec2(mWidth + margin, mHeight + margin);
+
+	for (auto series = task.Begin; series < task.End; series++) {
+		const auto lines = (*mLineSeries)[series];
+		const auto points = lines.data();
+
+		for (size_t index = 0; index < lines.size(); index++) {
+			auto start = points[index] * scale;
+			auto end = points[index + 1] * scale;
+
+			if (std::max(start.x, end.x) < box_min.x || std::min(start.x, end.x) > box_max.x ||
+				std::max(start.y, end.y) < box_min.y || std::min(start.y, end.y) > box_max.y) continue;
+
+			//the far segment is clipped, the part out of box does not cover the image
+			if (std::max({ std::abs(start.x), std::abs(start.y), std::abs(end.x), std::abs(end.y) }) > CPU_SHARP_GUARD_BAND &&
+				clip_segment(start, end, box_min, box_max) == false) continue;
+
+			const auto vector = end - start;
+			const auto length = glm::length(vector);
+
+			//the quad of zero length segment has no area
+			if (length == 0 || width <= 0) continue;
+
+			//the same quad as LineSeries::segment_transform, the corners are start -/+ normal and end +/- normal
+			const auto normal = vec2(-vector.y, vector.x) * (half_width / length);
+			const vec2 corners[4] = { start - normal, start + normal, end + normal, end - normal };
+
+			Quad quad;
+
+			for (int corner = 0; corner < 4; corner++) {
+				quad.X[corner] = to_subpixel(corners[corner].x);
+				quad.Y[corner] = to_subpixel(corners[corner].y);
+			}
+
+			//make the corners counterclockwise(the interior is on the left of edges), skip the quad without area
+			int64_t area = 0;
+
+			for (int corner = 0; corner < 4; corner++) {
+				const auto next = (corner + 1) & 3;
+
+				area += static_cast<int64_t>(quad.X[corner]) * quad.Y[next] - static_cast<int64_t>(quad.X[next]) * quad.Y[corner];
+			}
+
+			if (area == 0) continue;
+
+			if (area < 0) {
+				std::swap(quad.X[1], quad.X[3]);
+				std::swap(quad.Y[1], quad.Y[3]);
+			}
+
+			const auto min_x = *std::min_element(quad.X, quad.X + 4);
+			const auto max_x = *std::max_element(quad.X, quad.X + 4);
+			const auto min_y = *std::min_element(quad.Y, quad.Y + 4);
+			const auto max_y = *std::max_element(quad.Y, quad.Y + 4);
+
+			const auto column_begin = std::max(pixel_begin(min_x), static_cast<int64_t>(0));
+			const auto column_end = std::min(pixel_end(max_x), static_cast<int64_t>(mWidth) - 1);
+			const auto row_begin = std::max(pixel_begin(min_y), static_cast<int64_t>(0));
+			const auto row_end = std::min(pixel_end(max_y), static_cast<int64_t>(mHeight) - 1);
+
+			if (column_begin > column_end || row_begin > row_end) continue;
+
+			quad.Box[0] = static_cast<int32_t>(column_begin);
+			quad.Box[1] = static_cast<int32_t>(row_begin);
+			quad.Box[2] = static_cast<int32_t>(column_end);
+			quad.Box[3] = static_cast<int32_t>(row_end);
+			quad.Series = static_cast<uint32_t>(series);
+
+			const auto quad_index = static_cast<uint32_t>(task.Quads.size());
+
+			task.Quads.push_back(quad);
+
+			for (auto row = row_begin / CPU_SHARP_TILE_SIZE; row <= row_end / CPU_SHARP_TILE_SIZE; row++) {
+				for (auto column = column_begin / CPU_SHARP_TILE_SIZE; column <= column_end / CPU_SHARP_TILE_SIZE; column++)
+					task.Bins[row * mTileColumns + column].push_back(quad_index);
+			}
+		}
+	}
+}
+
+void CpuSharpGenerator::rasterize_tile(size_t tile) {
+	const int64_t subpixel = 1 << CPU_SHARP_SUBPIXEL_BITS;
+
+	const auto tile_column = static_cast<int64_t>(tile % mTileColumns) * CPU_SHARP_TILE_SIZE;
+	const auto tile_row = static_cast<int64_t>(tile / mTileColumns) * CPU_SHARP_TILE_SIZE;
+
+	//the tasks are in series order and the quads of task are in draw order
+	for (const auto& task : mTasks) {
+		for (const auto quad_index : task.Bins[tile]) {
+			const auto& quad = task.Quads[quad_index];
+
+			const auto column_begin = std::max(static_cast<int64_t>(quad.Box[0]), tile_column);
+			const auto row_begin = std::max(static_cast<int64_t>(quad.Box[1]), tile_row);
+			const auto column_end = std::min(static_cast<int64_t>(quad.Box[2]), tile_column + CPU_SHARP_TILE_SIZE - 1);
+			const auto row_end = std::min(static_cast<int64_t>(quad.Box[3]), tile_row + CPU_SHARP_TILE_SIZE - 1);
+
+			//the edge function is a * x + b * y + c, the pixel is covered if all of them are not negative
+			//the bias makes the pixel on edge covered only if the edge is top or left
+			int64_t a[4], b[4], e[4];
+
+			for (int edge = 0; edge < 4; edge++) {
+				const auto next = (edge + 1) & 3;
+
+				a[edge] = static_cast<int64_t>(quad.Y[edge]) - quad.Y[next];
+				b[edge] = static_cast<int64_t>(quad.X[next]) - quad.X[edge];
+
+				const auto bias = (a[edge] > 0 || (a[edge] == 0 && b[edge] > 0)) ? 0 : -1;
+				const auto x = column_begin * subpixel + subpixel / 2 - quad.X[edge];
+				const auto y = row_begin * subpixel + subpixel / 2 - quad.Y[edge];
+
+				e[edge] = a[edge] * x + b[edge] * y + bias;
+			}
+
+			const auto color = mColors[quad.Series];
+
+			for (auto row = row_begin; row <= row_end; row++) {
+				//the covered pixels of row are a span, each edge limits one side of it
+				auto begin = column_begin;
+				auto end = column_end;
+
+				for (int edge = 0; edge < 4; edge++) {
+					const auto step = a[edge] * subpixel;
+
+					if (step > 0) begin = std::max(begin, column_begin + floor_divide(-e[edge] + step - 1, step));
+					else if (step < 0) end = std::min(end, column_begin + floor_divide(e[edge], -step));
+					else if (e[edge] < 0) end = begin - 1;
+				}
+
+				auto pixel = mImage.data() + row * mWidth;
+
+				for (auto column = begin; column <= end; column++) pixel[column] = color;
+
+				for (int edge = 0; edge < 4; edge++) e[edge] += b[edge] * subpixel;
+			}
+		}
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Common.hpp"
+#include "LineSeriesBatch.hpp"
+#include "ThreadPool.hpp"
+
+#include <cstdint>
+
+#define CPU_SHARP_TILE_SIZE 64
+#define CPU_SHARP_SUBPIXEL_BITS 8
+
+//the CPU version of SharpGenerator, no device is needed
+//the quads of segments are binned into tiles, each tile is rasterized by one thread in the draw order
+//a pixel is covered if its center is inside the quad(top-left rule, 8 bits subpixel), the last quad wins as the GPU does
+class CpuSharpGenerator {
+public:
+	CpuSharpGenerator(
+		const std::shared_ptr<const LineSeriesBatch>& line_series,
+		size_t width, size_t height,
+		size_t thread_count = 0);
+
+	void run(real width = 2.0f);
+
+	//see ImageWriter::save, the file should be ".png" or ".rgba"
+	void save(const std::string& fileName);
+
+	//row major RGBA8, the pixel without line is white
+	auto image() const -> const std::vector<uint32_t>&;
+
+	auto width()const -> size_t;
+
+	auto height()const -> size_t;
+private:
+	//the corners are in subpixels and counterclockwise, the box is the pixels to test
+	struct Quad {
+		int32_t X[4];
+		int32_t Y[4];
+
+		int32_t Box[4]; //column begin, row begin, column end, row end(inclusive)
+
+		uint32_t Series;
+	};
+
+	//the series [Begin, End) are binned by one thread, the bins of tasks are rasterized in order
+	struct Task {
+		size_t Begin = 0;
+		size_t End = 0;
+
+		std::vector<Quad> Quads;
+		std::vector<std::vector<uint32_t>> Bins;
+	};
+
+	void bin_task(Task& task, vec2 scale, real width);
+
+	void rasterize_tile(size_t tile);
+private:
+	std::shared_ptr<const LineSeriesBatch> mLineSeries;
+
+	size_t mWidth;
+	size_t mHeight;
+
+	size_t mTileColumns;
+	size_t mTileRows;
+
+	ThreadPool mThreadPool;
+
+	std::vector<Task> mTasks;
+	std::vector<uint32_t> mColors;
+	std::vector<uint32_t> mImage;
+};
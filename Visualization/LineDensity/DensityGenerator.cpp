@@ -6,7 +6,7 @@
 
 DensityGenerator::DensityGenerator(
 	Factory* factory, 
-	const std::vector<LineSeries>& line_series, 
+	const std::shared_ptr<const LineSeriesBatch>& line_series, 
 	size_t heatmap_width, size_t heatmap_height) :
 	mFactory(factory), mLineSeries(line_series), 
 	mWidth(heatmap_width), mHeight(heatmap_height) {
@@ -33,8 +33,8 @@ DensityGenerator::DensityGenerator(
 	mInputLayout->addElement(InputLayoutElement("POSITION", sizeof(vec2), 0));
 
 	mTransformBuffer = mFactory->createConstantBuffer(sizeof(mat4) * 2, ResourceInfo::ConstantBuffer());
-	mVertexBuffer = mFactory->createVertexBuffer(sizeof(vec3) * 4, sizeof(vec3), ResourceInfo::VertexBuffer());
-	
+	mVertexBuffer = nullptr;
+
 	mCommonVertexShader = mFactory->createVertexShader(ShaderFile::read("./Shader/DensityGeneratorVertex.cso"), true);
 	
 	mMergePixelShader = mFactory->createPixelShader(ShaderFile::read("./Shader/DensityGeneratorMergePixel.cso"), true);
@@ -42,8 +42,6 @@ DensityGenerator::DensityGenerator(
 
 	mRasterizerState = mFactory->createRasterizerState();
 	mRasterizerState->enableDepth(false);
-
-	mVertexBuffer = nullptr;
 }
 
 DensityGenerator::~DensityGenerator() {
@@ -112,52 +110,128 @@ void DensityGenerator::run() {
 		});
 
 
-	// get the max size of line series
-	auto max_size = 0;
+	const auto& line_series = *mLineSeries;
+	const auto offsets = line_series.offsets();
+
+	//the points of series are uploaded in chunks, each chunk has whole series and is uploaded once
+	//the series in chunk are drawn with their offsets in the vertex buffer
+	//the series that is larger than the device limit is drawn in parts, see run_large_line_series
+	size_t series_begin = 0;
+
+	while (series_begin < line_series.size()) {
+		auto series_end = series_begin;
+
+		while (series_end < line_series.size() &&
+			offsets[series_end + 1] - offsets[series_begin] <= DENSITY_GENERATOR_MAX_VERTEX_COUNT) series_end++;
+
+		//the series that is larger than the device limit can not be drawn with one draw call
+		if (series_end == series_begin) {
+			run_large_line_series(series_begin++);
+
+			continue;
+		}
+
+		const auto point_begin = static_cast<size_t>(offsets[series_begin]);
+		const auto point_count = static_cast<size_t>(offsets[series_end]) - point_begin;
+
+		update_vertex_buffer(point_begin, point_count);
+
+		//for each line series
+		for (auto index = series_begin; index < series_end; index++) {
+			const auto lines = line_series[index];
+
+			graphics->clearUnorderedAccessUsageFloat(mBufferRWUsage, uav_float_clear);
+			graphics->clearUnorderedAccessUsageUint(mCountRWUsage, uav_uint_clear);
+
+			graphics->setPixelShader(mDrawPixelShader);
+
+			assert(lines.size() >= 2);
+
+			const auto line_count = static_cast<int>(lines.size());
+			const auto start = static_cast<int>(offsets[index] - point_begin);
+
+			graphics->draw(line_count + 1, start);
 
-	for (auto& lines : mLineSeries) 
-		max_size = std::max(max_size, static_cast<int>(lines.size() + 1));
+			//merge line series
+			graphics->setPixelShader(mMergePixelShader);
 
-	std::vector<vec2> lines_points(max_size);
+			graphics->draw(line_count + 1, start);
+		}
 
-	//when the size of buffer is less than lines
-	//we need to expand the buffer
+		series_begin = series_end;
+	}
+}
+
+void DensityGenerator::update_vertex_buffer(size_t point_begin, size_t point_count) {
+	const auto& line_series = *mLineSeries;
+	const auto points = line_series.points();
+
+	//when the size of buffer is less than points
+	//we need to expand the buffer, it is grown geometrically so it is reused by the next run
 	if (mVertexBuffer == nullptr ||
-		mVertexBuffer->count() < max_size) {
+		static_cast<size_t>(mVertexBuffer->count()) < point_count) {
+
+		const auto count = mVertexBuffer == nullptr ? point_count :
+			std::min(std::max(static_cast<size_t>(mVertexBuffer->count()) * 2, point_count),
+				static_cast<size_t>(DENSITY_GENERATOR_MAX_VERTEX_COUNT));
 
 		mFactory->destroyVertexBuffer(mVertexBuffer);
 
 		mVertexBuffer = mFactory->createVertexBuffer(
-			static_cast<int>(sizeof(vec2)) * max_size, sizeof(vec2), ResourceInfo::VertexBuffer());
+			static_cast<int>(sizeof(vec2) * count), sizeof(vec2), ResourceInfo::VertexBuffer());
 	}
 
-	graphics->setVertexBuffer(mVertexBuffer);
+	//the whole buffer is updated, so the points after the chunk are uploaded too if there are enough
+	//otherwise the chunk is copied with padding
+	const auto buffer_count = static_cast<size_t>(mVertexBuffer->count());
 
-	//for each line series
-	for (auto &lines : mLineSeries) {
-		graphics->clearUnorderedAccessUsageFloat(mBufferRWUsage, uav_float_clear);
-		graphics->clearUnorderedAccessUsageUint(mCountRWUsage, uav_uint_clear);
+	if (point_begin + buffer_count <= line_series.point_count())
+		mVertexBuffer->update(const_cast<vec2*>(points + point_begin));
+	else {
+		std::vector<vec2> chunk_points(buffer_count);
 
-		graphics->setPixelShader(mDrawPixelShader);
+		std::copy(points + point_begin, points + point_begin + point_count, chunk_points.data());
 
-		assert(lines.size() >= 2);
+		mVertexBuffer->update(chunk_points.data());
+	}
 
-		const auto line_count = static_cast<int>(lines.size());
+	mFactory->graphics()->setVertexBuffer(mVertexBuffer);
+}
 
-		std::copy(lines.data(), lines.data() + line_count + 1, lines_points.data());
+void DensityGenerator::run_large_line_series(size_t index) {
+	unsigned int uav_uint_clear[4] = { 0, 0, 0, 0 };
+	float uav_float_clear[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
 
-		mVertexBuffer->update(lines_points.data());
-		
-		graphics->draw(line_count + 1, 0);
+	const auto graphics = mFactory->graphics();
+
+	const auto point_begin = static_cast<size_t>(mLineSeries->offsets()[index]);
+	const auto point_end = static_cast<size_t>(mLineSeries->offsets()[index + 1]);
+
+	graphics->clearUnorderedAccessUsageFloat(mBufferRWUsage, uav_float_clear);
+	graphics->clearUnorderedAccessUsageUint(mCountRWUsage, uav_uint_clear);
+
+	//all parts are drawn to mark the pixels before any part is merged, the count of column is known after the last part
+	//the parts are uploaded again for merge pass, the buffer only has one part
+	for (auto pixel_shader : { mDrawPixelShader, mMergePixelShader }) {
+		graphics->setPixelShader(pixel_shader);
 
-		//merge line series
-		graphics->setPixelShader(mMergePixelShader);
+		for (auto part_begin = point_begin; part_begin + 1 < point_end; part_begin += DENSITY_GENERATOR_MAX_VERTEX_COUNT - 1) {
+			const auto part_count = std::min(point_end - part_begin, static_cast<size_t>(DENSITY_GENERATOR_MAX_VERTEX_COUNT));
 
-		graphics->draw(line_count + 1, 0);
+			update_vertex_buffer(part_begin, part_count);
+
+			graphics->draw(static_cast<int>(part_count), 0);
+		}
 	}
 }
 
-auto DensityGenerator::data() const -> const std::vector<LineSeries>& {
+void DensityGenerator::upload(const std::vector<real>& heatmap) {
+	assert(heatmap.size() == mWidth * mHeight);
+
+	mHeatMap->update(const_cast<real*>(heatmap.data()));
+}
+
+auto DensityGenerator::data() const -> const std::shared_ptr<const LineSeriesBatch>& {
 	return mLineSeries;
 }
 
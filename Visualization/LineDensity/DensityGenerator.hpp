@@ -1,28 +1,43 @@
 #pragma once
 
 #include "Utility.hpp"
-#include "LineSeries.hpp"
+#include "LineSeriesBatch.hpp"
+
+#include <memory>
+
+//the max number of points uploaded at once, 128MB of points that every device supports
+#define DENSITY_GENERATOR_MAX_VERTEX_COUNT (1 << 24)
 
 class DensityGenerator {
 public:
 	DensityGenerator(
 		Factory* factory,
-		const std::vector<LineSeries>& line_series,
+		const std::shared_ptr<const LineSeriesBatch>& line_series,
 		size_t heatmap_width, size_t heatmap_height);
 
 	~DensityGenerator();
 
 	void run();
 
-	auto data() const -> const std::vector<LineSeries>&;
+	//use the heat map built by other backend(e.g. CpuDensityGenerator), row major
+	void upload(const std::vector<real>& heatmap);
+
+	auto data() const -> const std::shared_ptr<const LineSeriesBatch>&;
 
 	auto width()const -> size_t;
 
 	auto height()const -> size_t;
+private:
+	//upload the points [point_begin, point_begin + point_count) to the begin of vertex buffer
+	void update_vertex_buffer(size_t point_begin, size_t point_count);
+
+	//the series that is larger than DENSITY_GENERATOR_MAX_VERTEX_COUNT is drawn in parts that share one point
+	//the segments of line strip are rasterized one by one, so the parts mark the same pixels as one draw
+	void run_large_line_series(size_t index);
 private:
 	Factory* mFactory;
 	
-	std::vector<LineSeries> mLineSeries;
+	std::shared_ptr<const LineSeriesBatch> mLineSeries;
 
 	size_t mWidth;
 	size_t mHeight;
@@ -0,0 +1,209 @@
+#include "DensityKernel.hpp"
+
+#include <immintrin.h>
+#include <type_traits>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+//MSVC can use any intrinsic without flags, GCC and Clang need the target of function
+#ifdef _MSC_VER
+#define DENSITY_KERNEL_TARGET(features)
+#else
+#define DENSITY_KERNEL_TARGET(features) __attribute__((target(features)))
+#endif
+
+static_assert(std::is_same<real, float>::value, "the density kernels only support float heat map.");
+
+namespace {
+
+	auto popcount_scalar(uint64_t value) -> unsigned {
+		value = value - ((value >> 1) & 0x5555555555555555ull);
+		value = (value & 0x3333333333333333ull) + ((value >> 2) & 0x3333333333333333ull);
+		value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+
+		return static_cast<unsigned>((value * 0x0101010101010101ull) >> 56);
+	}
+
+	auto count_trailing_zero(uint64_t value) -> unsigned {
+		//the bits below the lowest set bit
+		return popcount_scalar((value & (~value + 1)) - 1);
+	}
+
+	DENSITY_KERNEL_TARGET("popcnt")
+	inline auto popcount_hardware(uint64_t value) -> unsigned {
+#if defined(_M_X64) || defined(__x86_64__)
+		return static_cast<unsigned>(_mm_popcnt_u64(value));
+#else
+		return static_cast<unsigned>(_mm_popcnt_u32(static_cast<unsigned>(value)) + _mm_popcnt_u32(static_cast<unsigned>(value >> 32)));
+#endif
+	}
+
+	void merge_scalar(uint64_t* bits, size_t word_count, real* heatmap) {
+		unsigned count = 0;
+
+		for (size_t word = 0; word < word_count; word++) count += popcount_scalar(bits[word]);
+
+		if (count == 0) return;
+
+		const auto scale = static_cast<real>(1) / static_cast<real>(count);
+
+		for (size_t word = 0; word < word_count; word++) {
+			auto value = bits[word];
+
+			//visit the set bits only
+			while (value != 0) {
+				heatmap[word * DENSITY_KERNEL_WORD_BITS + count_trailing_zero(value)] += scale;
+
+				value &= value - 1;
+			}
+
+			bits[word] = 0;
+		}
+	}
+
+	DENSITY_KERNEL_TARGET("sse4.2,popcnt")
+	void merge_sse4(uint64_t* bits, size_t word_count, real* heatmap) {
+		unsigned count = 0;
+
+		for (size_t word = 0; word < word_count; word++) count += popcount_hardware(bits[word]);
+
+		if (count == 0) return;
+
+		const auto scale = _mm_set1_ps(static_cast<real>(1) / static_cast<real>(count));
+		const auto select = _mm_setr_epi32(1, 2, 4, 8);
+
+		for (size_t word = 0; word < word_count; word++) {
+			const auto value = bits[word];
+
+			if (value == 0) continue;
+
+			//4 rows a time, the mask of row is all ones if it is marked
+			for (size_t group = 0; group < DENSITY_KERNEL_WORD_BITS / 4; group++) {
+				const auto nibble = static_cast<int>((value >> (group * 4)) & 0xF);
+
+				if (nibble == 0) continue;
+
+				const auto mask = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(nibble), select), select);
+				const auto target = heatmap + word * DENSITY_KERNEL_WORD_BITS + group * 4;
+
+				_mm_storeu_ps(target, _mm_add_ps(_mm_loadu_ps(target), _mm_and_ps(_mm_castsi128_ps(mask), scale)));
+			}
+
+			bits[word] = 0;
+		}
+	}
+
+	DENSITY_KERNEL_TARGET("avx2,popcnt")
+	void merge_avx2(uint64_t* bits, size_t word_count, real* heatmap) {
+		unsigned count = 0;
+
+		for (size_t word = 0; word < word_count; word++) count += popcount_hardware(bits[word]);
+
+		if (count == 0) return;
+
+		const auto scale = _mm256_set1_ps(static_cast<real>(1) / static_cast<real>(count));
+		const auto select = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+
+		for (size_t word = 0; word < word_count; word++) {
+			const auto value = bits[word];
+
+			if (value == 0) continue;
+
+			//8 rows a time, the mask of row is all ones if it is marked
+			for (size_t group = 0; group < DENSITY_KERNEL_WORD_BITS / 8; group++) {
+				const auto byte_value = static_cast<int>((value >> (group * 8)) & 0xFF);
+
+				if (byte_value == 0) continue;
+
+				const auto mask = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(byte_value), select), select);
+				const auto target = heatmap + word * DENSITY_KERNEL_WORD_BITS + group * 8;
+
+				_mm256_storeu_ps(target, _mm256_add_ps(_mm256_loadu_ps(target), _mm256_and_ps(_mm256_castsi256_ps(mask), scale)));
+			}
+
+			bits[word] = 0;
+		}
+	}
+
+	void cpuid(int info[4], int function, int sub_function) {
+#ifdef _MSC_VER
+		__cpuidex(info, function, sub_function);
+#else
+		unsigned registers[4] = { 0, 0, 0, 0 };
+
+		__cpuid_count(function, sub_function, registers[0], registers[1], registers[2], registers[3]);
+
+		for (int index = 0; index < 4; index++) info[index] = static_cast<int>(registers[index]);
+#endif
+	}
+
+	auto xgetbv() -> unsigned long long {
+#ifdef _MSC_VER
+		return _xgetbv(0);
+#else
+		unsigned eax = 0, edx = 0;
+
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+
+		return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+	}
+}
+
+DensityKernel::DensityKernel(DensityKernelType type) : mType(type) {
+	switch (type)
+	{
+	case DensityKernelType::AVX2: mMerge = merge_avx2; break;
+	case DensityKernelType::SSE4: mMerge = merge_sse4; break;
+	default: mMerge = merge_scalar; break;
+	}
+}
+
+auto DensityKernel::type() const -> DensityKernelType {
+	return mType;
+}
+
+auto DensityKernel::detect() -> DensityKernelType {
+	int info[4] = { 0, 0, 0, 0 };
+
+	cpuid(info, 0, 0);
+
+	const auto max_function = info[0];
+
+	if (max_function < 1) return DensityKernelType::Scalar;
+
+	cpuid(info, 1, 0);
+
+	const auto sse4 = (info[2] & (1 << 19)) != 0 && (info[2] & (1 << 20)) != 0;
+	const auto popcnt = (info[2] & (1 << 23)) != 0;
+	const auto osxsave = (info[2] & (1 << 27)) != 0;
+	const auto avx = (info[2] & (1 << 28)) != 0;
+
+	if (sse4 == false || popcnt == false) return DensityKernelType::Scalar;
+
+	//the OS should save the ymm registers
+	if (max_function < 7 || osxsave == false || avx == false || (xgetbv() & 6) != 6) return DensityKernelType::SSE4;
+
+	cpuid(info, 7, 0);
+
+	if ((info[1] & (1 << 5)) == 0) return DensityKernelType::SSE4;
+
+	return DensityKernelType::AVX2;
+}
+
+auto DensityKernel::name(DensityKernelType type) -> std::string {
+	switch (type)
+	{
+	case DensityKernelType::AVX2: return "avx2";
+	case DensityKernelType::SSE4: return "sse4";
+	default: return "scalar";
+	}
+}
+
+auto DensityKernel::word_count(size_t height) -> size_t {
+	return (height + DENSITY_KERNEL_WORD_BITS - 1) / DENSITY_KERNEL_WORD_BITS;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <cstdint>
+#include <string>
+
+//the marks of a series are stored as column major bitsets, bit (row % 64) of word (row / 64) is the row
+//the heat map of kernel is column major too, each column has word_count * 64 rows
+#define DENSITY_KERNEL_WORD_BITS 64
+
+enum class DensityKernelType {
+	Scalar = 0,
+	SSE4 = 1,
+	AVX2 = 2
+};
+
+//count the marked pixels of column, add 1 / count to them and clear the marks
+using DensityMergeFunction = void(*)(uint64_t* bits, size_t word_count, real* heatmap);
+
+class DensityKernel {
+public:
+	explicit DensityKernel(DensityKernelType type = detect());
+
+	//set the bits [row_begin, row_end] of column
+	static void mark(uint64_t* bits, size_t row_begin, size_t row_end);
+
+	void merge(uint64_t* bits, size_t word_count, real* heatmap) const;
+
+	//or the rows (2i, 2i + 1) of column into the row i of target, the target has (word_count + 1) / 2 words at least
+	static void halve(const uint64_t* bits, size_t word_count, uint64_t* target);
+
+	auto type() const -> DensityKernelType;
+
+	//the best kernel that the CPU supports
+	static auto detect() -> DensityKernelType;
+
+	static auto name(DensityKernelType type) -> std::string;
+
+	static auto word_count(size_t height) -> size_t;
+private:
+	DensityKernelType mType;
+	DensityMergeFunction mMerge;
+};
+
+inline void DensityKernel::mark(uint64_t* bits, size_t row_begin, size_t row_end) {
+	const auto word_begin = row_begin / DENSITY_KERNEL_WORD_BITS;
+	const auto word_end = row_end / DENSITY_KERNEL_WORD_BITS;
+
+	const auto begin_mask = ~static_cast<uint64_t>(0) << (row_begin % DENSITY_KERNEL_WORD_BITS);
+	const auto end_mask = ~static_cast<uint64_t>(0) >> (DENSITY_KERNEL_WORD_BITS - 1 - row_end % DENSITY_KERNEL_WORD_BITS);
+
+	if (word_begin == word_end) {
+		bits[word_begin] |= begin_mask & end_mask;
+
+		return;
+	}
+
+	bits[word_begin] |= begin_mask;
+
+	for (auto word = word_begin + 1; word < word_end; word++) bits[word] = ~static_cast<uint64_t>(0);
+
+	bits[word_end] |= end_mask;
+}
+
+inline void DensityKernel::halve(const uint64_t* bits, size_t word_count, uint64_t* target) {
+	//keep the even bits and pack them into the low half
+	const auto compress = [](uint64_t value)
+	{
+		value = (value | (value >> 1)) & 0x5555555555555555ull;
+		value = (value | (value >> 1)) & 0x3333333333333333ull;
+		value = (value | (value >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+		value = (value | (value >> 4)) & 0x00FF00FF00FF00FFull;
+		value = (value | (value >> 8)) & 0x0000FFFF0000FFFFull;
+		value = (value | (value >> 16)) & 0x00000000FFFFFFFFull;
+
+		return value;
+	};
+
+	for (size_t word = 0; word < word_count; word += 2) {
+		const auto high = word + 1 < word_count ? compress(bits[word + 1]) : 0;
+
+		target[word / 2] |= compress(bits[word]) | (high << 32);
+	}
+}
+
+inline void DensityKernel::merge(uint64_t* bits, size_t word_count, real* heatmap) const {
+	mMerge(bits, word_count, heatmap);
+}
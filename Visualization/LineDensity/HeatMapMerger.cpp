@@ -0,0 +1,177 @@
+#include "HeatMapMerger.hpp"
+#include "ImageWriter.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+#undef max
+#undef min
+
+HeatMapMerger::HeatMapMerger(const std::vector<std::string>& fileNames) :
+	mWidth(0), mHeight(0), mTileCount(0) {
+
+	for (auto& fileName : fileNames) {
+		auto file = std::make_shared<TiledHeatMapFile>(fileName);
+
+		//the size of first valid file is the size of heat map
+		if (file->is_open() == true && mFiles.empty() == true) {
+			mWidth = file->width();
+			mHeight = file->height();
+		}
+
+		if (file->is_open() == false || file->width() != mWidth || file->height() != mHeight) {
+			mInvalidFiles.push_back(fileName);
+
+			continue;
+		}
+
+		mFiles.push_back(file);
+	}
+
+	mTileCount = indices().size();
+}
+
+auto HeatMapMerger::is_open() const -> bool {
+	return mFiles.empty() == false && mInvalidFiles.empty() == true;
+}
+
+auto HeatMapMerger::is_complete() const -> bool {
+	if (mFiles.empty() == true) return false;
+
+	const auto shard_count = mFiles.front()->shard_count();
+
+	std::vector<byte> shards(shard_count, 0);
+
+	for (auto& file : mFiles) {
+		if (file->shard_count() != shard_count || shards[file->shard_index()] != 0) return false;
+
+		shards[file->shard_index()] = 1;
+	}
+
+	return mFiles.size() == shard_count;
+}
+
+auto HeatMapMerger::invalid_files() const -> const std::vector<std::string>& {
+	return mInvalidFiles;
+}
+
+auto HeatMapMerger::width() const -> size_t {
+	return mWidth;
+}
+
+auto HeatMapMerger::height() const -> size_t {
+	return mHeight;
+}
+
+auto HeatMapMerger::tile_count() const -> size_t {
+	return mTileCount;
+}
+
+auto HeatMapMerger::indices() const -> std::vector<uint64_t> {
+	std::vector<uint64_t> result;
+
+	for (auto& file : mFiles) {
+		const auto middle = result.size();
+
+		for (size_t tile = 0; tile < file->tile_count(); tile++) result.push_back(file->index(tile));
+
+		std::inplace_merge(result.begin(), result.begin() + middle, result.end());
+
+		result.erase(std::unique(result.begin(), result.end()), result.end());
+	}
+
+	return result;
+}
+
+void HeatMapMerger::merge(const MergeFunction& function) const {
+	//the next tile of each file, the indices of files are increasing
+	std::vector<size_t> cursors(mFiles.size(), 0);
+	std::vector<float> values(TILED_HEAT_MAP_TILE_PIXELS);
+
+	while (true) {
+		auto index = TiledHeatMapFile::grid_tile_count(mWidth, mHeight);
+
+		for (size_t file = 0; file < mFiles.size(); file++)
+			if (cursors[file] < mFiles[file]->tile_count()) index = std::min(index, mFiles[file]->index(cursors[file]));
+
+		if (index == TiledHeatMapFile::grid_tile_count(mWidth, mHeight)) break;
+
+		std::fill(values.begin(), values.end(), 0.0f);
+
+		for (size_t file = 0; file < mFiles.size(); file++) {
+			if (cursors[file] >= mFiles[file]->tile_count() || mFiles[file]->index(cursors[file]) != index) continue;
+
+			const auto source = mFiles[file]->tile(cursors[file]++);
+
+			for (size_t pixel = 0; pixel < TILED_HEAT_MAP_TILE_PIXELS; pixel++) values[pixel] += source[pixel];
+		}
+
+		function(index, values.data());
+	}
+}
+
+void HeatMapMerger::save(const std::string& fileName) const {
+	const auto indices = this->indices();
+
+	TiledHeatMapHeader header;
+
+	header.Magic = TILED_HEAT_MAP_MAGIC;
+	header.Version = TILED_HEAT_MAP_VERSION;
+	header.Width = mWidth;
+	header.Height = mHeight;
+	header.TileSize = TILED_HEAT_MAP_TILE_SIZE;
+	header.Checksum = 0;
+	header.TileCount = indices.size();
+	header.IndicesSection = sizeof(TiledHeatMapHeader);
+	header.TilesSection = header.IndicesSection + sizeof(uint64_t) * indices.size();
+	header.ShardIndex = 0;
+	header.ShardCount = 1;
+
+	std::ofstream file(fileName, std::ios::binary);
+	assert(file.is_open() == true);
+
+	//the checksum is known after the tiles, the header is written again at the end, see TiledHeatMap::save
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(indices.data()), static_cast<std::streamsize>(sizeof(uint64_t) * indices.size()));
+
+	auto checksum = ImageWriter::crc32(reinterpret_cast<const unsigned char*>(indices.data()), sizeof(uint64_t) * indices.size());
+
+	merge([&](size_t, const float* values)
+		{
+			file.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(sizeof(float) * TILED_HEAT_MAP_TILE_PIXELS));
+
+			checksum = ImageWriter::crc32(reinterpret_cast<const unsigned char*>(values), sizeof(float) * TILED_HEAT_MAP_TILE_PIXELS, checksum);
+		});
+
+	header.Checksum = checksum;
+
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.close();
+}
+
+auto HeatMapMerger::is_image_too_large() const -> bool {
+	return mHeight != 0 && mWidth > HEAT_MAP_MERGER_MAX_IMAGE_PIXELS / mHeight;
+}
+
+void HeatMapMerger::map(const ColorLookupTable& table, std::vector<uint32_t>& image) const {
+	assert(is_image_too_large() == false);
+
+	//the pixels without tile have zero density
+	image.assign(mWidth * mHeight, table.map(0));
+
+	const auto tile_columns = (mWidth + TILED_HEAT_MAP_TILE_SIZE - 1) / TILED_HEAT_MAP_TILE_SIZE;
+
+	merge([&](size_t tile, const float* values)
+		{
+			const auto column_begin = (tile % tile_columns) * TILED_HEAT_MAP_TILE_SIZE;
+			const auto row_begin = (tile / tile_columns) * TILED_HEAT_MAP_TILE_SIZE;
+			const auto column_end = std::min(column_begin + TILED_HEAT_MAP_TILE_SIZE, mWidth);
+			const auto row_end = std::min(row_begin + TILED_HEAT_MAP_TILE_SIZE, mHeight);
+
+			for (auto row = row_begin; row < row_end; row++) {
+				for (auto column = column_begin; column < column_end; column++)
+					image[row * mWidth + column] = table.map(values[(row - row_begin) * TILED_HEAT_MAP_TILE_SIZE + column - column_begin]);
+			}
+		});
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Common.hpp"
+#include "TiledHeatMapFile.hpp"
+#include "ColorLookupTable.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+//the max pixels of merged image, the image is whole in memory(4 bytes per pixel) for the encoder
+//the larger heat map should be merged to tiled heat map file(-ot)
+#define HEAT_MAP_MERGER_MAX_IMAGE_PIXELS (static_cast<size_t>(1) << 28)
+
+//the tile index and the sum of tiles of partial heat maps, row major
+using MergeFunction = std::function<void(size_t tile, const float* values)>;
+
+//sum the partial heat maps(tiled heat map files) of shards, the density is additive across series
+//the files are merged tile by tile in the order of indices, so only one tile is in memory besides the output
+class HeatMapMerger {
+public:
+	explicit HeatMapMerger(const std::vector<std::string>& fileNames);
+
+	//all files are valid and have the same size
+	auto is_open() const -> bool;
+
+	//the files have the same shard count and each shard is in them once
+	auto is_complete() const -> bool;
+
+	//the files that are not opened or do not match the first file
+	auto invalid_files() const -> const std::vector<std::string>&;
+
+	auto width() const -> size_t;
+
+	auto height() const -> size_t;
+
+	//the number of tiles that any file has
+	auto tile_count() const -> size_t;
+
+	//the function is called for the tiles of union in increasing order of index
+	void merge(const MergeFunction& function) const;
+
+	//save the merged heat map as tiled heat map file(shard 0 of 1)
+	void save(const std::string& fileName) const;
+
+	//the merged heat map is too large to be color mapped to one image
+	auto is_image_too_large() const -> bool;
+
+	//the row major color mapped image, the tiles are mapped when they are merged, so the dense heat map is not built
+	void map(const ColorLookupTable& table, std::vector<uint32_t>& image) const;
+private:
+	//the indices of union, increasing
+	auto indices() const -> std::vector<uint64_t>;
+private:
+	std::vector<std::shared_ptr<TiledHeatMapFile>> mFiles;
+	std::vector<std::string> mInvalidFiles;
+
+	size_t mWidth;
+	size_t mHeight;
+	size_t mTileCount;
+};
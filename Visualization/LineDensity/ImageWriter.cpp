@@ -0,0 +1,414 @@
+#include "ImageWriter.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <fstream>
+
+#undef max
+#undef min
+
+//the rows of one part that a thread compresses
+#define IMAGE_WRITER_PART_ROWS 64
+
+#define DEFLATE_WINDOW_SIZE 32768
+#define DEFLATE_HASH_BITS 15
+#define DEFLATE_MAX_CHAIN 16
+#define DEFLATE_MIN_MATCH 3
+#define DEFLATE_MAX_MATCH 258
+
+namespace {
+
+	const unsigned short length_base[] = {
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+		35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const unsigned char length_extra[] = {
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+		3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const unsigned short distance_base[] = {
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+		257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const unsigned char distance_extra[] = {
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+		7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	//write bits from the lowest bit of byte, as DEFLATE requires
+	class BitWriter {
+	public:
+		explicit BitWriter(std::vector<unsigned char>& output) : mOutput(output) {}
+
+		void write(uint32_t value, unsigned count) {
+			mBuffer |= static_cast<uint64_t>(value) << mCount;
+			mCount += count;
+
+			while (mCount >= 8) {
+				mOutput.push_back(static_cast<unsigned char>(mBuffer));
+				mBuffer >>= 8;
+				mCount -= 8;
+			}
+		}
+
+		//the huffman codes are written from the highest bit
+		void write_reverse(uint32_t code, unsigned count) {
+			uint32_t value = 0;
+
+			for (unsigned index = 0; index < count; index++) value |= ((code >> index) & 1) << (count - 1 - index);
+
+			write(value, count);
+		}
+
+		void align() {
+			if (mCount != 0) write(0, 8 - mCount);
+		}
+	private:
+		std::vector<unsigned char>& mOutput;
+
+		uint64_t mBuffer = 0;
+		unsigned mCount = 0;
+	};
+
+	//the fixed huffman code of literal or length symbol
+	void write_symbol(BitWriter& writer, unsigned symbol) {
+		if (symbol < 144) writer.write_reverse(0x30 + symbol, 8);
+		else if (symbol < 256) writer.write_reverse(0x190 + symbol - 144, 9);
+		else if (symbol < 280) writer.write_reverse(symbol - 256, 7);
+		else writer.write_reverse(0xC0 + symbol - 280, 8);
+	}
+
+	void write_match(BitWriter& writer, unsigned length, unsigned distance) {
+		unsigned length_code = 28;
+
+		while (length_base[length_code] > length) length_code--;
+
+		write_symbol(writer, 257 + length_code);
+		writer.write(length - length_base[length_code], length_extra[length_code]);
+
+		unsigned distance_code = 29;
+
+		while (distance_base[distance_code] > distance) distance_code--;
+
+		writer.write_reverse(distance_code, 5);
+		writer.write(distance - distance_base[distance_code], distance_extra[distance_code]);
+	}
+
+	auto hash(const unsigned char* data) -> uint32_t {
+		const auto value = static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) | (static_cast<uint32_t>(data[2]) << 16);
+
+		return (value * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+	}
+
+	//compress the data as one fixed huffman block(not final), and end it with an empty stored block
+	//so the output ends at byte boundary and the next part can be appended
+	void deflate_part(const std::vector<unsigned char>& data, std::vector<unsigned char>& output) {
+		BitWriter writer(output);
+
+		//BFINAL = 0, BTYPE = 01
+		writer.write(2, 3);
+
+		std::vector<int> head(static_cast<size_t>(1) << DEFLATE_HASH_BITS, -1);
+		std::vector<int> previous(data.size(), -1);
+
+		const auto size = data.size();
+
+		size_t position = 0;
+
+		while (position < size) {
+			unsigned best_length = 0;
+			unsigned best_distance = 0;
+
+			if (position + DEFLATE_MIN_MATCH <= size) {
+				const auto key = hash(&data[position]);
+				const auto max_length = static_cast<unsigned>(std::min(size - position, static_cast<size_t>(DEFLATE_MAX_MATCH)));
+
+				auto candidate = head[key];
+
+				for (int chain = 0; chain < DEFLATE_MAX_CHAIN && candidate >= 0 &&
+					position - static_cast<size_t>(candidate) <= DEFLATE_WINDOW_SIZE; chain++) {
+					unsigned length = 0;
+
+					while (length < max_length && data[static_cast<size_t>(candidate) + length] == data[position + length]) length++;
+
+					if (length > best_length) {
+						best_length = length;
+						best_distance = static_cast<unsigned>(position - static_cast<size_t>(candidate));
+
+						if (length == max_length) break;
+					}
+
+					candidate = previous[static_cast<size_t>(candidate)];
+				}
+
+				previous[position] = head[key];
+				head[key] = static_cast<int>(position);
+			}
+
+			if (best_length >= DEFLATE_MIN_MATCH) {
+				write_match(writer, best_length, best_distance);
+
+				//insert the positions in the match, so the next matches can find them
+				for (size_t index = position + 1; index < position + best_length && index + DEFLATE_MIN_MATCH <= size; index++) {
+					const auto key = hash(&data[index]);
+
+					previous[index] = head[key];
+					head[key] = static_cast<int>(index);
+				}
+
+				position += best_length;
+			}
+			else {
+				write_symbol(writer, data[position]);
+
+				position++;
+			}
+		}
+
+		//end of block
+		write_symbol(writer, 256);
+
+		//empty stored block, BFINAL = 0, BTYPE = 00, LEN = 0, NLEN = 0xFFFF
+		writer.write(0, 3);
+		writer.align();
+		writer.write(0x0000, 16);
+		writer.write(0xFFFF, 16);
+	}
+
+	auto paeth(int a, int b, int c) -> int {
+		const auto p = a + b - c;
+		const auto pa = std::abs(p - a);
+		const auto pb = std::abs(p - b);
+		const auto pc = std::abs(p - c);
+
+		if (pa <= pb && pa <= pc) return a;
+		if (pb <= pc) return b;
+
+		return c;
+	}
+
+	//the predict of filter type(0 : None, 1 : Sub, 2 : Up, 4 : Paeth)
+	auto predict(int type, const unsigned char* row, const unsigned char* previous_row, size_t index) -> int {
+		const int left = index >= 4 ? row[index - 4] : 0;
+		const int up = previous_row != nullptr ? previous_row[index] : 0;
+		const int left_up = index >= 4 && previous_row != nullptr ? previous_row[index - 4] : 0;
+
+		if (type == 1) return left;
+		if (type == 2) return up;
+		if (type == 4) return paeth(left, up, left_up);
+
+		return 0;
+	}
+
+	//filter the row with the type that has the min sum of absolute values
+	void filter_row(const unsigned char* row, const unsigned char* previous_row, size_t size, std::vector<unsigned char>& output) {
+		static const int types[] = { 0, 1, 2, 4 };
+
+		size_t sums[4] = { 0, 0, 0, 0 };
+
+		for (size_t index = 0; index < size; index++) {
+			for (int type = 0; type < 4; type++) {
+				const auto value = static_cast<unsigned char>(row[index] - predict(types[type], row, previous_row, index));
+
+				sums[type] += value < 128 ? value : 256 - value;
+			}
+		}
+
+		const auto best = types[std::min_element(sums, sums + 4) - sums];
+
+		output.push_back(static_cast<unsigned char>(best));
+
+		for (size_t index = 0; index < size; index++)
+			output.push_back(static_cast<unsigned char>(row[index] - predict(best, row, previous_row, index)));
+	}
+
+	void write_big_endian(std::vector<unsigned char>& output, uint32_t value) {
+		for (int shift = 24; shift >= 0; shift -= 8) output.push_back(static_cast<unsigned char>(value >> shift));
+	}
+
+	void write_chunk(std::ofstream& file, const char* type, const unsigned char* data, size_t size) {
+		std::vector<unsigned char> header;
+
+		write_big_endian(header, static_cast<uint32_t>(size));
+		header.insert(header.end(), type, type + 4);
+
+		auto crc = ImageWriter::crc32(header.data() + 4, 4);
+
+		crc = ImageWriter::crc32(data, size, crc);
+
+		std::vector<unsigned char> footer;
+
+		write_big_endian(footer, crc);
+
+		file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+		file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+		file.write(reinterpret_cast<const char*>(footer.data()), static_cast<std::streamsize>(footer.size()));
+	}
+}
+
+void ImageWriter::save(const std::string& fileName, const std::vector<uint32_t>& image,
+	size_t width, size_t height, size_t thread_count) {
+	const std::string extension = ".png";
+
+	if (fileName.size() >= extension.size() &&
+		fileName.compare(fileName.size() - extension.size(), extension.size(), extension) == 0)
+		save_png(fileName, image, width, height, thread_count);
+	else
+		save_raw(fileName, image, width, height);
+}
+
+void ImageWriter::save_png(const std::string& fileName, const std::vector<uint32_t>& image,
+	size_t width, size_t height, size_t thread_count) {
+	assert(image.size() == width * height);
+
+	const auto row_size = width * sizeof(uint32_t);
+	const auto part_count = (height + IMAGE_WRITER_PART_ROWS - 1) / IMAGE_WRITER_PART_ROWS;
+
+	//the compressed data and the adler32 of filtered data of parts
+	std::vector<std::vector<unsigned char>> parts(part_count);
+	std::vector<uint32_t> adlers(part_count);
+	std::vector<size_t> sizes(part_count);
+
+	ThreadPool thread_pool(thread_count);
+
+	thread_pool.parallel_for(part_count, [&](size_t, size_t part)
+		{
+			const auto row_begin = part * IMAGE_WRITER_PART_ROWS;
+			const auto row_end = std::min(row_begin + IMAGE_WRITER_PART_ROWS, height);
+
+			const auto pixels = reinterpret_cast<const unsigned char*>(image.data());
+
+			std::vector<unsigned char> filtered;
+
+			filtered.reserve((row_end - row_begin) * (row_size + 1));
+
+			for (auto row = row_begin; row < row_end; row++)
+				filter_row(pixels + row * row_size, row == 0 ? nullptr : pixels + (row - 1) * row_size, row_size, filtered);
+
+			adlers[part] = adler32(filtered.data(), filtered.size());
+			sizes[part] = filtered.size();
+
+			deflate_part(filtered, parts[part]);
+		});
+
+	std::ofstream file(fileName, std::ios::binary);
+	assert(file.is_open() == true);
+
+	const unsigned char signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+	//IHDR : width, height, bit depth 8, color type 6(RGBA), compression, filter and interlace 0
+	std::vector<unsigned char> header;
+
+	write_big_endian(header, static_cast<uint32_t>(width));
+	write_big_endian(header, static_cast<uint32_t>(height));
+	header.insert(header.end(), { 8, 6, 0, 0, 0 });
+
+	write_chunk(file, "IHDR", header.data(), header.size());
+
+	//zlib header(deflate, 32K window), then the parts
+	const unsigned char zlib_header[] = { 0x78, 0x01 };
+
+	write_chunk(file, "IDAT", zlib_header, sizeof(zlib_header));
+
+	uint32_t adler = 1;
+
+	for (size_t part = 0; part < part_count; part++) {
+		write_chunk(file, "IDAT", parts[part].data(), parts[part].size());
+
+		adler = adler32_combine(adler, adlers[part], sizes[part]);
+	}
+
+	//the final empty fixed huffman block and the adler32 of all filtered data
+	std::vector<unsigned char> zlib_footer = { 0x03, 0x00 };
+
+	write_big_endian(zlib_footer, adler);
+
+	write_chunk(file, "IDAT", zlib_footer.data(), zlib_footer.size());
+	write_chunk(file, "IEND", nullptr, 0);
+
+	file.close();
+}
+
+void ImageWriter::save_raw(const std::string& fileName, const std::vector<uint32_t>& image, size_t width, size_t height) {
+	//the raw file has no header, the size is only known by the caller, so the image is not written if it does not match
+	if (image.size() != width * height) return;
+
+	std::ofstream file(fileName, std::ios::binary);
+	assert(file.is_open() == true);
+
+	file.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size() * sizeof(uint32_t)));
+	file.close();
+}
+
+auto ImageWriter::is_supported(const std::string& fileName) -> bool {
+	for (const std::string extension : { ".png", ".rgba" }) {
+		if (fileName.size() >= extension.size() &&
+			fileName.compare(fileName.size() - extension.size(), extension.size(), extension) == 0) return true;
+	}
+
+	return false;
+}
+
+auto ImageWriter::crc32(const unsigned char* data, size_t size, uint32_t crc) -> uint32_t {
+	static const auto table = []()
+	{
+		std::vector<uint32_t> result(256);
+
+		for (uint32_t index = 0; index < 256; index++) {
+			auto value = index;
+
+			for (int bit = 0; bit < 8; bit++) value = (value & 1) != 0 ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+
+			result[index] = value;
+		}
+
+		return result;
+	}();
+
+	crc = ~crc;
+
+	for (size_t index = 0; index < size; index++) crc = table[(crc ^ data[index]) & 0xFF] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+auto ImageWriter::adler32(const unsigned char* data, size_t size, uint32_t adler) -> uint32_t {
+	uint32_t a = adler & 0xFFFF;
+	uint32_t b = adler >> 16;
+
+	while (size != 0) {
+		//the max count that b does not overflow before modulo
+		const auto count = std::min(size, static_cast<size_t>(5552));
+
+		for (size_t index = 0; index < count; index++) {
+			a += data[index];
+			b += a;
+		}
+
+		a %= 65521;
+		b %= 65521;
+
+		data += count;
+		size -= count;
+	}
+
+	return (b << 16) | a;
+}
+
+auto ImageWriter::adler32_combine(uint32_t adler_a, uint32_t adler_b, size_t size_b) -> uint32_t {
+	const uint32_t base = 65521;
+	const auto remainder = static_cast<uint32_t>(size_b % base);
+
+	auto sum_a = adler_a & 0xFFFF;
+	auto sum_b = static_cast<uint32_t>((static_cast<uint64_t>(remainder) * sum_a) % base);
+
+	sum_a += (adler_b & 0xFFFF) + base - 1;
+	sum_b += ((adler_a >> 16) & 0xFFFF) + ((adler_b >> 16) & 0xFFFF) + base - remainder;
+
+	if (sum_a >= base) sum_a -= base;
+	if (sum_a >= base) sum_a -= base;
+	if (sum_b >= (base << 1)) sum_b -= (base << 1);
+	if (sum_b >= base) sum_b -= base;
+
+	return sum_a | (sum_b << 16);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//write the RGBA8 image(r is the lowest byte, row major) without device
+//".png" is compressed by DEFLATE with threads, ".rgba" is the raw pixels without header
+class ImageWriter {
+public:
+	static void save(const std::string& fileName, const std::vector<uint32_t>& image,
+		size_t width, size_t height, size_t thread_count = 0);
+
+	//the rows are split into parts, each part is filtered and compressed by one thread
+	//the parts are independent DEFLATE blocks that end at byte boundary, so they can be joined
+	static void save_png(const std::string& fileName, const std::vector<uint32_t>& image,
+		size_t width, size_t height, size_t thread_count = 0);
+
+	//nothing is written if the image is not width * height pixels
+	static void save_raw(const std::string& fileName, const std::vector<uint32_t>& image,
+		size_t width, size_t height);
+
+	//the file is ".png" or ".rgba"
+	static auto is_supported(const std::string& fileName) -> bool;
+
+	static auto crc32(const unsigned char* data, size_t size, uint32_t crc = 0) -> uint32_t;
+
+	static auto adler32(const unsigned char* data, size_t size, uint32_t adler = 1) -> uint32_t;
+
+	//the adler32 of (a + b) from adler32(a), adler32(b) and the size of b
+	static auto adler32_combine(uint32_t adler_a, uint32_t adler_b, size_t size_b) -> uint32_t;
+};
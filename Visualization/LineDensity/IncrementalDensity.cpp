@@ -0,0 +1,118 @@
+#include "IncrementalDensity.hpp"
+#include "LineRasterizer.hpp"
+#include "DensityKernel.hpp"
+
+#include <algorithm>
+#include <bitset>
+
+#undef max
+
+IncrementalDensity::IncrementalDensity(size_t heatmap_width, size_t heatmap_height, size_t rebase_interval) :
+	mWidth(heatmap_width), mHeight(heatmap_height), mWordCount(DensityKernel::word_count(heatmap_height)),
+	mNextId(0), mUpdateCount(0), mRebaseInterval(rebase_interval) {
+
+	mBits.resize(mWidth * mWordCount, 0);
+	mTouched.resize(mWidth, 0);
+	mHeatMap.resize(mWidth * mHeight, 0);
+}
+
+auto IncrementalDensity::add(const LineSeriesView& line_series) -> size_t {
+	return add(LineSeries(std::vector<vec2>(line_series.data(), line_series.data() + line_series.size() + 1), line_series.color()));
+}
+
+auto IncrementalDensity::add(const LineSeries& line_series) -> size_t {
+	const auto id = mNextId++;
+
+	apply(mLineSeries[id] = line_series, 1.0);
+
+	update();
+
+	return id;
+}
+
+void IncrementalDensity::remove(size_t id) {
+	const auto it = mLineSeries.find(id);
+
+	assert(it != mLineSeries.end());
+
+	if (it == mLineSeries.end()) return;
+
+	apply(it->second, -1.0);
+
+	mLineSeries.erase(it);
+
+	update();
+}
+
+void IncrementalDensity::rebase() {
+	std::fill(mHeatMap.begin(), mHeatMap.end(), 0.0);
+
+	for (auto& line_series : mLineSeries) apply(line_series.second, 1.0);
+
+	mUpdateCount = 0;
+}
+
+auto IncrementalDensity::snapshot() const -> std::vector<real> {
+	std::vector<real> heatmap(mHeatMap.size());
+
+	for (size_t index = 0; index < heatmap.size(); index++)
+		heatmap[index] = static_cast<real>(mHeatMap[index]);
+
+	return heatmap;
+}
+
+auto IncrementalDensity::size() const -> size_t {
+	return mLineSeries.size();
+}
+
+auto IncrementalDensity::width() const -> size_t {
+	return mWidth;
+}
+
+auto IncrementalDensity::height() const -> size_t {
+	return mHeight;
+}
+
+void IncrementalDensity::apply(const LineSeries& line_series, double sign) {
+	assert(line_series.size() >= 1);
+
+	LineRasterizer::rasterize(line_series.data(), line_series.size() + 1, mWidth, mHeight,
+		[&](size_t column, size_t row_begin, size_t row_end)
+		{
+			DensityKernel::mark(&mBits[column * mWordCount], row_begin, row_end);
+
+			if (mTouched[column] != 0) return;
+
+			mTouched[column] = 1;
+			mColumns.push_back(column);
+		});
+
+	for (auto column : mColumns) {
+		const auto bits = &mBits[column * mWordCount];
+
+		size_t count = 0;
+
+		for (size_t word = 0; word < mWordCount; word++) count += std::bitset<64>(bits[word]).count();
+
+		const auto scale = sign / static_cast<double>(count);
+
+		for (size_t word = 0; word < mWordCount; word++) {
+			for (auto value = bits[word]; value != 0; value &= value - 1) {
+				const auto row = word * DENSITY_KERNEL_WORD_BITS + std::bitset<64>((value & (~value + 1)) - 1).count();
+
+				mHeatMap[row * mWidth + column] += scale;
+			}
+
+			bits[word] = 0;
+		}
+
+		mTouched[column] = 0;
+	}
+
+	mColumns.clear();
+}
+
+void IncrementalDensity::update() {
+	//the cost of rebase is shared by the updates since last rebase
+	if (++mUpdateCount >= std::max(mRebaseInterval, mLineSeries.size())) rebase();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Common.hpp"
+#include "LineSeries.hpp"
+#include "LineSeriesBatch.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#define INCREMENTAL_DENSITY_REBASE_INTERVAL 4096
+
+//the heat map of a sliding window of line series, the same density as CpuDensityGenerator
+//adding a series adds its contribution, removing a series subtracts it, so the cost of update only depends on the series
+//the contribution is computed from the points again when the series is removed, it is not stored
+//the heat map is rebuilt from the series in window after some updates to remove the error of float
+class IncrementalDensity {
+public:
+	//the heat map is rebuilt when the number of updates reaches max(rebase_interval, number of series)
+	IncrementalDensity(size_t heatmap_width, size_t heatmap_height,
+		size_t rebase_interval = INCREMENTAL_DENSITY_REBASE_INTERVAL);
+
+	//return the id of series, it is used to remove the series
+	auto add(const LineSeriesView& line_series) -> size_t;
+
+	auto add(const LineSeries& line_series) -> size_t;
+
+	void remove(size_t id);
+
+	//rebuild the heat map from the series in window
+	void rebase();
+
+	//row major, the same layout as the heat map texture
+	auto snapshot() const -> std::vector<real>;
+
+	//the number of series in window
+	auto size() const -> size_t;
+
+	auto width() const -> size_t;
+
+	auto height() const -> size_t;
+private:
+	//add sign / count to the pixels that series marks
+	void apply(const LineSeries& line_series, double sign);
+
+	void update();
+private:
+	std::unordered_map<size_t, LineSeries> mLineSeries;
+
+	size_t mWidth;
+	size_t mHeight;
+	size_t mWordCount;
+
+	size_t mNextId;
+	size_t mUpdateCount;
+	size_t mRebaseInterval;
+
+	//the marks of series, see CpuDensityGenerator
+	std::vector<uint64_t> mBits;
+	std::vector<byte> mTouched;
+	std::vector<size_t> mColumns;
+
+	//row major, double is used to keep the error small between rebases
+	std::vector<double> mHeatMap;
+};
@@ -0,0 +1,510 @@
+#include "LineArchive.hpp"
+#include "LineSeriesBatch.hpp"
+#include "LineBinaryFile.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+#include <atomic>
+#include <cmath>
+
+#undef max
+#undef min
+
+static_assert(sizeof(LineArchiveHeader) == 64, "the header should be 64 bytes.");
+static_assert(sizeof(LineArchiveBlock) == 32, "the block should be 32 bytes.");
+
+//the quantized values are clamped, so the zigzag deltas are less than 2^43
+#define LINE_ARCHIVE_QUANTIZED_LIMIT (static_cast<int64_t>(1) << 41)
+
+//the max bit width of group, the decoder keeps less than 8 bits between values
+#define LINE_ARCHIVE_MAX_BIT_WIDTH 56
+
+#define LINE_ARCHIVE_X_UNIFORM 0
+#define LINE_ARCHIVE_X_PACKED 1
+
+namespace {
+
+	auto zigzag(int64_t value) -> uint64_t {
+		return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+	}
+
+	auto unzigzag(uint64_t value) -> int64_t {
+		return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+	}
+
+	auto quantize(real value, double scale) -> int64_t {
+		const auto result = std::llround(std::clamp(static_cast<double>(value) * scale,
+			-static_cast<double>(LINE_ARCHIVE_QUANTIZED_LIMIT), static_cast<double>(LINE_ARCHIVE_QUANTIZED_LIMIT)));
+
+		return static_cast<int64_t>(result);
+	}
+
+	auto dequantize(int64_t value, double scale) -> real {
+		return static_cast<real>(static_cast<double>(value) / scale);
+	}
+
+	void write_bytes(std::vector<byte>& out, const void* data, size_t size) {
+		out.insert(out.end(), static_cast<const byte*>(data), static_cast<const byte*>(data) + size);
+	}
+
+	void write_varint(std::vector<byte>& out, uint64_t value) {
+		while (value >= 0x80) {
+			out.push_back(static_cast<byte>(value | 0x80));
+
+			value >>= 7;
+		}
+
+		out.push_back(static_cast<byte>(value));
+	}
+
+	//the values are the zigzag deltas, the group size and bit widths are described in LineArchive
+	void write_packed(std::vector<byte>& out, const uint64_t* values, size_t count) {
+		for (size_t group = 0; group < count; group += LINE_ARCHIVE_GROUP_SIZE) {
+			const auto group_end = std::min(group + LINE_ARCHIVE_GROUP_SIZE, count);
+
+			uint64_t bits = 0;
+
+			for (auto index = group; index < group_end; index++) bits |= values[index];
+
+			int bit_width = 0;
+
+			while (bit_width < 64 && (bits >> bit_width) != 0) bit_width++;
+
+			out.push_back(static_cast<byte>(bit_width));
+
+			uint64_t buffer = 0;
+			int buffer_bits = 0;
+
+			for (auto index = group; index < group_end; index++) {
+				buffer |= values[index] << buffer_bits;
+				buffer_bits += bit_width;
+
+				while (buffer_bits >= 8) {
+					out.push_back(static_cast<byte>(buffer));
+
+					buffer >>= 8;
+					buffer_bits -= 8;
+				}
+			}
+
+			if (buffer_bits != 0) out.push_back(static_cast<byte>(buffer));
+		}
+	}
+
+	//the reader of block, all reads are checked, so the broken block is reported instead of reading out of it
+	class BlockReader {
+	public:
+		BlockReader(const byte* begin, const byte* end) : mCurrent(begin), mEnd(end) {}
+
+		bool read_bytes(void* data, size_t size) {
+			if (static_cast<size_t>(mEnd - mCurrent) < size) return false;
+
+			std::copy(mCurrent, mCurrent + size, static_cast<byte*>(data));
+
+			mCurrent += size;
+
+			return true;
+		}
+
+		bool read_varint(uint64_t& value) {
+			value = 0;
+
+			for (int shift = 0; shift < 64; shift += 7) {
+				if (mCurrent == mEnd) return false;
+
+				const auto current = *mCurrent++;
+
+				value |= static_cast<uint64_t>(current & 0x7F) << shift;
+
+				if ((current & 0x80) == 0) return true;
+			}
+
+			return false;
+		}
+
+		bool read_packed(uint64_t* values, size_t count) {
+			for (size_t group = 0; group < count; group += LINE_ARCHIVE_GROUP_SIZE) {
+				const auto group_end = std::min(group + LINE_ARCHIVE_GROUP_SIZE, count);
+
+				if (mCurrent == mEnd) return false;
+
+				const int bit_width = *mCurrent++;
+
+				if (bit_width > LINE_ARCHIVE_MAX_BIT_WIDTH) return false;
+
+				const auto group_bytes = ((group_end - group) * static_cast<size_t>(bit_width) + 7) / 8;
+
+				if (static_cast<size_t>(mEnd - mCurrent) < group_bytes) return false;
+
+				const auto mask = (static_cast<uint64_t>(1) << bit_width) - 1;
+
+				uint64_t buffer = 0;
+				int buffer_bits = 0;
+
+				for (auto index = group; index < group_end; index++) {
+					while (buffer_bits < bit_width) {
+						buffer |= static_cast<uint64_t>(*mCurrent++) << buffer_bits;
+						buffer_bits += 8;
+					}
+
+					values[index] = buffer & mask;
+
+					buffer >>= bit_width;
+					buffer_bits -= bit_width;
+				}
+			}
+
+			return true;
+		}
+
+		auto is_end() const -> bool { return mCurrent == mEnd; }
+	private:
+		const byte* mCurrent;
+		const byte* mEnd;
+	};
+
+	//the x is uniform if all points are in half step of x0 + i * dx
+	//the dx of first line is tried first, it is exact for the data of RandomLineGenerator
+	bool find_uniform_x(const vec2* points, size_t point_count, real tolerance, real& x0, real& dx) {
+		x0 = points[0].x;
+
+		if (point_count == 1) { dx = 0; return true; }
+
+		const real candidates[2] = {
+			points[1].x - points[0].x,
+			(points[point_count - 1].x - points[0].x) / static_cast<real>(point_count - 1)
+		};
+
+		for (auto candidate : candidates) {
+			size_t index = 0;
+
+			while (index < point_count && std::abs(x0 + static_cast<real>(index) * candidate - points[index].x) <= tolerance) index++;
+
+			if (index == point_count) { dx = candidate; return true; }
+		}
+
+		return false;
+	}
+
+	void encode_series(std::vector<byte>& out, const LineSeriesView& series, double scale, std::vector<uint64_t>& values) {
+		const auto points = series.data();
+		const auto point_count = series.size() + 1;
+		const auto color = LineBinaryFile::pack_color(series.color());
+
+		write_varint(out, point_count);
+		write_bytes(out, &color, sizeof(color));
+
+		values.resize(point_count);
+
+		//the x of regularly sampled series is two floats
+		real x0 = 0, dx = 0;
+
+		if (find_uniform_x(points, point_count, static_cast<real>(0.5 / scale), x0, dx) == true) {
+			out.push_back(LINE_ARCHIVE_X_UNIFORM);
+
+			write_bytes(out, &x0, sizeof(x0));
+			write_bytes(out, &dx, sizeof(dx));
+		}
+		else {
+			out.push_back(LINE_ARCHIVE_X_PACKED);
+
+			int64_t last = 0;
+
+			for (size_t index = 0; index < point_count; index++) {
+				const auto value = quantize(points[index].x, scale);
+
+				values[index] = zigzag(value - last);
+				last = value;
+			}
+
+			write_packed(out, values.data(), point_count);
+		}
+
+		int64_t last = 0;
+
+		for (size_t index = 0; index < point_count; index++) {
+			const auto value = quantize(points[index].y, scale);
+
+			values[index] = zigzag(value - last);
+			last = value;
+		}
+
+		write_packed(out, values.data(), point_count);
+	}
+}
+
+LineArchive::LineArchive(const std::string& fileName) :
+	mFile(std::make_shared<MappedFile>(fileName)), mHeader(nullptr), mBlocks(nullptr) {
+
+	if (mFile->is_open() == false || is_little_endian() == false) return;
+	if (mFile->size() < sizeof(LineArchiveHeader)) return;
+
+	const auto header = reinterpret_cast<const LineArchiveHeader*>(mFile->data());
+
+	if (header->Magic != LINE_ARCHIVE_MAGIC || header->Version != LINE_ARCHIVE_VERSION) return;
+	if (header->SubpixelBits > 24 || header->BlocksSection != sizeof(LineArchiveHeader)) return;
+
+	//each block takes 32 bytes and each series takes 6 bytes at least, it also avoids overflow
+	if (header->BlockCount > mFile->size() / sizeof(LineArchiveBlock) || header->SeriesCount > mFile->size()) return;
+	if (header->BlocksSection + sizeof(LineArchiveBlock) * header->BlockCount > mFile->size()) return;
+	if (header->BlockCount == 0 && (header->SeriesCount != 0 || header->PointCount != 0)) return;
+
+	//the blocks are used to place the series in arena, so they should be ordered and in range
+	const auto blocks = reinterpret_cast<const LineArchiveBlock*>(mFile->data() + header->BlocksSection);
+
+	//the data of blocks follow the blocks and do not overlap, so the sizes of blocks sum to the file size at most
+	auto data_begin = header->BlocksSection + sizeof(LineArchiveBlock) * header->BlockCount;
+
+	for (uint64_t index = 0; index < header->BlockCount; index++) {
+		const auto& block = blocks[index];
+
+		const auto series_end = index + 1 == header->BlockCount ? header->SeriesCount : blocks[index + 1].FirstSeries;
+		const auto point_end = index + 1 == header->BlockCount ? header->PointCount : blocks[index + 1].FirstPoint;
+
+		if (block.Offset < data_begin || block.Offset > mFile->size() || block.Size > mFile->size() - block.Offset) return;
+		if (block.FirstSeries > series_end || block.FirstPoint > point_end) return;
+		if (index == 0 && (block.FirstSeries != 0 || block.FirstPoint != 0)) return;
+
+		//the point count is used to allocate the arena before the blocks are decoded, so it is bounded by the size of block
+		//each series takes 6 bytes at least and each group of y takes 1 byte at least
+		if (series_end - block.FirstSeries > block.Size / 6) return;
+		if (series_end == block.FirstSeries && point_end != block.FirstPoint) return;
+		if ((point_end - block.FirstPoint) / LINE_ARCHIVE_GROUP_SIZE > block.Size) return;
+
+		data_begin = block.Offset + block.Size;
+	}
+
+	mHeader = header;
+	mBlocks = blocks;
+}
+
+auto LineArchive::is_open() const -> bool {
+	return mHeader != nullptr;
+}
+
+auto LineArchive::width() const -> size_t {
+	return static_cast<size_t>(mHeader->Width);
+}
+
+auto LineArchive::height() const -> size_t {
+	return static_cast<size_t>(mHeader->Height);
+}
+
+auto LineArchive::series_count() const -> size_t {
+	return static_cast<size_t>(mHeader->SeriesCount);
+}
+
+auto LineArchive::point_count() const -> size_t {
+	return static_cast<size_t>(mHeader->PointCount);
+}
+
+auto LineArchive::block_count() const -> size_t {
+	return static_cast<size_t>(mHeader->BlockCount);
+}
+
+auto LineArchive::block(size_t index) const -> const LineArchiveBlock& {
+	return mBlocks[index];
+}
+
+auto LineArchive::block_series_count(size_t index) const -> size_t {
+	const auto series_end = index + 1 == block_count() ? mHeader->SeriesCount : mBlocks[index + 1].FirstSeries;
+
+	return static_cast<size_t>(series_end - mBlocks[index].FirstSeries);
+}
+
+auto LineArchive::block_point_count(size_t index) const -> size_t {
+	const auto point_end = index + 1 == block_count() ? mHeader->PointCount : mBlocks[index + 1].FirstPoint;
+
+	return static_cast<size_t>(point_end - mBlocks[index].FirstPoint);
+}
+
+bool LineArchive::decode(size_t index, LineSeriesBatch& batch) const {
+	const auto series_count = block_series_count(index);
+
+	std::vector<vec2> points(block_point_count(index));
+	std::vector<uint64_t> offsets(series_count + 1);
+	std::vector<vec4> colors(series_count);
+
+	if (decode(index, points.data(), offsets.data(), colors.data(), 0) == false) return false;
+
+	offsets[series_count] = points.size();
+
+	for (size_t series = 0; series < series_count; series++)
+		batch.push(points.data() + offsets[series], static_cast<size_t>(offsets[series + 1] - offsets[series]), colors[series]);
+
+	return true;
+}
+
+bool LineArchive::read(LineSeriesBatch& batch, size_t thread_count) const {
+	assert(batch.mFile == nullptr);
+
+	batch.mWidth = width();
+	batch.mHeight = height();
+
+	//the blocks know where their series are, so they are decoded into the arena in place
+	batch.mPoints.resize(point_count());
+	batch.mOffsets.resize(series_count() + 1);
+	batch.mColors.resize(series_count());
+
+	batch.mOffsets[series_count()] = point_count();
+
+	std::atomic<bool> result(true);
+
+	ThreadPool thread_pool(std::min(thread_count == 0 ? ThreadPool::hardware_concurrency() : thread_count, std::max(block_count(), static_cast<size_t>(1))));
+
+	thread_pool.parallel_for(block_count(), [&](size_t, size_t index)
+		{
+			const auto& current = mBlocks[index];
+
+			if (decode(index,
+				batch.mPoints.data() + current.FirstPoint,
+				batch.mOffsets.data() + current.FirstSeries,
+				batch.mColors.data() + current.FirstSeries,
+				current.FirstPoint) == false) result = false;
+		});
+
+	return result;
+}
+
+void LineArchive::save(const std::string& fileName, const LineSeriesBatch& batch, size_t subpixel_bits, size_t thread_count) {
+	assert(is_little_endian() == true);
+	assert(subpixel_bits <= 24);
+
+	//the series are split into blocks by the number of points
+	std::vector<LineArchiveBlock> blocks;
+
+	for (size_t index = 0; index < batch.size(); index++) {
+		const auto offset = batch.offsets()[index];
+
+		if (blocks.empty() == true || offset - blocks.back().FirstPoint >= LINE_ARCHIVE_BLOCK_POINTS)
+			blocks.push_back({ 0, 0, index, offset });
+	}
+
+	const auto scale = static_cast<double>(static_cast<uint64_t>(1) << subpixel_bits);
+
+	std::vector<std::vector<byte>> data(blocks.size());
+
+	ThreadPool thread_pool(std::min(thread_count == 0 ? ThreadPool::hardware_concurrency() : thread_count, std::max(blocks.size(), static_cast<size_t>(1))));
+
+	thread_pool.parallel_for(blocks.size(), [&](size_t, size_t index)
+		{
+			const auto series_begin = static_cast<size_t>(blocks[index].FirstSeries);
+			const auto series_end = index + 1 == blocks.size() ? batch.size() : static_cast<size_t>(blocks[index + 1].FirstSeries);
+
+			std::vector<uint64_t> values;
+
+			for (auto series = series_begin; series < series_end; series++)
+				encode_series(data[index], batch[series], scale, values);
+		});
+
+	LineArchiveHeader header;
+
+	header.Magic = LINE_ARCHIVE_MAGIC;
+	header.Version = LINE_ARCHIVE_VERSION;
+	header.Width = batch.width();
+	header.Height = batch.height();
+	header.SeriesCount = batch.size();
+	header.PointCount = batch.point_count();
+	header.BlockCount = blocks.size();
+	header.SubpixelBits = static_cast<uint32_t>(subpixel_bits);
+	header.Reserved = 0;
+	header.BlocksSection = sizeof(LineArchiveHeader);
+
+	auto offset = header.BlocksSection + sizeof(LineArchiveBlock) * header.BlockCount;
+
+	for (size_t index = 0; index < blocks.size(); index++) {
+		blocks[index].Offset = offset;
+		blocks[index].Size = data[index].size();
+
+		offset = offset + blocks[index].Size;
+	}
+
+	std::ofstream file(fileName, std::ios::binary);
+	assert(file.is_open() == true);
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(blocks.data()), static_cast<std::streamsize>(sizeof(LineArchiveBlock) * blocks.size()));
+
+	for (auto& block_data : data)
+		file.write(reinterpret_cast<const char*>(block_data.data()), static_cast<std::streamsize>(block_data.size()));
+
+	file.close();
+}
+
+auto LineArchive::is_archive_file(const std::string& fileName) -> bool {
+	const std::string extension = LINE_ARCHIVE_EXTENSION;
+
+	return fileName.size() >= extension.size() &&
+		fileName.compare(fileName.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+bool LineArchive::decode(size_t index, vec2* points, uint64_t* offsets, vec4* colors, uint64_t base) const {
+	const auto& current = mBlocks[index];
+	const auto series_count = block_series_count(index);
+	const auto point_count = block_point_count(index);
+	const auto scale = static_cast<double>(static_cast<uint64_t>(1) << mHeader->SubpixelBits);
+
+	const auto begin = reinterpret_cast<const byte*>(mFile->data() + current.Offset);
+
+	BlockReader reader(begin, begin + current.Size);
+
+	std::vector<uint64_t> values;
+
+	size_t point = 0;
+
+	for (size_t series = 0; series < series_count; series++) {
+		uint64_t series_point_count = 0;
+		uint32_t color = 0;
+		byte mode = 0;
+
+		if (reader.read_varint(series_point_count) == false || series_point_count == 0) return false;
+		if (series_point_count > point_count - point) return false;
+		if (reader.read_bytes(&color, sizeof(color)) == false) return false;
+		if (reader.read_bytes(&mode, sizeof(mode)) == false) return false;
+
+		const auto count = static_cast<size_t>(series_point_count);
+		const auto target = points + point;
+
+		values.resize(count);
+
+		if (mode == LINE_ARCHIVE_X_UNIFORM) {
+			real x0 = 0, dx = 0;
+
+			if (reader.read_bytes(&x0, sizeof(x0)) == false || reader.read_bytes(&dx, sizeof(dx)) == false) return false;
+
+			for (size_t index = 0; index < count; index++) target[index].x = x0 + static_cast<real>(index) * dx;
+		}
+		else if (mode == LINE_ARCHIVE_X_PACKED) {
+			if (reader.read_packed(values.data(), count) == false) return false;
+
+			int64_t last = 0;
+
+			for (size_t index = 0; index < count; index++) {
+				last = last + unzigzag(values[index]);
+
+				target[index].x = dequantize(last, scale);
+			}
+		}
+		else return false;
+
+		if (reader.read_packed(values.data(), count) == false) return false;
+
+		int64_t last = 0;
+
+		for (size_t index = 0; index < count; index++) {
+			last = last + unzigzag(values[index]);
+
+			target[index].y = dequantize(last, scale);
+		}
+
+		offsets[series] = base + point;
+		colors[series] = LineBinaryFile::unpack_color(color);
+
+		point = point + count;
+	}
+
+	//the points of block should fill the range of block exactly
+	return point == point_count && reader.is_end() == true;
+}
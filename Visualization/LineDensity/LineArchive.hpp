@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Common.hpp"
+#include "MappedFile.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class LineSeriesBatch;
+
+#define LINE_ARCHIVE_MAGIC 0x3141534C //"LSA1"
+#define LINE_ARCHIVE_VERSION 1
+#define LINE_ARCHIVE_EXTENSION ".lsa"
+
+//the points are quantized to 1 / 2^bits pixel of heat map
+#define LINE_ARCHIVE_SUBPIXEL_BITS 8
+
+//a block is closed when it has this number of points, a series is never split
+#define LINE_ARCHIVE_BLOCK_POINTS 65536
+
+//the values of packed sequence are split into groups, each group has its own bit width
+#define LINE_ARCHIVE_GROUP_SIZE 128
+
+//the header of compressed line archive, all values are little-endian
+//the sections are : blocks(LineArchiveBlock * block count), the data of blocks
+struct LineArchiveHeader {
+	uint32_t Magic;
+	uint32_t Version;
+
+	uint64_t Width;
+	uint64_t Height;
+	uint64_t SeriesCount;
+	uint64_t PointCount;
+	uint64_t BlockCount;
+
+	uint32_t SubpixelBits;
+	uint32_t Reserved;
+
+	uint64_t BlocksSection;
+};
+
+//the block is decoded without other blocks, the first series and point are used to place it in the arena
+struct LineArchiveBlock {
+	uint64_t Offset;
+	uint64_t Size;
+	uint64_t FirstSeries;
+	uint64_t FirstPoint;
+};
+
+//the compressed line data file, it is lossy, the points are quantized to the subpixels of heat map
+//series in block : point count(varint), color(RGBA8), x mode(byte), x, y
+//x mode 0 : x is uniform, x0 and dx(float32), the point i is x0 + i * dx
+//x mode 1 : the deltas of quantized x are packed
+//y : the deltas of quantized y are packed
+//packed : the zigzag deltas in groups of LINE_ARCHIVE_GROUP_SIZE, each group is bit width(byte) and the bits of values
+class LineArchive {
+public:
+	explicit LineArchive(const std::string& fileName);
+
+	//the file is mapped and the header and blocks are valid
+	auto is_open() const -> bool;
+
+	auto width() const -> size_t;
+
+	auto height() const -> size_t;
+
+	auto series_count() const -> size_t;
+
+	auto point_count() const -> size_t;
+
+	auto block_count() const -> size_t;
+
+	auto block(size_t index) const -> const LineArchiveBlock&;
+
+	//the number of series of block
+	auto block_series_count(size_t index) const -> size_t;
+
+	//the number of points of block
+	auto block_point_count(size_t index) const -> size_t;
+
+	//decode the block and push the series into batch
+	bool decode(size_t index, LineSeriesBatch& batch) const;
+
+	//decode all blocks into batch with threads, the blocks are independent
+	bool read(LineSeriesBatch& batch, size_t thread_count = 0) const;
+
+	static void save(const std::string& fileName, const LineSeriesBatch& batch,
+		size_t subpixel_bits = LINE_ARCHIVE_SUBPIXEL_BITS, size_t thread_count = 0);
+
+	//the file is line archive if the extension is LINE_ARCHIVE_EXTENSION
+	static auto is_archive_file(const std::string& fileName) -> bool;
+private:
+	//decode the series of block into the arena at the first series and point of block
+	//the offsets are relative to points, base is added to them
+	bool decode(size_t index, vec2* points, uint64_t* offsets, vec4* colors, uint64_t base) const;
+private:
+	std::shared_ptr<MappedFile> mFile;
+
+	const LineArchiveHeader* mHeader;
+	const LineArchiveBlock* mBlocks;
+};
@@ -0,0 +1,159 @@
+#include "LineBinaryFile.hpp"
+#include "LineSeriesBatch.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+#undef max
+#undef min
+
+static_assert(sizeof(vec2) == sizeof(float) * 2, "the points section is used as vec2 array.");
+static_assert(sizeof(LineBinaryFileHeader) == 64, "the header should be 64 bytes.");
+
+namespace {
+
+	auto align(uint64_t value, uint64_t alignment) -> uint64_t {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	//the sections of file, they are aligned to 8 bytes
+	void compute_sections(LineBinaryFileHeader& header) {
+		header.OffsetsSection = sizeof(LineBinaryFileHeader);
+		header.PointsSection = align(header.OffsetsSection + sizeof(uint64_t) * (header.SeriesCount + 1), 8);
+		header.ColorsSection = align(header.PointsSection + sizeof(float) * 2 * header.PointCount, 8);
+	}
+}
+
+LineBinaryFile::LineBinaryFile(const std::string& fileName) :
+	mFile(std::make_shared<MappedFile>(fileName)), mHeader(nullptr) {
+
+	if (mFile->is_open() == false || is_little_endian() == false) return;
+	if (mFile->size() < sizeof(LineBinaryFileHeader)) return;
+
+	const auto header = reinterpret_cast<const LineBinaryFileHeader*>(mFile->data());
+
+	if (header->Magic != LINE_BINARY_FILE_MAGIC || header->Version != LINE_BINARY_FILE_VERSION) return;
+
+	//each series or point takes 8 bytes at least, it also avoids overflow
+	if (header->SeriesCount > mFile->size() / 8 || header->PointCount > mFile->size() / 8) return;
+
+	//the sections should be same as we saved
+	auto expected = *header;
+
+	compute_sections(expected);
+
+	if (expected.OffsetsSection != header->OffsetsSection ||
+		expected.PointsSection != header->PointsSection ||
+		expected.ColorsSection != header->ColorsSection ||
+		expected.ColorsSection + sizeof(uint32_t) * header->SeriesCount > mFile->size()) return;
+
+	//the offsets are used to index the points, so they should be in range
+	//each series has one point at least, the segment count of LineSeriesView is the point count - 1
+	const auto offsets = reinterpret_cast<const uint64_t*>(mFile->data() + header->OffsetsSection);
+
+	if (offsets[0] != 0 || offsets[header->SeriesCount] != header->PointCount) return;
+
+	for (uint64_t index = 0; index < header->SeriesCount; index++)
+		if (offsets[index] >= offsets[index + 1]) return;
+
+	mHeader = header;
+}
+
+auto LineBinaryFile::is_open() const -> bool {
+	return mHeader != nullptr;
+}
+
+auto LineBinaryFile::width() const -> size_t {
+	return static_cast<size_t>(mHeader->Width);
+}
+
+auto LineBinaryFile::height() const -> size_t {
+	return static_cast<size_t>(mHeader->Height);
+}
+
+auto LineBinaryFile::series_count() const -> size_t {
+	return static_cast<size_t>(mHeader->SeriesCount);
+}
+
+auto LineBinaryFile::point_count() const -> size_t {
+	return static_cast<size_t>(mHeader->PointCount);
+}
+
+auto LineBinaryFile::offsets() const -> const uint64_t* {
+	return reinterpret_cast<const uint64_t*>(mFile->data() + mHeader->OffsetsSection);
+}
+
+auto LineBinaryFile::points() const -> const vec2* {
+	return reinterpret_cast<const vec2*>(mFile->data() + mHeader->PointsSection);
+}
+
+auto LineBinaryFile::colors() const -> const uint32_t* {
+	return reinterpret_cast<const uint32_t*>(mFile->data() + mHeader->ColorsSection);
+}
+
+void LineBinaryFile::save(const std::string& fileName, const LineSeriesBatch& batch) {
+	assert(is_little_endian() == true);
+
+	LineBinaryFileHeader header;
+
+	header.Magic = LINE_BINARY_FILE_MAGIC;
+	header.Version = LINE_BINARY_FILE_VERSION;
+	header.Width = batch.width();
+	header.Height = batch.height();
+	header.SeriesCount = batch.size();
+	header.PointCount = batch.point_count();
+
+	compute_sections(header);
+
+	std::ofstream file(fileName, std::ios::binary);
+	assert(file.is_open() == true);
+
+	const uint64_t zero = 0;
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	//offsets section, the batch has the same layout
+	file.write(reinterpret_cast<const char*>(batch.offsets()), static_cast<std::streamsize>(sizeof(uint64_t) * (header.SeriesCount + 1)));
+	file.write(reinterpret_cast<const char*>(&zero), static_cast<std::streamsize>(header.PointsSection - static_cast<uint64_t>(file.tellp())));
+
+	//points section
+	file.write(reinterpret_cast<const char*>(batch.points()), static_cast<std::streamsize>(sizeof(vec2) * header.PointCount));
+	file.write(reinterpret_cast<const char*>(&zero), static_cast<std::streamsize>(header.ColorsSection - static_cast<uint64_t>(file.tellp())));
+
+	//colors section
+	for (size_t index = 0; index < batch.size(); index++) {
+		const auto color = pack_color(batch.colors()[index]);
+
+		file.write(reinterpret_cast<const char*>(&color), sizeof(color));
+	}
+
+	file.close();
+}
+
+auto LineBinaryFile::is_binary_file(const std::string& fileName) -> bool {
+	const std::string extension = LINE_BINARY_FILE_EXTENSION;
+
+	return fileName.size() >= extension.size() &&
+		fileName.compare(fileName.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+auto LineBinaryFile::pack_color(const vec4& color) -> uint32_t {
+	uint32_t result = 0;
+
+	for (int index = 0; index < 4; index++) {
+		const auto value = std::min(std::max(color[index], static_cast<real>(0)), static_cast<real>(1));
+
+		result |= static_cast<uint32_t>(value * 255.0f + 0.5f) << (index * 8);
+	}
+
+	return result;
+}
+
+auto LineBinaryFile::unpack_color(uint32_t color) -> vec4 {
+	vec4 result;
+
+	for (int index = 0; index < 4; index++)
+		result[index] = static_cast<real>((color >> (index * 8)) & 0xFF) / 255.0f;
+
+	return result;
+}
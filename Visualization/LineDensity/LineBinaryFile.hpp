@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Common.hpp"
+#include "MappedFile.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class LineSeriesBatch;
+
+#define LINE_BINARY_FILE_MAGIC 0x3142534C //"LSB1"
+#define LINE_BINARY_FILE_VERSION 1
+#define LINE_BINARY_FILE_EXTENSION ".lsb"
+
+//the header of binary line data file, all values are little-endian
+//the sections are : offsets(uint64 * (series count + 1)), points(float32 x, y * point count), colors(RGBA8 * series count)
+struct LineBinaryFileHeader {
+	uint32_t Magic;
+	uint32_t Version;
+
+	uint64_t Width;
+	uint64_t Height;
+	uint64_t SeriesCount;
+	uint64_t PointCount;
+
+	//the byte offsets of sections from the begin of file
+	uint64_t OffsetsSection;
+	uint64_t PointsSection;
+	uint64_t ColorsSection;
+};
+
+//the binary line data file, it is memory-mapped and used without parsing
+class LineBinaryFile {
+public:
+	explicit LineBinaryFile(const std::string& fileName);
+
+	//the file is mapped and the header is valid
+	auto is_open() const -> bool;
+
+	auto width() const -> size_t;
+
+	auto height() const -> size_t;
+
+	auto series_count() const -> size_t;
+
+	auto point_count() const -> size_t;
+
+	//the points of series i are [offsets()[i], offsets()[i + 1])
+	auto offsets() const -> const uint64_t*;
+
+	auto points() const -> const vec2*;
+
+	auto colors() const -> const uint32_t*;
+
+	static void save(const std::string& fileName, const LineSeriesBatch& batch);
+
+	//the file is binary line data if the extension is LINE_BINARY_FILE_EXTENSION
+	static auto is_binary_file(const std::string& fileName) -> bool;
+
+	static auto pack_color(const vec4& color) -> uint32_t;
+
+	static auto unpack_color(uint32_t color) -> vec4;
+private:
+	std::shared_ptr<MappedFile> mFile;
+
+	const LineBinaryFileHeader* mHeader;
+};
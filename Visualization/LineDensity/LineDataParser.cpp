@@ -0,0 +1,189 @@
+#include "LineDataParser.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+#undef max
+#undef min
+
+namespace {
+
+	struct Chunk {
+		const char* Begin = nullptr;
+		const char* End = nullptr;
+
+		size_t SeriesCount = 0;
+		size_t PointCount = 0;
+
+		bool Valid = true;
+	};
+
+	auto is_blank(char c) -> bool {
+		return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+	}
+
+	auto skip_blank(const char* cursor, const char* end) -> const char* {
+		while (cursor != end && is_blank(*cursor)) cursor++;
+
+		return cursor;
+	}
+
+	auto skip_space(const char* cursor, const char* end) -> const char* {
+		while (cursor != end && (is_blank(*cursor) || *cursor == '\n')) cursor++;
+
+		return cursor;
+	}
+
+	auto line_end(const char* cursor, const char* end) -> const char* {
+		const auto result = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+
+		return result == nullptr ? end : result;
+	}
+
+	//parse the value at cursor, the value should be end with blank or line end
+	template<typename T>
+	bool parse_value(const char*& cursor, const char* end, T& value) {
+		cursor = skip_blank(cursor, end);
+
+		//the stream reader accepts '+', from_chars does not
+		if (cursor != end && *cursor == '+') cursor++;
+
+		const auto result = std::from_chars(cursor, end, value);
+
+		if (result.ec != std::errc()) return false;
+
+		cursor = result.ptr;
+
+		return cursor == end || is_blank(*cursor) || *cursor == '\n';
+	}
+
+	//the first pass, count the series and points of chunk
+	void count_chunk(Chunk& chunk) {
+		for (auto cursor = chunk.Begin; cursor < chunk.End; cursor++) {
+			const auto end = line_end(cursor, chunk.End);
+
+			cursor = skip_blank(cursor, end);
+
+			if (cursor != end) {
+				size_t line_count = 0;
+
+				if (parse_value(cursor, end, line_count) == false) { chunk.Valid = false; return; }
+
+				chunk.SeriesCount++;
+				chunk.PointCount += line_count + 1;
+			}
+
+			cursor = end;
+		}
+	}
+
+	//the second pass, parse the series of chunk into the arena
+	void parse_chunk(Chunk& chunk, vec2* points, uint64_t* offsets, vec4* colors, size_t series_index, size_t point_index) {
+		for (auto cursor = chunk.Begin; cursor < chunk.End; cursor++) {
+			const auto end = line_end(cursor, chunk.End);
+
+			cursor = skip_blank(cursor, end);
+
+			if (cursor != end) {
+				size_t line_count = 0;
+
+				parse_value(cursor, end, line_count);
+
+				offsets[series_index] = point_index;
+
+				for (size_t index = 0; index <= line_count; index++) {
+					auto& point = points[point_index++];
+
+					if (parse_value(cursor, end, point.x) == false ||
+						parse_value(cursor, end, point.y) == false) { chunk.Valid = false; return; }
+				}
+
+				auto& color = colors[series_index++];
+
+				if (parse_value(cursor, end, color.r) == false ||
+					parse_value(cursor, end, color.g) == false ||
+					parse_value(cursor, end, color.b) == false ||
+					parse_value(cursor, end, color.a) == false) { chunk.Valid = false; return; }
+
+				//the series should be end with the line
+				if (skip_blank(cursor, end) != end) { chunk.Valid = false; return; }
+			}
+
+			cursor = end;
+		}
+	}
+}
+
+bool LineDataParser::read(const std::string& fileName, LineSeriesBatch& batch, size_t thread_count) {
+	MappedFile file(fileName);
+
+	if (file.is_open() == false) return false;
+
+	const auto file_end = file.data() + file.size();
+
+	auto cursor = file.data();
+
+	//1st line : number of line series, width and height
+	size_t series_count = 0;
+
+	if (parse_value(cursor = skip_space(cursor, file_end), file_end, series_count) == false ||
+		parse_value(cursor = skip_space(cursor, file_end), file_end, batch.mWidth) == false ||
+		parse_value(cursor = skip_space(cursor, file_end), file_end, batch.mHeight) == false) return false;
+
+	cursor = skip_blank(cursor, file_end);
+
+	if (cursor != file_end && *cursor != '\n') return false;
+
+	ThreadPool thread_pool(thread_count);
+
+	//split the rest into chunks, each chunk starts at the begin of line
+	const auto chunk_count = thread_pool.size() * 4;
+	const auto chunk_size = std::max(static_cast<size_t>(file_end - cursor) / chunk_count, static_cast<size_t>(1));
+
+	std::vector<Chunk> chunks;
+
+	while (cursor < file_end) {
+		Chunk chunk;
+
+		chunk.Begin = cursor;
+		chunk.End = static_cast<size_t>(file_end - cursor) <= chunk_size ? file_end : line_end(cursor + chunk_size, file_end);
+
+		chunks.push_back(chunk);
+
+		cursor = chunk.End;
+	}
+
+	thread_pool.parallel_for(chunks.size(), [&](size_t, size_t index) { count_chunk(chunks[index]); });
+
+	//the offsets of chunks in the arena
+	std::vector<size_t> series_offsets(chunks.size() + 1, 0);
+	std::vector<size_t> point_offsets(chunks.size() + 1, 0);
+
+	for (size_t index = 0; index < chunks.size(); index++) {
+		if (chunks[index].Valid == false) return false;
+
+		series_offsets[index + 1] = series_offsets[index] + chunks[index].SeriesCount;
+		point_offsets[index + 1] = point_offsets[index] + chunks[index].PointCount;
+	}
+
+	//the stream reader only reads the first series_count series
+	if (series_offsets.back() != series_count) return false;
+
+	batch.mPoints.resize(point_offsets.back());
+	batch.mOffsets.resize(series_count + 1);
+	batch.mColors.resize(series_count);
+	batch.mOffsets[series_count] = point_offsets.back();
+
+	thread_pool.parallel_for(chunks.size(), [&](size_t, size_t index)
+		{
+			parse_chunk(chunks[index], batch.mPoints.data(), batch.mOffsets.data(), batch.mColors.data(),
+					series_offsets[index], point_offsets[index]);
+		});
+
+	for (auto& chunk : chunks) if (chunk.Valid == false) return false;
+
+	return true;
+}
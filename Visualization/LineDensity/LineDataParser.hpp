@@ -0,0 +1,14 @@
+#pragma once
+
+#include "Common.hpp"
+#include "LineSeriesBatch.hpp"
+
+#include <string>
+
+//parse the text line data file(see LineSeriesBatch::read_from_file) with threads
+//the file is memory-mapped and split into chunks at line ends, so each series should be in one line
+class LineDataParser {
+public:
+	//return false if the file can not be parsed in this way, the caller should use the stream reader
+	static bool read(const std::string& fileName, LineSeriesBatch& batch, size_t thread_count = 0);
+};
@@ -0,0 +1,58 @@
+#include "LineDecimator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+bool LineDecimator::m4(const vec2* points, size_t point_count, std::vector<vec2>& output) {
+	if (is_monotone(points, point_count) == false) return false;
+
+	output.clear();
+
+	size_t begin = 0;
+
+	//the points of column are continuous, because the series is x-monotone
+	while (begin < point_count) {
+		const auto column = std::floor(points[begin].x);
+
+		size_t end = begin + 1;
+		size_t min_index = begin;
+		size_t max_index = begin;
+
+		for (; end < point_count && std::floor(points[end].x) == column; end++) {
+			if (points[end].y < points[min_index].y) min_index = end;
+			if (points[end].y > points[max_index].y) max_index = end;
+		}
+
+		//keep the points in the order of series
+		size_t indices[4] = { begin, min_index, max_index, end - 1 };
+
+		std::sort(indices, indices + 4);
+
+		for (size_t index = 0; index < 4; index++) {
+			if (index != 0 && indices[index] == indices[index - 1]) continue;
+
+			output.push_back(points[indices[index]]);
+		}
+
+		begin = end;
+	}
+
+	return true;
+}
+
+bool LineDecimator::is_monotone(const vec2* points, size_t point_count) {
+	if (point_count < 2) return true;
+
+	const auto increase = points[0].x <= points[point_count - 1].x;
+
+	for (size_t index = 0; index + 1 < point_count; index++) {
+		const auto start = points[index].x;
+		const auto end = points[index + 1].x;
+
+		//NaN is not monotone
+		if (increase == true && (start <= end) == false) return false;
+		if (increase == false && (start >= end) == false) return false;
+	}
+
+	return true;
+}
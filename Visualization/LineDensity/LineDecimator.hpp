@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <vector>
+
+//the M4 aggregation of line series, keep the first, last, min(y) and max(y) points of each column
+//the column of point is floor(x), the same as LineRasterizer
+//for x-monotone series, the decimated series marks the same pixels as the original series with LineRasterizer:
+//the segments between columns are kept, and the segments in a column cover the same y range
+class LineDecimator {
+public:
+	//return false if the series is not x-monotone, the output is not used in this case
+	//the output has at most 4 points per column
+	static bool m4(const vec2* points, size_t point_count, std::vector<vec2>& output);
+
+	static bool is_monotone(const vec2* points, size_t point_count);
+};
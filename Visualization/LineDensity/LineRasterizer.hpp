@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Common.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#undef max
+#undef min
+
+//rasterize the line strip on CPU
+//a segment marks every pixel it passes through(supercover)
+//so the marked pixels of a column only depend on the part of line strip in the column
+class LineRasterizer {
+public:
+	//mark(column, row_begin, row_end) is called for each span [row_begin, row_end] that the line strip covers
+	//a column may be called more than once, the spans may overlap
+	template<typename MarkFunction>
+	static void rasterize(const vec2* points, size_t point_count, size_t width, size_t height, MarkFunction&& mark);
+private:
+	static auto clamp_index(real value, size_t limit) -> size_t;
+};
+
+template<typename MarkFunction>
+void LineRasterizer::rasterize(const vec2* points, size_t point_count, size_t width, size_t height, MarkFunction&& mark) {
+	const auto real_width = static_cast<real>(width);
+	const auto real_height = static_cast<real>(height);
+
+	for (size_t index = 0; index + 1 < point_count; index++) {
+		auto start = points[index];
+		auto end = points[index + 1];
+
+		if (start.x > end.x) std::swap(start, end);
+
+		//the segment is out of heat map
+		if (end.x < 0 || start.x >= real_width) continue;
+		if (std::max(start.y, end.y) < 0 || std::min(start.y, end.y) >= real_height) continue;
+
+		//the column range is [start.x, end.x), the end point belongs to next segment
+		auto column_begin = static_cast<long long>(std::floor(start.x));
+		auto column_end = static_cast<long long>(std::floor(end.x));
+
+		if (end.x > start.x && static_cast<real>(column_end) == end.x) column_end--;
+
+		column_begin = std::max(column_begin, 0ll);
+		column_end = std::min(column_end, static_cast<long long>(width) - 1);
+
+		const auto slope = end.x > start.x ? (end.y - start.y) / (end.x - start.x) : 0;
+
+		for (auto column = column_begin; column <= column_end; column++) {
+			const auto left = std::max(start.x, static_cast<real>(column));
+			const auto right = std::min(end.x, static_cast<real>(column + 1));
+
+			//use the end points directly, so the same points give the same span
+			const auto left_y = left == start.x ? start.y : start.y + (left - start.x) * slope;
+			const auto right_y = right == end.x ? end.y : start.y + (right - start.x) * slope;
+
+			const auto min_y = std::min(left_y, right_y);
+			const auto max_y = std::max(left_y, right_y);
+
+			if (max_y < 0 || min_y >= real_height) continue;
+
+			mark(static_cast<size_t>(column), clamp_index(min_y, height), clamp_index(max_y, height));
+		}
+	}
+}
+
+inline auto LineRasterizer::clamp_index(real value, size_t limit) -> size_t {
+	if (value <= 0) return 0;
+
+	return std::min(static_cast<size_t>(value), limit - 1);
+}
@@ -1,8 +1,7 @@
 #include "LineSeries.hpp"
 
-#include <fstream>
+#include <algorithm>
 #include <random>
-#include <tuple>
 
 #undef min
 
@@ -28,32 +27,29 @@ auto LineSeries::line(size_t index) -> std::pair<vec2, vec2> {
 }
 
 auto LineSeries::line_transform(size_t index, real width) const -> mat4 {
-	auto matrix = mat4(1);
-
-	const auto end = mLinePoints[index + 1];
-	const auto start = mLinePoints[index];
-	const auto vector = end - start;
-
-	matrix = glm::translate(matrix, vec3(start.x, start.y, 0));
-	matrix = glm::rotate(matrix, glm::atan(vector.y, vector.x), vec3(0, 0, 1));
-	matrix = glm::translate(matrix, vec3(0, -width * 0.5f, 0));
-	matrix = glm::scale(matrix, vec3(glm::length(vector), width, 1));
-
-	return matrix;
+	return segment_transform(mLinePoints[index], mLinePoints[index + 1], width);
 }
 
 auto LineSeries::line_transform_with_scale(size_t index, vec2 scale, real width) const -> mat4 
 {
-	auto matrix = mat4(1);
+	return segment_transform(mLinePoints[index] * scale, mLinePoints[index + 1] * scale, width);
+}
 
-	const auto end = mLinePoints[index + 1] * scale;
-	const auto start = mLinePoints[index] * scale;
+auto LineSeries::segment_transform(vec2 start, vec2 end, real width) -> mat4 {
 	const auto vector = end - start;
+	const auto length = glm::length(vector);
+
+	//the unit normal of segment, same as rotating(0, 1) by atan(y, x) without trig
+	const auto normal = length == 0 ? vec2(0, 1) : vec2(-vector.y, vector.x) / length;
+
+	//x axis is along the segment, y axis is across the segment and the quad is centered on it
+	auto matrix = mat4(1);
 
-	matrix = glm::translate(matrix, vec3(start.x, start.y, 0));
-	matrix = glm::rotate(matrix, glm::atan(vector.y, vector.x), vec3(0, 0, 1));
-	matrix = glm::translate(matrix, vec3(0, -width * 0.5f, 0));
-	matrix = glm::scale(matrix, vec3(glm::length(vector), width, 1));
+	const auto origin = start - normal * (width * 0.5f);
+
+	matrix[0] = vec4(vector.x, vector.y, 0, 0);
+	matrix[1] = vec4(normal.x * width, normal.y * width, 0, 0);
+	matrix[3] = vec4(origin.x, origin.y, 0, 1);
 
 	return matrix;
 }
@@ -72,6 +68,10 @@ auto LineSeries::data() -> vec2* {
 	return mLinePoints.data();
 }
 
+auto LineSeries::data() const -> const vec2* {
+	return mLinePoints.data();
+}
+
 auto LineSeries::random_make(size_t size, real width_limit, real height_limit) -> LineSeries {
 	static std::random_device device;
 	static std::mt19937 engine(0);
@@ -85,53 +85,17 @@ auto LineSeries::random_make(size_t size, real width_limit, real height_limit) -
 	for (size_t i = 0; i <= size; i++) {
 		lines.push_back({
 			i * space,
-			height = Utility::clamp(
+			height = std::clamp(
 				height + std::uniform_real_distribution<real>(-0.5f, 0.5f)(engine) * height_limit * 0.1f, 
 			1.0f, height_limit - 1.0f)
 			});
 	}
 
-	const std::uniform_real_distribution<real> gen_color(0.0f, 1.0f);
+	std::uniform_real_distribution<real> gen_color(0.0f, 1.0f);
 
 	return { lines, vec4(gen_color(engine), gen_color(engine), gen_color(engine), 1.0f) };
 }
 
-auto LineSeries::read_from_file(const std::string& fileName) -> std::tuple<std::vector<LineSeries>, size_t, size_t> {
-	//1th line: (n) number of line series width height
-	//2nd -> (1 + n) th : ni(number of lines) px0 py0 px1 py1 ... px(n + 1) py(n + 1) red green blue alpha
-
-	std::ifstream file;
-	size_t nLineSeries = 0;
-	size_t width = 0;
-	size_t height = 0;
-
-	file.open(fileName);
-	assert(file.is_open() == true);
-
-	file >> nLineSeries >> width >> height;
-
-	std::vector<LineSeries> lineSeries(nLineSeries);
-	for (size_t index = 0; index < nLineSeries; index++) file >> lineSeries[index];
-
-	file.close();
-
-	return std::make_tuple(lineSeries, width, height);
-}
-
-void LineSeries::save_to_file(const std::string& fileName, std::tuple<const std::vector<LineSeries>&, size_t, size_t> data) {
-	std::ofstream file;
-
-	file.open(fileName);
-	assert(file.is_open() == true);
-
-	auto& lineSeries = std::get<0>(data);
-
-	file << lineSeries.size() << " " << std::get<1>(data) << " " << std::get<2>(data) << std::endl;
-	for (auto& lines : lineSeries) file << lines << std::endl;
-	
-	file.close();
-}
-
 std::istream& operator>>(std::istream& in, LineSeries& lineSeries) {
 	size_t nLines = 0;
 
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "Utility.hpp"
+#include "Common.hpp"
 
 #include <vector>
 
@@ -26,17 +26,16 @@ public:
 
 	auto data() -> vec2*;
 
+	auto data() const -> const vec2*;
+
 	friend std::istream& operator>>(std::istream& in, LineSeries& lineSeries);
 
 	friend std::ostream& operator<<(std::ostream& out, const LineSeries& lineSeries);
 
-	static auto random_make(size_t size, real width_limit, real height_limit) -> LineSeries;
-
-	static auto read_from_file(const std::string& fileName) -> 
-		std::tuple<std::vector<LineSeries>, size_t, size_t>;
+	//the transform of unit quad to the line from start to end with width
+	static auto segment_transform(vec2 start, vec2 end, real width) -> mat4;
 
-	static void save_to_file(const std::string& fileName, 
-		std::tuple<const std::vector<LineSeries>&, size_t, size_t> data);
+	static auto random_make(size_t size, real width_limit, real height_limit) -> LineSeries;
 private:
 	std::vector<vec2> mLinePoints;
 	vec4 mColor;
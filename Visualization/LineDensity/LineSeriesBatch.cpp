@@ -0,0 +1,201 @@
+#include "LineSeriesBatch.hpp"
+#include "LineDataParser.hpp"
+#include "LineBinaryFile.hpp"
+#include "LineArchive.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+#undef max
+#undef min
+
+auto LineSeriesView::line_transform(size_t index, real width) const -> mat4 {
+	return LineSeries::segment_transform(mPoints[index], mPoints[index + 1], width);
+}
+
+auto LineSeriesView::line_transform_with_scale(size_t index, vec2 scale, real width) const -> mat4 {
+	return LineSeries::segment_transform(mPoints[index] * scale, mPoints[index + 1] * scale, width);
+}
+
+LineSeriesBatch::LineSeriesBatch(size_t width, size_t height) :
+	mOffsets(1, 0), mWidth(width), mHeight(height) {
+
+}
+
+LineSeriesBatch::LineSeriesBatch(const LineBinaryFile& file) :
+	mFile(std::make_shared<LineBinaryFile>(file)), mWidth(file.width()), mHeight(file.height()) {
+
+	assert(file.is_open() == true);
+
+	//the colors are RGBA8 in file, unpack them once
+	mColors.resize(file.series_count());
+
+	for (size_t index = 0; index < mColors.size(); index++)
+		mColors[index] = LineBinaryFile::unpack_color(file.colors()[index]);
+}
+
+void LineSeriesBatch::reserve(size_t series_count, size_t point_count) {
+	mPoints.reserve(point_count);
+	mOffsets.reserve(series_count + 1);
+	mColors.reserve(series_count);
+}
+
+void LineSeriesBatch::push(const vec2* points, size_t point_count, const vec4& color) {
+	//the mapped batch is read only
+	assert(mFile == nullptr);
+
+	mPoints.insert(mPoints.end(), points, points + point_count);
+	mOffsets.push_back(mPoints.size());
+	mColors.push_back(color);
+}
+
+void LineSeriesBatch::push(const LineSeries& line_series) {
+	push(line_series.data(), line_series.size() + 1, line_series.color());
+}
+
+auto LineSeriesBatch::operator[](size_t index) const -> LineSeriesView {
+	const auto offset = offsets()[index];
+
+	return LineSeriesView(points() + offset, static_cast<size_t>(offsets()[index + 1] - offset), mColors[index]);
+}
+
+auto LineSeriesBatch::size() const -> size_t {
+	return mColors.size();
+}
+
+auto LineSeriesBatch::point_count() const -> size_t {
+	return static_cast<size_t>(offsets()[size()]);
+}
+
+auto LineSeriesBatch::max_point_count() const -> size_t {
+	const auto series_offsets = offsets();
+
+	uint64_t result = 0;
+
+	for (size_t index = 0; index < size(); index++)
+		result = std::max(result, series_offsets[index + 1] - series_offsets[index]);
+
+	return static_cast<size_t>(result);
+}
+
+auto LineSeriesBatch::split(size_t series_begin, size_t series_end, size_t part, size_t part_count) const -> size_t {
+	assert(series_begin <= series_end && series_end <= size() && part <= part_count && part_count != 0);
+
+	if (part == part_count) return series_end;
+
+	const auto series_offsets = offsets();
+	const auto point_begin = series_offsets[series_begin];
+	const auto point = point_begin + (series_offsets[series_end] - point_begin) * part / part_count;
+
+	//the first series that starts at or after the point
+	return static_cast<size_t>(std::lower_bound(series_offsets + series_begin, series_offsets + series_end, point) - series_offsets);
+}
+
+auto LineSeriesBatch::points() const -> const vec2* {
+	return mFile != nullptr ? mFile->points() : mPoints.data();
+}
+
+auto LineSeriesBatch::offsets() const -> const uint64_t* {
+	return mFile != nullptr ? mFile->offsets() : mOffsets.data();
+}
+
+auto LineSeriesBatch::colors() const -> const vec4* {
+	return mColors.data();
+}
+
+auto LineSeriesBatch::width() const -> size_t {
+	return mWidth;
+}
+
+auto LineSeriesBatch::height() const -> size_t {
+	return mHeight;
+}
+
+auto LineSeriesBatch::read_from_file(const std::string& fileName, size_t thread_count) -> std::shared_ptr<LineSeriesBatch> {
+	//the binary line data, the points are used in the mapped file
+	if (LineBinaryFile::is_binary_file(fileName) == true) {
+		LineBinaryFile file(fileName);
+		assert(file.is_open() == true);
+
+		if (file.is_open() == false) return std::make_shared<LineSeriesBatch>();
+
+		return std::make_shared<LineSeriesBatch>(file);
+	}
+
+	//the compressed line archive, the blocks are decoded with threads
+	if (LineArchive::is_archive_file(fileName) == true) {
+		LineArchive file(fileName);
+		assert(file.is_open() == true);
+
+		auto batch = std::make_shared<LineSeriesBatch>();
+
+		if (file.is_open() == false || file.read(*batch, thread_count) == false) return std::make_shared<LineSeriesBatch>();
+
+		return batch;
+	}
+
+	//the fast path, parse the memory-mapped file with threads
+	auto batch = std::make_shared<LineSeriesBatch>();
+
+	if (LineDataParser::read(fileName, *batch, thread_count) == true) return batch;
+
+	//the series is not in one line or the file is not mapped, use the stream reader
+	std::ifstream file;
+	size_t nLineSeries = 0;
+	size_t width = 0;
+	size_t height = 0;
+
+	file.open(fileName);
+	assert(file.is_open() == true);
+
+	file >> nLineSeries >> width >> height;
+
+	batch = std::make_shared<LineSeriesBatch>(width, height);
+
+	LineSeries lineSeries;
+
+	for (size_t index = 0; index < nLineSeries; index++) {
+		file >> lineSeries;
+
+		batch->push(lineSeries);
+	}
+
+	file.close();
+
+	return batch;
+}
+
+void LineSeriesBatch::save_to_file(const std::string& fileName, const LineSeriesBatch& batch) {
+	if (LineBinaryFile::is_binary_file(fileName) == true) {
+		LineBinaryFile::save(fileName, batch);
+
+		return;
+	}
+
+	if (LineArchive::is_archive_file(fileName) == true) {
+		LineArchive::save(fileName, batch);
+
+		return;
+	}
+
+	std::ofstream file;
+
+	file.open(fileName);
+	assert(file.is_open() == true);
+
+	file << batch.size() << " " << batch.width() << " " << batch.height() << std::endl;
+
+	for (size_t index = 0; index < batch.size(); index++) {
+		const auto lines = batch[index];
+
+		//the same format as LineSeries
+		file << lines.size() << " ";
+
+		for (size_t point = 0; point <= lines.size(); point++)
+			file << lines.data()[point].x << " " << lines.data()[point].y << " ";
+
+		file << lines.color().r << " " << lines.color().g << " " << lines.color().b << " " << lines.color().a << std::endl;
+	}
+
+	file.close();
+}
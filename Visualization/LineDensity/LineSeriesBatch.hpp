@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Common.hpp"
+#include "LineSeries.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class LineBinaryFile;
+
+//the view of one line series in LineSeriesBatch, it does not own the points
+class LineSeriesView {
+public:
+	LineSeriesView(const vec2* points, size_t point_count, const vec4& color) :
+		mPoints(points), mPointCount(point_count), mColor(color) {}
+
+	auto line_transform(size_t index, real width = 2.0f) const -> mat4;
+
+	auto line_transform_with_scale(size_t index, vec2 scale, real width = 2.0f) const -> mat4;
+
+	//the number of lines, same as LineSeries::size()
+	auto size() const -> size_t { return mPointCount - 1; }
+
+	auto color() const -> vec4 { return mColor; }
+
+	auto data() const -> const vec2* { return mPoints; }
+private:
+	const vec2* mPoints;
+	size_t mPointCount;
+	vec4 mColor;
+};
+
+//the line series in one arena(CSR layout), the points of series i are [offsets()[i], offsets()[i + 1])
+//the points can be owned by batch or mapped from the binary line file, so the batch is shared by std::shared_ptr
+class LineSeriesBatch {
+public:
+	LineSeriesBatch(size_t width = 0, size_t height = 0);
+
+	//use the points and offsets of file without copy
+	explicit LineSeriesBatch(const LineBinaryFile& file);
+
+	void reserve(size_t series_count, size_t point_count);
+
+	void push(const vec2* points, size_t point_count, const vec4& color);
+
+	void push(const LineSeries& line_series);
+
+	auto operator[](size_t index) const -> LineSeriesView;
+
+	//the number of line series
+	auto size() const -> size_t;
+
+	auto point_count() const -> size_t;
+
+	//the max number of points of series
+	auto max_point_count() const -> size_t;
+
+	//the first series of part when [series_begin, series_end) is split into part_count continuous parts with about the same number of points
+	//the parts only depend on the data, so the results of parts can be summed in a fixed order
+	auto split(size_t series_begin, size_t series_end, size_t part, size_t part_count) const -> size_t;
+
+	auto points() const -> const vec2*;
+
+	auto offsets() const -> const uint64_t*;
+
+	auto colors() const -> const vec4*;
+
+	auto width() const -> size_t;
+
+	auto height() const -> size_t;
+
+	//1th line: (n) number of line series width height
+	//2nd -> (1 + n) th : ni(number of lines) px0 py0 px1 py1 ... px(n + 1) py(n + 1) red green blue alpha
+	//the file with LINE_BINARY_FILE_EXTENSION is binary line file, see LineBinaryFile
+	//the file with LINE_ARCHIVE_EXTENSION is compressed line archive, see LineArchive
+	static auto read_from_file(const std::string& fileName, size_t thread_count = 0) -> std::shared_ptr<LineSeriesBatch>;
+
+	static void save_to_file(const std::string& fileName, const LineSeriesBatch& batch);
+private:
+	std::vector<vec2> mPoints;
+	std::vector<uint64_t> mOffsets;
+	std::vector<vec4> mColors;
+
+	//the mapped binary line file, the points and offsets are in it if it is not null
+	std::shared_ptr<LineBinaryFile> mFile;
+
+	size_t mWidth;
+	size_t mHeight;
+
+	friend class LineDataParser;
+	friend class RandomLineGenerator;
+	friend class LineArchive;
+};
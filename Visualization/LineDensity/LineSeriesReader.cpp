@@ -0,0 +1,129 @@
+#include "LineSeriesReader.hpp"
+#include "LineBinaryFile.hpp"
+#include "LineArchive.hpp"
+
+LineSeriesReader::LineSeriesReader(const std::string& fileName) :
+	mWidth(0), mHeight(0), mSeriesCount(0), mSeriesIndex(0), mBlockIndex(0), mPending(false) {
+
+	if (LineBinaryFile::is_binary_file(fileName) == true) {
+		mBinaryFile = std::make_shared<LineBinaryFile>(fileName);
+
+		if (mBinaryFile->is_open() == false) return;
+
+		mWidth = mBinaryFile->width();
+		mHeight = mBinaryFile->height();
+		mSeriesCount = mBinaryFile->series_count();
+
+		return;
+	}
+
+	if (LineArchive::is_archive_file(fileName) == true) {
+		mArchive = std::make_shared<LineArchive>(fileName);
+
+		if (mArchive->is_open() == false) return;
+
+		mWidth = mArchive->width();
+		mHeight = mArchive->height();
+		mSeriesCount = mArchive->series_count();
+
+		return;
+	}
+
+	//the text file is read by stream, see LineSeriesBatch::read_from_file
+	mTextFile.open(fileName);
+
+	if (mTextFile.is_open() == false) return;
+
+	mTextFile >> mSeriesCount >> mWidth >> mHeight;
+}
+
+auto LineSeriesReader::is_open() const -> bool {
+	if (mArchive != nullptr) return mArchive->is_open();
+
+	return mBinaryFile != nullptr ? mBinaryFile->is_open() : mTextFile.is_open();
+}
+
+bool LineSeriesReader::read(LineSeriesBatch& batch, size_t byte_limit) {
+	size_t bytes = 0;
+	size_t count = 0;
+
+	//the series of archive are compressed in blocks, so the whole block is decoded
+	if (mArchive != nullptr) {
+		while (mSeriesIndex < mSeriesCount) {
+			const auto block_bytes =
+				sizeof(vec2) * mArchive->block_point_count(mBlockIndex) +
+				(sizeof(uint64_t) + sizeof(vec4)) * mArchive->block_series_count(mBlockIndex);
+
+			if (count != 0 && bytes + block_bytes > byte_limit) break;
+
+			//the broken block ends the file, the same as the broken text series
+			if (mArchive->decode(mBlockIndex, batch) == false) { mSeriesCount = mSeriesIndex; break; }
+
+			bytes = bytes + block_bytes;
+			count = count + mArchive->block_series_count(mBlockIndex);
+
+			mSeriesIndex = mSeriesIndex + mArchive->block_series_count(mBlockIndex);
+			mBlockIndex++;
+		}
+
+		return count != 0;
+	}
+
+	//the text file is read until the end of file, the number in header is not used, so the file can be a feed(pipe) of unknown length
+	while (mBinaryFile == nullptr || mSeriesIndex < mSeriesCount) {
+		const vec2* points = nullptr;
+		size_t point_count = 0;
+		vec4 color;
+
+		if (mBinaryFile != nullptr) {
+			const auto offset = mBinaryFile->offsets()[mSeriesIndex];
+
+			points = mBinaryFile->points() + offset;
+			point_count = static_cast<size_t>(mBinaryFile->offsets()[mSeriesIndex + 1] - offset);
+			color = LineBinaryFile::unpack_color(mBinaryFile->colors()[mSeriesIndex]);
+		}
+		else {
+			//the series is kept until next call if the batch is full
+			if (mPending == false) {
+				//do not wait for the next series of feed if the batch is full
+				if (count != 0 && bytes >= byte_limit) break;
+
+				if ((mTextFile >> mLineSeries).fail() == true) { mSeriesCount = mSeriesIndex; break; }
+
+				mPending = true;
+			}
+
+			points = mLineSeries.data();
+			point_count = mLineSeries.size() + 1;
+			color = mLineSeries.color();
+		}
+
+		if (count != 0 && bytes + series_bytes(point_count) > byte_limit) break;
+
+		batch.push(points, point_count, color);
+
+		bytes = bytes + series_bytes(point_count);
+		count = count + 1;
+
+		mSeriesIndex++;
+		mPending = false;
+	}
+
+	return count != 0;
+}
+
+auto LineSeriesReader::width() const -> size_t {
+	return mWidth;
+}
+
+auto LineSeriesReader::height() const -> size_t {
+	return mHeight;
+}
+
+auto LineSeriesReader::series_count() const -> size_t {
+	return mSeriesCount;
+}
+
+auto LineSeriesReader::series_bytes(size_t point_count) -> size_t {
+	return sizeof(vec2) * point_count + sizeof(uint64_t) + sizeof(vec4);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Common.hpp"
+#include "LineSeries.hpp"
+#include "LineSeriesBatch.hpp"
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+class LineArchive;
+
+//read the line data file(text, binary or archive) in chunks, so the file does not need to fit in memory
+//the text file is read until the end of file, so it can be a pipe that is written while reading, the number of series in header can be 0
+class LineSeriesReader {
+public:
+	explicit LineSeriesReader(const std::string& fileName);
+
+	auto is_open() const -> bool;
+
+	//read the next series into batch until the memory of batch reaches byte_limit
+	//at least one series is read, return false if there is no series
+	//the archive is read by blocks, at least one block is read
+	bool read(LineSeriesBatch& batch, size_t byte_limit);
+
+	auto width() const -> size_t;
+
+	auto height() const -> size_t;
+
+	//the number of series of text file is the number in header until the end of file is read, then it is the number of series read
+	auto series_count() const -> size_t;
+
+	//the memory of series in LineSeriesBatch
+	static auto series_bytes(size_t point_count) -> size_t;
+private:
+	std::shared_ptr<LineBinaryFile> mBinaryFile;
+	std::shared_ptr<LineArchive> mArchive;
+	std::ifstream mTextFile;
+
+	LineSeries mLineSeries;
+
+	size_t mWidth;
+	size_t mHeight;
+
+	size_t mSeriesCount;
+	size_t mSeriesIndex;
+	size_t mBlockIndex;
+
+	//the text series is read but not pushed
+	bool mPending;
+};
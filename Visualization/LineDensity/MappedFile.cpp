@@ -0,0 +1,103 @@
+#include "MappedFile.hpp"
+
+#include <cstdint>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& fileName) :
+	mData(nullptr), mSize(0), mFile(nullptr), mMapping(nullptr) {
+#ifdef _WIN32
+	const auto file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE) return;
+
+	LARGE_INTEGER file_size;
+
+	if (GetFileSizeEx(file, &file_size) == FALSE || file_size.QuadPart == 0) {
+		CloseHandle(file);
+
+		return;
+	}
+
+	const auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (mapping == nullptr) {
+		CloseHandle(file);
+
+		return;
+	}
+
+	mData = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+	if (mData == nullptr) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+
+		return;
+	}
+
+	mSize = static_cast<size_t>(file_size.QuadPart);
+	mFile = file;
+	mMapping = mapping;
+#else
+	const auto file = open(fileName.c_str(), O_RDONLY);
+
+	if (file < 0) return;
+
+	struct stat file_state;
+
+	if (fstat(file, &file_state) != 0 || file_state.st_size == 0) {
+		close(file);
+
+		return;
+	}
+
+	const auto data = mmap(nullptr, static_cast<size_t>(file_state.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+	if (data == MAP_FAILED) {
+		close(file);
+
+		return;
+	}
+
+	//the file is read from begin to end
+	madvise(data, static_cast<size_t>(file_state.st_size), MADV_SEQUENTIAL);
+
+	mData = static_cast<const char*>(data);
+	mSize = static_cast<size_t>(file_state.st_size);
+	mFile = reinterpret_cast<void*>(static_cast<intptr_t>(file));
+#endif
+}
+
+MappedFile::~MappedFile() {
+	if (mData == nullptr) return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(mData);
+	CloseHandle(mMapping);
+	CloseHandle(mFile);
+#else
+	munmap(const_cast<char*>(mData), mSize);
+	close(static_cast<int>(reinterpret_cast<intptr_t>(mFile)));
+#endif
+}
+
+auto MappedFile::is_open() const -> bool {
+	return mData != nullptr;
+}
+
+auto MappedFile::data() const -> const char* {
+	return mData;
+}
+
+auto MappedFile::size() const -> size_t {
+	return mSize;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+
+//read-only memory-mapped file, the mapping is released when the object is destroyed
+class MappedFile {
+public:
+	explicit MappedFile(const std::string& fileName);
+
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	//empty file is not mapped
+	auto is_open() const -> bool;
+
+	auto data() const -> const char*;
+
+	auto size() const -> size_t;
+private:
+	const char* mData;
+	size_t mSize;
+
+	void* mFile; //file handle(Windows) or descriptor
+	void* mMapping; //mapping handle(Windows)
+};
@@ -0,0 +1,213 @@
+#include "PyramidDensityGenerator.hpp"
+#include "LineRasterizer.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+#undef max
+#undef min
+
+PyramidDensityGenerator::PyramidDensityGenerator(
+	const std::shared_ptr<const LineSeriesBatch>& line_series,
+	size_t heatmap_width, size_t heatmap_height,
+	size_t level_count,
+	size_t thread_count,
+	DensityKernelType kernel_type) :
+	mLineSeries(line_series), mThreadPool(thread_count), mKernel(kernel_type) {
+
+	const auto max_count = max_level_count(heatmap_width, heatmap_height);
+
+	level_count = level_count == 0 ? max_count : std::min(level_count, max_count);
+
+	for (size_t index = 0; index < level_count; index++) {
+		Level level;
+
+		level.Width = index == 0 ? heatmap_width : (mLevels.back().Width + 1) / 2;
+		level.Height = index == 0 ? heatmap_height : (mLevels.back().Height + 1) / 2;
+		level.WordCount = DensityKernel::word_count(level.Height);
+
+		mLevels.push_back(level);
+	}
+
+	mScratches.resize(mThreadPool.size(), Scratch(mLevels.size()));
+}
+
+void PyramidDensityGenerator::run() {
+	for (auto& scratch : mScratches) {
+		for (size_t index = 0; index < mLevels.size(); index++) {
+			const auto& level = mLevels[index];
+
+			scratch[index].Bits.assign(level.Width * level.WordCount, 0);
+			scratch[index].Touched.assign(level.Width, 0);
+			scratch[index].HeatMap.assign(level.Width * level.WordCount * DENSITY_KERNEL_WORD_BITS, 0);
+		}
+	}
+
+	//each part of series accumulates into its own levels, see CpuDensityGenerator
+	const auto part_count = mScratches.size();
+
+	mThreadPool.parallel_for(part_count, [&](size_t, size_t part)
+		{
+			const auto series_end = mLineSeries->split(0, mLineSeries->size(), part + 1, part_count);
+
+			for (auto index = mLineSeries->split(0, mLineSeries->size(), part, part_count); index < series_end; index++)
+				run_line_series((*mLineSeries)[index], mScratches[part]);
+		});
+
+	for (size_t index = 0; index < mLevels.size(); index++) reduce(index);
+
+	for (auto& scratch : mScratches) {
+		for (auto& level : scratch) {
+			level.Bits = std::vector<uint64_t>();
+			level.HeatMap = std::vector<real>();
+		}
+	}
+}
+
+void PyramidDensityGenerator::save(const std::string& prefix, size_t tile_size) const {
+	std::ofstream manifest(prefix + ".txt");
+	assert(manifest.is_open() == true);
+
+	manifest << mLevels.size() << " " << tile_size << std::endl;
+
+	for (size_t index = 0; index < mLevels.size(); index++) {
+		const auto& level = mLevels[index];
+
+		real max_density = 0;
+
+		for (auto density : level.HeatMap) max_density = std::max(max_density, density);
+
+		manifest << level.Width << " " << level.Height << " " << max_density << std::endl;
+
+		for (size_t tile_y = 0; tile_y * tile_size < level.Height; tile_y++) {
+			for (size_t tile_x = 0; tile_x * tile_size < level.Width; tile_x++) {
+				const auto column_begin = tile_x * tile_size;
+				const auto column_end = std::min(column_begin + tile_size, level.Width);
+				const auto row_end = std::min((tile_y + 1) * tile_size, level.Height);
+
+				std::ofstream file(prefix + "_" + std::to_string(index) + "_" +
+					std::to_string(tile_x) + "_" + std::to_string(tile_y) + ".bin", std::ios::binary);
+				assert(file.is_open() == true);
+
+				for (auto row = tile_y * tile_size; row < row_end; row++) {
+					file.write(reinterpret_cast<const char*>(&level.HeatMap[row * level.Width + column_begin]),
+						static_cast<std::streamsize>(sizeof(real) * (column_end - column_begin)));
+				}
+			}
+		}
+	}
+}
+
+auto PyramidDensityGenerator::data() const -> const std::shared_ptr<const LineSeriesBatch>& {
+	return mLineSeries;
+}
+
+auto PyramidDensityGenerator::heatmap(size_t level) const -> const std::vector<real>& {
+	return mLevels[level].HeatMap;
+}
+
+auto PyramidDensityGenerator::width(size_t level) const -> size_t {
+	return mLevels[level].Width;
+}
+
+auto PyramidDensityGenerator::height(size_t level) const -> size_t {
+	return mLevels[level].Height;
+}
+
+auto PyramidDensityGenerator::level_count() const -> size_t {
+	return mLevels.size();
+}
+
+auto PyramidDensityGenerator::kernel() const -> DensityKernelType {
+	return mKernel.type();
+}
+
+auto PyramidDensityGenerator::max_level_count(size_t width, size_t height) -> size_t {
+	size_t count = 1;
+
+	while (width > 1 || height > 1) {
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+		count++;
+	}
+
+	return count;
+}
+
+void PyramidDensityGenerator::run_line_series(const LineSeriesView& line_series, Scratch& scratch) const {
+	assert(line_series.size() >= 1);
+
+	auto& finest = scratch[0];
+
+	const auto word_count = mLevels[0].WordCount;
+
+	//draw pass, only the finest level is rasterized
+	LineRasterizer::rasterize(line_series.data(), line_series.size() + 1, mLevels[0].Width, mLevels[0].Height,
+		[&](size_t column, size_t row_begin, size_t row_end)
+		{
+			DensityKernel::mark(&finest.Bits[column * word_count], row_begin, row_end);
+
+			if (finest.Touched[column] != 0) return;
+
+			finest.Touched[column] = 1;
+			finest.Columns.push_back(column);
+		});
+
+	//reduce pass, the column i of level is the or of column 2i and 2i + 1 of finer level
+	for (size_t index = 1; index < mLevels.size(); index++) {
+		const auto& finer = scratch[index - 1];
+		auto& coarser = scratch[index];
+
+		const auto finer_word_count = mLevels[index - 1].WordCount;
+		const auto coarser_word_count = mLevels[index].WordCount;
+
+		for (auto column : finer.Columns) {
+			const auto target = column / 2;
+
+			DensityKernel::halve(&finer.Bits[column * finer_word_count], finer_word_count,
+				&coarser.Bits[target * coarser_word_count]);
+
+			if (coarser.Touched[target] != 0) continue;
+
+			coarser.Touched[target] = 1;
+			coarser.Columns.push_back(target);
+		}
+	}
+
+	//merge pass, each level is normalized by its own column count
+	for (size_t index = 0; index < mLevels.size(); index++) {
+		auto& level = scratch[index];
+
+		const auto level_word_count = mLevels[index].WordCount;
+		const auto column_height = level_word_count * DENSITY_KERNEL_WORD_BITS;
+
+		for (auto column : level.Columns) {
+			mKernel.merge(&level.Bits[column * level_word_count], level_word_count, &level.HeatMap[column * column_height]);
+
+			level.Touched[column] = 0;
+		}
+
+		level.Columns.clear();
+	}
+}
+
+void PyramidDensityGenerator::reduce(size_t level) {
+	auto& target_level = mLevels[level];
+
+	const auto column_height = target_level.WordCount * DENSITY_KERNEL_WORD_BITS;
+
+	target_level.HeatMap.resize(target_level.Width * target_level.Height);
+
+	//sum the column major heat maps of parts into the row major heat map in the order of parts, each row is a task
+	mThreadPool.parallel_for(target_level.Height, [&](size_t, size_t row)
+		{
+			const auto target = &target_level.HeatMap[row * target_level.Width];
+
+			std::fill(target, target + target_level.Width, static_cast<real>(0));
+
+			for (auto& scratch : mScratches) {
+				for (size_t column = 0; column < target_level.Width; column++)
+					target[column] += scratch[level].HeatMap[column * column_height + row];
+			}
+		});
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Common.hpp"
+#include "LineSeriesBatch.hpp"
+#include "DensityKernel.hpp"
+#include "ThreadPool.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#define PYRAMID_TILE_SIZE 256
+
+//build the heat maps of all levels with one pass, the level i has size ceil(width / 2^i) x ceil(height / 2^i)
+//the series is rasterized at level 0 only, the marks of level i + 1 are the or of 2x2 marks of level i
+//each level adds 1 / count to the pixels a series marks, count is the number of marked pixels in the column of that level
+class PyramidDensityGenerator {
+public:
+	//0 means all levels until the heat map is 1x1
+	PyramidDensityGenerator(
+		const std::shared_ptr<const LineSeriesBatch>& line_series,
+		size_t heatmap_width, size_t heatmap_height,
+		size_t level_count = 0,
+		size_t thread_count = 0,
+		DensityKernelType kernel_type = DensityKernel::detect());
+
+	void run();
+
+	//save the levels as tiles with tile_size x tile_size pixels and a manifest
+	//manifest(prefix.txt) : 1st line is the number of levels and tile size, the next lines are width, height and max density of levels
+	//tile(prefix_level_x_y.bin) : the density of tile in row major float32, the tile at edge is smaller
+	void save(const std::string& prefix, size_t tile_size = PYRAMID_TILE_SIZE) const;
+
+	auto data() const -> const std::shared_ptr<const LineSeriesBatch>&;
+
+	//row major, the same layout as the heat map texture
+	auto heatmap(size_t level) const -> const std::vector<real>&;
+
+	auto width(size_t level)const -> size_t;
+
+	auto height(size_t level)const -> size_t;
+
+	auto level_count()const -> size_t;
+
+	auto kernel()const -> DensityKernelType;
+
+	static auto max_level_count(size_t width, size_t height) -> size_t;
+private:
+	struct Level {
+		size_t Width;
+		size_t Height;
+		size_t WordCount;
+
+		std::vector<real> HeatMap;
+	};
+
+	//the marks of one line series at one level, see CpuDensityGenerator
+	struct LevelScratch {
+		std::vector<uint64_t> Bits;
+		std::vector<byte> Touched;
+		std::vector<size_t> Columns;
+
+		std::vector<real> HeatMap;
+	};
+
+	using Scratch = std::vector<LevelScratch>;
+
+	void run_line_series(const LineSeriesView& line_series, Scratch& scratch) const;
+
+	void reduce(size_t level);
+private:
+	std::shared_ptr<const LineSeriesBatch> mLineSeries;
+
+	ThreadPool mThreadPool;
+	DensityKernel mKernel;
+
+	std::vector<Level> mLevels;
+	std::vector<Scratch> mScratches;
+};
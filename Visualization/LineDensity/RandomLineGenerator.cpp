@@ -0,0 +1,84 @@
+#include "RandomLineGenerator.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+#undef max
+#undef min
+
+//the number of series generated by one task
+#define RANDOM_LINE_GENERATOR_TASK_SIZE 1024
+
+auto RandomLineGenerator::make(size_t series_count, size_t line_count, size_t width, size_t height,
+	uint64_t seed, size_t thread_count) -> std::shared_ptr<LineSeriesBatch> {
+
+	assert(line_count >= 1);
+
+	auto batch = std::make_shared<LineSeriesBatch>(width, height);
+
+	const auto point_count = line_count + 1;
+
+	//all series have the same size, so the arena is filled in place
+	batch->mPoints.resize(series_count * point_count);
+	batch->mOffsets.resize(series_count + 1);
+	batch->mColors.resize(series_count);
+
+	const auto width_limit = static_cast<real>(width);
+	const auto height_limit = static_cast<real>(height);
+	const auto space = width_limit / static_cast<real>(line_count);
+
+	ThreadPool thread_pool(thread_count);
+
+	const auto task_count = (series_count + RANDOM_LINE_GENERATOR_TASK_SIZE - 1) / RANDOM_LINE_GENERATOR_TASK_SIZE;
+
+	thread_pool.parallel_for(task_count, [&](size_t, size_t task)
+		{
+			const auto series_begin = task * RANDOM_LINE_GENERATOR_TASK_SIZE;
+			const auto series_end = std::min(series_begin + RANDOM_LINE_GENERATOR_TASK_SIZE, series_count);
+
+			for (auto series = series_begin; series < series_end; series++) {
+				auto points = &batch->mPoints[series * point_count];
+
+				const auto series_key = key(seed, series);
+
+				uint64_t counter = 0;
+
+				auto y = 0.0f;
+
+				for (size_t index = 0; index < point_count; index++) {
+					y = std::clamp(
+						y + (uniform(series_key, counter++) - 0.5f) * height_limit * 0.1f,
+						1.0f, height_limit - 1.0f);
+
+					points[index] = vec2(index * space, y);
+				}
+
+				batch->mOffsets[series] = series * point_count;
+				batch->mColors[series] = vec4(
+					uniform(series_key, counter),
+					uniform(series_key, counter + 1),
+					uniform(series_key, counter + 2), 1.0f);
+			}
+		});
+
+	batch->mOffsets[series_count] = series_count * point_count;
+
+	return batch;
+}
+
+auto RandomLineGenerator::key(uint64_t seed, uint64_t series) -> uint64_t {
+	//the series is mixed before seed, so the streams of near series are not correlated
+	return split_mix(seed ^ split_mix(series));
+}
+
+auto RandomLineGenerator::uniform(uint64_t key, uint64_t counter) -> real {
+	return static_cast<real>(split_mix(key + counter * 0x9E3779B97F4A7C15ull) >> 40) * (1.0f / 16777216.0f);
+}
+
+auto RandomLineGenerator::split_mix(uint64_t value) -> uint64_t {
+	value = value + 0x9E3779B97F4A7C15ull;
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+
+	return value ^ (value >> 31);
+}
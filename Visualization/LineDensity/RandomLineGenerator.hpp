@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Common.hpp"
+#include "LineSeriesBatch.hpp"
+
+#include <cstdint>
+#include <memory>
+
+//the random line series with the same shape as LineSeries::random_make, generated in parallel
+//the random numbers of series i come from SplitMix64 keyed by (seed, i) and a counter, so the series does not depend on
+//the other series or the threads, the batch is the same for the same seed with any thread count
+class RandomLineGenerator {
+public:
+	//each series has line_count lines, x is uniform in [0, width) and y is a random walk in [1, height - 1]
+	static auto make(size_t series_count, size_t line_count, size_t width, size_t height,
+		uint64_t seed = 0, size_t thread_count = 0) -> std::shared_ptr<LineSeriesBatch>;
+
+	//the key of random numbers of series
+	static auto key(uint64_t seed, uint64_t series) -> uint64_t;
+
+	//the counter-th random number of key in [0, 1), 24 bits
+	static auto uniform(uint64_t key, uint64_t counter) -> real;
+
+	static auto split_mix(uint64_t value) -> uint64_t;
+};
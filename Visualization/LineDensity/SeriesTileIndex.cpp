@@ -0,0 +1,294 @@
+#include "SeriesTileIndex.hpp"
+#include "LineRasterizer.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#undef max
+#undef min
+
+static_assert(sizeof(SeriesTileIndexHeader) == 64, "the header should be 64 bytes.");
+
+namespace {
+
+	//the tiles that a series touches, it is reused by the series that run on the same thread
+	struct Scratch {
+		std::vector<byte> Touched;
+		std::vector<uint32_t> Tiles;
+
+		//the (tile, series) pairs of this thread
+		std::vector<std::pair<uint32_t, uint32_t>> Entries;
+	};
+
+	auto compute_ids_section(uint64_t tile_count) -> uint64_t {
+		return sizeof(SeriesTileIndexHeader) + sizeof(uint64_t) * (tile_count + 1);
+	}
+}
+
+SeriesTileIndex::SeriesTileIndex(
+	const std::shared_ptr<const LineSeriesBatch>& line_series,
+	size_t heatmap_width, size_t heatmap_height,
+	size_t tile_size,
+	size_t thread_count) :
+	mLineSeries(line_series),
+	mWidth(heatmap_width), mHeight(heatmap_height), mSeriesCount(line_series->size()), mTileSize(tile_size),
+	mTileColumns((heatmap_width + tile_size - 1) / tile_size),
+	mTileRows((heatmap_height + tile_size - 1) / tile_size), mOpen(true) {
+
+	assert(mTileSize != 0 && mLineSeries->size() <= UINT32_MAX);
+
+	const auto tile_count = mTileColumns * mTileRows;
+
+	ThreadPool thread_pool(thread_count);
+
+	std::vector<Scratch> scratches(thread_pool.size());
+
+	for (auto& scratch : scratches) scratch.Touched.resize(tile_count, 0);
+
+	//rasterize the series and record the tiles they touch
+	thread_pool.parallel_for(mLineSeries->size(), [&](size_t thread_index, size_t index)
+		{
+			auto& scratch = scratches[thread_index];
+
+			const auto lines = (*mLineSeries)[index];
+
+			LineRasterizer::rasterize(lines.data(), lines.size() + 1, mWidth, mHeight,
+				[&](size_t column, size_t row_begin, size_t row_end)
+				{
+					for (auto row = row_begin / mTileSize; row <= row_end / mTileSize; row++) {
+						const auto tile = row * mTileColumns + column / mTileSize;
+
+						if (scratch.Touched[tile] != 0) continue;
+
+						scratch.Touched[tile] = 1;
+						scratch.Tiles.push_back(static_cast<uint32_t>(tile));
+					}
+				});
+
+			for (auto tile : scratch.Tiles) {
+				scratch.Entries.push_back(std::make_pair(tile, static_cast<uint32_t>(index)));
+				scratch.Touched[tile] = 0;
+			}
+
+			scratch.Tiles.clear();
+		});
+
+	//counting sort the entries by tile
+	mOffsets.resize(tile_count + 1, 0);
+
+	for (auto& scratch : scratches)
+		for (auto& entry : scratch.Entries) mOffsets[entry.first + 1]++;
+
+	for (size_t tile = 0; tile < tile_count; tile++) mOffsets[tile + 1] += mOffsets[tile];
+
+	mIds.resize(static_cast<size_t>(mOffsets[tile_count]));
+
+	auto cursors = mOffsets;
+
+	for (auto& scratch : scratches) {
+		for (auto& entry : scratch.Entries) mIds[static_cast<size_t>(cursors[entry.first]++)] = entry.second;
+
+		scratch.Entries = std::vector<std::pair<uint32_t, uint32_t>>();
+	}
+
+	//the series are run in any order, so the ids of tile should be sorted
+	thread_pool.parallel_for(tile_count, [&](size_t, size_t tile)
+		{
+			std::sort(mIds.begin() + static_cast<ptrdiff_t>(mOffsets[tile]), mIds.begin() + static_cast<ptrdiff_t>(mOffsets[tile + 1]));
+		});
+}
+
+SeriesTileIndex::SeriesTileIndex(const std::string& fileName, const std::shared_ptr<const LineSeriesBatch>& line_series,
+	size_t heatmap_width, size_t heatmap_height) :
+	mLineSeries(line_series), mFile(std::make_shared<MappedFile>(fileName)),
+	mWidth(0), mHeight(0), mSeriesCount(0), mTileSize(0), mTileColumns(0), mTileRows(0), mOpen(false) {
+
+	if (mFile->is_open() == false || mFile->size() < sizeof(SeriesTileIndexHeader)) return;
+
+	const auto header = reinterpret_cast<const SeriesTileIndexHeader*>(mFile->data());
+
+	if (header->Magic != SERIES_TILE_INDEX_MAGIC || header->Version != SERIES_TILE_INDEX_VERSION || header->TileSize == 0) return;
+
+	//the index of other data gives wrong series or reads the series out of range when the edges are checked
+	if (line_series != nullptr && header->SeriesCount != line_series->size()) return;
+	if (heatmap_width != 0 && header->Width != heatmap_width) return;
+	if (heatmap_height != 0 && header->Height != heatmap_height) return;
+
+	const auto tile_columns = header->Width / header->TileSize + (header->Width % header->TileSize != 0 ? 1 : 0);
+	const auto tile_rows = header->Height / header->TileSize + (header->Height % header->TileSize != 0 ? 1 : 0);
+
+	//each tile takes 8 bytes at least, it also avoids overflow
+	if (tile_columns > mFile->size() / 8 || tile_rows > mFile->size() / 8) return;
+
+	const auto tile_count = tile_columns * tile_rows;
+
+	if (tile_count > mFile->size() / 8) return;
+
+	if (header->OffsetsSection != sizeof(SeriesTileIndexHeader) ||
+		header->IdsSection != compute_ids_section(tile_count) ||
+		header->EntryCount > mFile->size() / sizeof(uint32_t) ||
+		header->IdsSection + sizeof(uint32_t) * header->EntryCount > mFile->size()) return;
+
+	//the offsets are used to index the ids, so they should be in range
+	const auto offsets = reinterpret_cast<const uint64_t*>(mFile->data() + header->OffsetsSection);
+
+	if (offsets[0] != 0 || offsets[tile_count] != header->EntryCount) return;
+
+	for (uint64_t tile = 0; tile < tile_count; tile++)
+		if (offsets[tile] > offsets[tile + 1]) return;
+
+	const auto ids = reinterpret_cast<const uint32_t*>(mFile->data() + header->IdsSection);
+
+	for (uint64_t entry = 0; entry < header->EntryCount; entry++)
+		if (ids[entry] >= header->SeriesCount) return;
+
+	mWidth = static_cast<size_t>(header->Width);
+	mHeight = static_cast<size_t>(header->Height);
+	mSeriesCount = static_cast<size_t>(header->SeriesCount);
+	mTileSize = static_cast<size_t>(header->TileSize);
+	mTileColumns = (mWidth + mTileSize - 1) / mTileSize;
+	mTileRows = (mHeight + mTileSize - 1) / mTileSize;
+	mOpen = true;
+}
+
+auto SeriesTileIndex::is_open() const -> bool {
+	return mOpen;
+}
+
+auto SeriesTileIndex::query(size_t column_begin, size_t row_begin, size_t column_end, size_t row_end) const -> std::vector<uint32_t> {
+	column_end = std::min(column_end, mWidth);
+	row_end = std::min(row_end, mHeight);
+
+	if (column_begin >= column_end || row_begin >= row_end) return {};
+
+	std::vector<uint32_t> result;
+	std::vector<uint32_t> candidates;
+
+	for (auto tile_row = row_begin / mTileSize; tile_row <= (row_end - 1) / mTileSize; tile_row++) {
+		for (auto tile_column = column_begin / mTileSize; tile_column <= (column_end - 1) / mTileSize; tile_column++) {
+			const auto tile = tile_row * mTileColumns + tile_column;
+
+			//the tile is in the rectangle, so the series in it mark the rectangle
+			const auto inside =
+				tile_column * mTileSize >= column_begin && std::min((tile_column + 1) * mTileSize, mWidth) <= column_end &&
+				tile_row * mTileSize >= row_begin && std::min((tile_row + 1) * mTileSize, mHeight) <= row_end;
+
+			auto& target = inside == true ? result : candidates;
+
+			target.insert(target.end(), ids() + offsets()[tile], ids() + offsets()[tile + 1]);
+		}
+	}
+
+	std::sort(result.begin(), result.end());
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+
+	std::sort(candidates.begin(), candidates.end());
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+	//the series at the edge are checked with their points
+	std::vector<uint32_t> edges;
+
+	std::set_difference(candidates.begin(), candidates.end(), result.begin(), result.end(), std::back_inserter(edges));
+
+	if (mLineSeries != nullptr) {
+		edges.erase(std::remove_if(edges.begin(), edges.end(), [&](uint32_t id)
+			{
+				return intersect((*mLineSeries)[id], mWidth, mHeight, column_begin, row_begin, column_end, row_end) == false;
+			}), edges.end());
+	}
+
+	std::vector<uint32_t> merged;
+
+	std::merge(result.begin(), result.end(), edges.begin(), edges.end(), std::back_inserter(merged));
+
+	return merged;
+}
+
+void SeriesTileIndex::save(const std::string& fileName) const {
+	const auto tile_count = mTileColumns * mTileRows;
+
+	SeriesTileIndexHeader header;
+
+	header.Magic = SERIES_TILE_INDEX_MAGIC;
+	header.Version = SERIES_TILE_INDEX_VERSION;
+	header.Width = mWidth;
+	header.Height = mHeight;
+	header.TileSize = mTileSize;
+	header.SeriesCount = mSeriesCount;
+	header.EntryCount = offsets()[tile_count];
+	header.OffsetsSection = sizeof(SeriesTileIndexHeader);
+	header.IdsSection = compute_ids_section(tile_count);
+
+	std::ofstream file(fileName, std::ios::binary);
+	assert(file.is_open() == true);
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(offsets()), static_cast<std::streamsize>(sizeof(uint64_t) * (tile_count + 1)));
+	file.write(reinterpret_cast<const char*>(ids()), static_cast<std::streamsize>(sizeof(uint32_t) * header.EntryCount));
+
+	file.close();
+}
+
+auto SeriesTileIndex::width() const -> size_t {
+	return mWidth;
+}
+
+auto SeriesTileIndex::height() const -> size_t {
+	return mHeight;
+}
+
+auto SeriesTileIndex::series_count() const -> size_t {
+	return mSeriesCount;
+}
+
+auto SeriesTileIndex::tile_size() const -> size_t {
+	return mTileSize;
+}
+
+auto SeriesTileIndex::tile_columns() const -> size_t {
+	return mTileColumns;
+}
+
+auto SeriesTileIndex::tile_rows() const -> size_t {
+	return mTileRows;
+}
+
+auto SeriesTileIndex::offsets() const -> const uint64_t* {
+	if (mFile == nullptr) return mOffsets.data();
+
+	return reinterpret_cast<const uint64_t*>(mFile->data() + sizeof(SeriesTileIndexHeader));
+}
+
+auto SeriesTileIndex::ids() const -> const uint32_t* {
+	if (mFile == nullptr) return mIds.data();
+
+	return reinterpret_cast<const uint32_t*>(mFile->data() + compute_ids_section(mTileColumns * mTileRows));
+}
+
+bool SeriesTileIndex::intersect(const LineSeriesView& line_series, size_t width, size_t height,
+	size_t column_begin, size_t row_begin, size_t column_end, size_t row_end) {
+	bool result = false;
+
+	const auto points = line_series.data();
+
+	//only the segments whose bounding box overlaps the rectangle are rasterized
+	for (size_t index = 0; index < line_series.size() && result == false; index++) {
+		const auto start = points[index];
+		const auto end = points[index + 1];
+
+		if (std::max(start.x, end.x) < static_cast<real>(column_begin) || std::min(start.x, end.x) >= static_cast<real>(column_end)) continue;
+		if (std::max(start.y, end.y) < static_cast<real>(row_begin) || std::min(start.y, end.y) >= static_cast<real>(row_end)) continue;
+
+		LineRasterizer::rasterize(points + index, 2, width, height,
+			[&](size_t column, size_t span_begin, size_t span_end)
+			{
+				if (column < column_begin || column >= column_end) return;
+
+				if (span_end >= row_begin && span_begin < row_end) result = true;
+			});
+	}
+
+	return result;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Common.hpp"
+#include "LineSeriesBatch.hpp"
+#include "MappedFile.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define SERIES_TILE_INDEX_MAGIC 0x31495354 //"TSI1"
+#define SERIES_TILE_INDEX_VERSION 1
+#define SERIES_TILE_INDEX_TILE_SIZE 16
+
+//the header of series tile index file, all values are little-endian
+//the sections are : offsets(uint64 * (tile count + 1)), ids(uint32 * entry count)
+struct SeriesTileIndexHeader {
+	uint32_t Magic;
+	uint32_t Version;
+
+	uint64_t Width;
+	uint64_t Height;
+	uint64_t TileSize;
+	uint64_t SeriesCount;
+	uint64_t EntryCount;
+
+	//the byte offsets of sections from the begin of file
+	uint64_t OffsetsSection;
+	uint64_t IdsSection;
+};
+
+//the ids of series that mark the pixels of each tile, the pixels are the same as CpuDensityGenerator
+//the ids of tile i are [offsets()[i], offsets()[i + 1]) in ids(), they are sorted
+class SeriesTileIndex {
+public:
+	SeriesTileIndex(
+		const std::shared_ptr<const LineSeriesBatch>& line_series,
+		size_t heatmap_width, size_t heatmap_height,
+		size_t tile_size = SERIES_TILE_INDEX_TILE_SIZE,
+		size_t thread_count = 0);
+
+	//map the index file, the line series are used to check the series in the tiles at the edge of query
+	//the file is not opened if it does not match the line series(series count) or the heat map size(if it is not zero)
+	explicit SeriesTileIndex(const std::string& fileName,
+		const std::shared_ptr<const LineSeriesBatch>& line_series = nullptr,
+		size_t heatmap_width = 0, size_t heatmap_height = 0);
+
+	auto is_open() const -> bool;
+
+	//the series that mark any pixel in [column_begin, column_end) x [row_begin, row_end), sorted
+	//without line series, the series in the tiles at the edge are returned too
+	auto query(size_t column_begin, size_t row_begin, size_t column_end, size_t row_end) const -> std::vector<uint32_t>;
+
+	void save(const std::string& fileName) const;
+
+	auto width() const -> size_t;
+
+	auto height() const -> size_t;
+
+	auto series_count() const -> size_t;
+
+	auto tile_size() const -> size_t;
+
+	auto tile_columns() const -> size_t;
+
+	auto tile_rows() const -> size_t;
+
+	auto offsets() const -> const uint64_t*;
+
+	auto ids() const -> const uint32_t*;
+
+	//the series marks any pixel in the rectangle
+	static bool intersect(const LineSeriesView& line_series, size_t width, size_t height,
+		size_t column_begin, size_t row_begin, size_t column_end, size_t row_end);
+private:
+	std::shared_ptr<const LineSeriesBatch> mLineSeries;
+	std::shared_ptr<MappedFile> mFile;
+
+	std::vector<uint64_t> mOffsets;
+	std::vector<uint32_t> mIds;
+
+	size_t mWidth;
+	size_t mHeight;
+	size_t mSeriesCount;
+	size_t mTileSize;
+	size_t mTileColumns;
+	size_t mTileRows;
+
+	bool mOpen;
+};
@@ -1,12 +1,23 @@
 #include "SharpGenerator.hpp"
 #include "DensityGenerator.hpp"
-#include "LineSeries.hpp"
+#include "LineSeriesBatch.hpp"
 
 #include <algorithm>
 #include <random>
 
 #undef max
 
+namespace {
+
+	//the same layout as the Line buffer in SharpGeneratorInclude.hlsli
+	struct sharp_line_buffer {
+		vec4 color;
+		vec2 scale;
+		real width;
+		real unused;
+	};
+}
+
 SharpGenerator::SharpGenerator(
 	Factory* factory, 
 	const std::shared_ptr<DensityGenerator> &densityGenerator, 
@@ -26,6 +37,7 @@ SharpGenerator::SharpGenerator(
 	mInputLayout->addElement(InputLayoutElement("POSITION", 12, 0));
 
 	mTransformBuffer = mFactory->createConstantBuffer(sizeof(mat4) * 2, ResourceInfo::ConstantBuffer());
+	mLineBuffer = mFactory->createConstantBuffer(sizeof(sharp_line_buffer), ResourceInfo::ConstantBuffer());
 	mVertexBuffer = mFactory->createVertexBuffer(sizeof(vec3) * 4, sizeof(vec3), ResourceInfo::VertexBuffer());
 	mIndexBuffer = mFactory->createIndexBuffer(sizeof(unsigned) * 6, ResourceInfo::IndexBuffer());
 
@@ -69,6 +81,7 @@ SharpGenerator::SharpGenerator(
 	mInputLayout->addElement(InputLayoutElement("POSITION", 12, 0));
 
 	mTransformBuffer = mFactory->createConstantBuffer(sizeof(mat4) * 2, ResourceInfo::ConstantBuffer());
+	mLineBuffer = mFactory->createConstantBuffer(sizeof(sharp_line_buffer), ResourceInfo::ConstantBuffer());
 	mVertexBuffer = mFactory->createVertexBuffer(sizeof(vec3) * 4, sizeof(vec3), ResourceInfo::VertexBuffer());
 	mIndexBuffer = mFactory->createIndexBuffer(sizeof(unsigned) * 6, ResourceInfo::IndexBuffer());
 
@@ -103,6 +116,7 @@ SharpGenerator::~SharpGenerator() {
 
 	mFactory->destroyStructuredBuffer(mInstanceBuffer);
 	mFactory->destroyConstantBuffer(mTransformBuffer);
+	mFactory->destroyConstantBuffer(mLineBuffer);
 	mFactory->destroyVertexBuffer(mVertexBuffer);
 	mFactory->destroyIndexBuffer(mIndexBuffer);
 
@@ -152,19 +166,14 @@ void SharpGenerator::run(real width) {
 	
 
 	// get the max size of line series
-	auto max_size = 0;
+	const auto& line_series = *mDensityGenerator->mLineSeries;
+	const auto max_size = static_cast<int>(std::max(line_series.max_point_count(), static_cast<size_t>(2)));
 
-	for (auto& lines : mDensityGenerator->mLineSeries)
-		max_size = std::max(max_size, static_cast<int>(lines.size()));
+	//the quads are expanded from the points of series in vertex shader
+	//so each line only uploads one point(8 bytes) instead of a matrix and a color
+	std::vector<vec2> instance_data(max_size);
 
-	struct sharp_instance_buffer {
-		mat4 world;
-		vec4 color;
-	};
-
-	std::vector<sharp_instance_buffer> instance_data(max_size);
-
-	//when the size of buffer is less than lines
+	//when the size of buffer is less than points
 	//we need to expand the buffer
 	if (mInstanceBuffer == nullptr ||
 		mInstanceBuffer->element_count() < max_size) {
@@ -174,29 +183,37 @@ void SharpGenerator::run(real width) {
 		mFactory->destroyResourceUsage(mInstanceUsage);
 
 		//create new buffer
-		mInstanceBuffer = mFactory->createStructuredBuffer(sizeof(sharp_instance_buffer),
+		mInstanceBuffer = mFactory->createStructuredBuffer(sizeof(vec2),
 			max_size, ResourceInfo::ShaderResource());
 		mInstanceUsage = mFactory->createResourceUsage(mInstanceBuffer);
 	}
 
 	graphics->setResourceUsage(mInstanceUsage, 0);
+	graphics->setConstantBuffer(mLineBuffer, 1);
 
 	const auto scale_width = mWidth / static_cast<float>(mDensityGenerator->mWidth);
 	const auto scale_height = mHeight / static_cast<float>(mDensityGenerator->mHeight);
-	const auto scale_vector = vec2(scale_width, scale_height);
+
+	sharp_line_buffer line_buffer;
+
+	line_buffer.scale = vec2(scale_width, scale_height);
+	line_buffer.width = width;
+	line_buffer.unused = 0;
 
 	//for each line series
-	for (auto& lines : mDensityGenerator->mLineSeries) {
+	for (size_t series = 0; series < line_series.size(); series++) {
+		const auto lines = line_series[series];
+
 		assert(lines.size() >= 2);
 
 		const auto line_count = static_cast<int>(lines.size());
 
-		for (size_t index = 0; index < lines.size(); index++) {
-			instance_data[index].color = lines.color();
-			instance_data[index].world = lines.line_transform_with_scale(index, scale_vector, width);
-		}
+		std::copy(lines.data(), lines.data() + line_count + 1, instance_data.data());
+
+		line_buffer.color = lines.color();
 
 		mInstanceBuffer->update(instance_data.data());
+		mLineBuffer->update(&line_buffer);
 
 		graphics->drawIndexedInstanced(6, line_count, 0, 0);
 	}
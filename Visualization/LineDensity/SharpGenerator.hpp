@@ -39,6 +39,7 @@ private:
 	StructuredBuffer* mInstanceBuffer;
 
 	ConstantBuffer* mTransformBuffer;
+	ConstantBuffer* mLineBuffer;
 	VertexBuffer* mVertexBuffer;
 	IndexBuffer* mIndexBuffer;
 
@@ -1,13 +1,7 @@
 #pragma pack_matrix(row_major)
 
-struct sharp_instance_buffer {
-	matrix world;
-	float4 color;
-};
-
 struct output {
 	float4 position : SV_POSITION;
-	uint id : SV_INSTANCEID;
 };
 
 cbuffer Transform : register(b0) {
@@ -15,4 +9,12 @@ cbuffer Transform : register(b0) {
 	matrix project;
 }
 
-StructuredBuffer<sharp_instance_buffer> sharp_buffer : register(t0);
\ No newline at end of file
+cbuffer Line : register(b1) {
+	float4 color;
+	float2 scale;
+	float width;
+	float unused;
+}
+
+//the points of line series, the instance i is the line from point i to point i + 1
+StructuredBuffer<float2> sharp_buffer : register(t0);
\ No newline at end of file
@@ -2,5 +2,5 @@
 
 float4 main(output input) : SV_TARGET
 {
-	return sharp_buffer[input.id].color;
+	return color;
 }
\ No newline at end of file
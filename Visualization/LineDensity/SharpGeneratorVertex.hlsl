@@ -4,11 +4,18 @@ output main(float3 position : POSITION, uint id : SV_INSTANCEID)
 {
 	output result;
 
-	result.position = float4(position.xyz, 1.0f);
-	result.position = mul(result.position, (sharp_buffer[id].world));
-	result.position = mul(result.position, project);
+	float2 start = sharp_buffer[id] * scale;
+	float2 end = sharp_buffer[id + 1] * scale;
+	float2 direction = end - start;
+
+	//the unit normal of line, it is zero if the line has no length
+	float2 normal = float2(-direction.y, direction.x) * rsqrt(max(dot(direction, direction), 1e-30f));
 
-	result.id = id;
+	//the same quad as LineSeries::segment_transform, x is along the line and y is across the line
+	float2 corner = start + direction * position.x + normal * ((position.y - 0.5f) * width);
+
+	result.position = float4(corner, 0.0f, 1.0f);
+	result.position = mul(result.position, project);
 
 	return result;
 }
\ No newline at end of file
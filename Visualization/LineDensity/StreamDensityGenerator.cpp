@@ -0,0 +1,204 @@
+#include "StreamDensityGenerator.hpp"
+#include "LineRasterizer.hpp"
+#include "LineDecimator.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#undef max
+
+StreamDensityGenerator::StreamDensityGenerator(
+	const std::string& fileName,
+	size_t memory_budget,
+	size_t thread_count,
+	bool decimation,
+	DensityKernelType kernel_type) :
+	mReader(fileName),
+	mWidth(mReader.width()), mHeight(mReader.height()),
+	mWordCount(DensityKernel::word_count(mReader.height())),
+	mChunkBytes(0), mDecimation(decimation), mKernel(kernel_type),
+	mChunkQueue(STREAM_QUEUE_CAPACITY), mColumnsQueue(STREAM_QUEUE_CAPACITY) {
+
+	assert(mReader.is_open() == true);
+
+	if (thread_count == 0) thread_count = ThreadPool::hardware_concurrency();
+
+	mScratches.resize(thread_count);
+
+	//the scratches of rasterize stage are fixed, the rest is shared by the items in flight
+	//each queue has at most capacity items, and each stage works on one item per thread
+	const auto scratch_bytes = mWidth * (mWordCount * sizeof(uint64_t) + sizeof(byte) + sizeof(size_t));
+	const auto scratch_total = scratch_bytes * thread_count;
+
+	auto item_count = (STREAM_QUEUE_CAPACITY + thread_count + 1) * 2;
+
+	//the decimated series is not larger than chunk
+	if (mDecimation == true) item_count = item_count + thread_count;
+
+	//at least one column can be stored
+	const auto min_chunk_bytes = std::max(mWordCount * sizeof(uint64_t) + sizeof(uint32_t), static_cast<size_t>(1 << 16));
+
+	mChunkBytes = memory_budget > scratch_total ? (memory_budget - scratch_total) / item_count : 0;
+	mChunkBytes = std::max(mChunkBytes, min_chunk_bytes);
+}
+
+void StreamDensityGenerator::run() {
+	for (auto& scratch : mScratches) {
+		scratch.Bits.assign(mWidth * mWordCount, 0);
+		scratch.Touched.assign(mWidth, 0);
+	}
+
+	mColumnHeatMap.assign(mWidth * mWordCount * DENSITY_KERNEL_WORD_BITS, 0);
+
+	std::thread reader([this]() { read_stage(); });
+	std::vector<std::thread> rasterizers;
+
+	//the last rasterizer closes the queue of columns
+	std::atomic<size_t> running(mScratches.size());
+
+	for (auto& scratch : mScratches) {
+		rasterizers.push_back(std::thread([this, &scratch, &running]()
+			{
+				rasterize_stage(scratch);
+
+				if (--running == 0) mColumnsQueue.close();
+			}));
+	}
+
+	accumulate_stage();
+
+	reader.join();
+
+	for (auto& rasterizer : rasterizers) rasterizer.join();
+
+	//convert the column major heat map to row major
+	mHeatMap.resize(mWidth * mHeight);
+
+	const auto column_height = mWordCount * DENSITY_KERNEL_WORD_BITS;
+
+	for (size_t row = 0; row < mHeight; row++) {
+		for (size_t column = 0; column < mWidth; column++)
+			mHeatMap[row * mWidth + column] = mColumnHeatMap[column * column_height + row];
+	}
+
+	mColumnHeatMap = std::vector<real>();
+
+	for (auto& scratch : mScratches) scratch = Scratch();
+}
+
+auto StreamDensityGenerator::is_open() const -> bool {
+	return mReader.is_open();
+}
+
+auto StreamDensityGenerator::heatmap() const -> const std::vector<real>& {
+	return mHeatMap;
+}
+
+auto StreamDensityGenerator::width() const -> size_t {
+	return mWidth;
+}
+
+auto StreamDensityGenerator::height() const -> size_t {
+	return mHeight;
+}
+
+auto StreamDensityGenerator::chunk_bytes() const -> size_t {
+	return mChunkBytes;
+}
+
+auto StreamDensityGenerator::kernel() const -> DensityKernelType {
+	return mKernel.type();
+}
+
+void StreamDensityGenerator::read_stage() {
+	while (true) {
+		auto chunk = std::make_shared<LineSeriesBatch>(mWidth, mHeight);
+
+		if (mReader.read(*chunk, mChunkBytes) == false) break;
+
+		if (mChunkQueue.push(std::move(chunk)) == false) break;
+	}
+
+	mChunkQueue.close();
+}
+
+void StreamDensityGenerator::rasterize_stage(Scratch& scratch) {
+	std::shared_ptr<LineSeriesBatch> chunk;
+	std::shared_ptr<Columns> columns = std::make_shared<Columns>();
+
+	while (mChunkQueue.pop(chunk) == true) {
+		for (size_t index = 0; index < chunk->size(); index++)
+			rasterize_line_series((*chunk)[index], scratch, columns);
+
+		//release the chunk before waiting the next one
+		chunk.reset();
+	}
+
+	if (columns->Indices.empty() == false) mColumnsQueue.push(std::move(columns));
+}
+
+void StreamDensityGenerator::accumulate_stage() {
+	const auto column_height = mWordCount * DENSITY_KERNEL_WORD_BITS;
+
+	std::shared_ptr<Columns> columns;
+
+	while (mColumnsQueue.pop(columns) == true) {
+		for (size_t index = 0; index < columns->Indices.size(); index++) {
+			mKernel.merge(&columns->Bits[index * mWordCount], mWordCount,
+				&mColumnHeatMap[columns->Indices[index] * column_height]);
+		}
+
+		columns.reset();
+	}
+}
+
+void StreamDensityGenerator::rasterize_line_series(const LineSeriesView& line_series, Scratch& scratch, std::shared_ptr<Columns>& columns) {
+	assert(line_series.size() >= 1);
+
+	const auto word_count = mWordCount;
+
+	auto points = line_series.data();
+	auto point_count = line_series.size() + 1;
+
+	if (mDecimation == true && point_count > mWidth * 4 &&
+		LineDecimator::m4(points, point_count, scratch.Points) == true) {
+		points = scratch.Points.data();
+		point_count = scratch.Points.size();
+	}
+
+	LineRasterizer::rasterize(points, point_count, mWidth, mHeight,
+		[&](size_t column, size_t row_begin, size_t row_end)
+		{
+			DensityKernel::mark(&scratch.Bits[column * word_count], row_begin, row_end);
+
+			if (scratch.Touched[column] != 0) return;
+
+			scratch.Touched[column] = 1;
+			scratch.Columns.push_back(column);
+		});
+
+	//move the marked columns to the output, the columns of one series can be split into two outputs
+	//because the merge of column only depends on the column itself
+	const auto column_bytes = word_count * sizeof(uint64_t) + sizeof(uint32_t);
+
+	for (auto column : scratch.Columns) {
+		if ((columns->Indices.size() + 1) * column_bytes > mChunkBytes) {
+			mColumnsQueue.push(std::move(columns));
+
+			columns = std::make_shared<Columns>();
+		}
+
+		const auto bits = &scratch.Bits[column * word_count];
+
+		columns->Indices.push_back(static_cast<uint32_t>(column));
+		columns->Bits.insert(columns->Bits.end(), bits, bits + word_count);
+
+		std::fill(bits, bits + word_count, static_cast<uint64_t>(0));
+
+		scratch.Touched[column] = 0;
+	}
+
+	scratch.Columns.clear();
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Common.hpp"
+#include "LineSeriesBatch.hpp"
+#include "LineSeriesReader.hpp"
+#include "DensityKernel.hpp"
+#include "BoundedQueue.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+//the max number of items in the queue between two stages
+#define STREAM_QUEUE_CAPACITY 2
+
+//the out-of-core version of CpuDensityGenerator, the line data file is read in chunks
+//the pipeline has three stages connected by bounded queues :
+//read stage(one thread) reads the chunks of line series from file
+//rasterize stage(thread_count threads) marks the pixels of each series and outputs the marked columns
+//accumulate stage(the caller thread) counts the marked pixels of each column and adds 1 / count to the heat map
+//the memory of chunks, columns and scratches is limited by memory_budget(bytes), the heat map is not included
+//a series larger than the chunk is still read as one chunk
+class StreamDensityGenerator {
+public:
+	StreamDensityGenerator(
+		const std::string& fileName,
+		size_t memory_budget,
+		size_t thread_count = 0,
+		bool decimation = false,
+		DensityKernelType kernel_type = DensityKernel::detect());
+
+	//the file is read once, so it can only run once
+	void run();
+
+	auto is_open() const -> bool;
+
+	//row major, the same layout as the heat map texture
+	auto heatmap() const -> const std::vector<real>&;
+
+	auto width()const -> size_t;
+
+	auto height()const -> size_t;
+
+	//the max memory of chunk or columns
+	auto chunk_bytes()const -> size_t;
+
+	auto kernel()const -> DensityKernelType;
+private:
+	//the marked columns of series, the column i has bits [i * mWordCount, (i + 1) * mWordCount)
+	struct Columns {
+		std::vector<uint32_t> Indices;
+		std::vector<uint64_t> Bits;
+	};
+
+	//the marks of one line series, it is reused by the series that run on the same thread
+	struct Scratch {
+		std::vector<uint64_t> Bits;
+		std::vector<byte> Touched;
+		std::vector<size_t> Columns;
+		std::vector<vec2> Points; //the decimated series
+	};
+
+	void read_stage();
+
+	void rasterize_stage(Scratch& scratch);
+
+	void accumulate_stage();
+
+	void rasterize_line_series(const LineSeriesView& line_series, Scratch& scratch, std::shared_ptr<Columns>& columns);
+private:
+	LineSeriesReader mReader;
+
+	size_t mWidth;
+	size_t mHeight;
+
+	size_t mWordCount;
+	size_t mChunkBytes;
+
+	bool mDecimation;
+
+	DensityKernel mKernel;
+
+	BoundedQueue<std::shared_ptr<LineSeriesBatch>> mChunkQueue;
+	BoundedQueue<std::shared_ptr<Columns>> mColumnsQueue;
+
+	std::vector<Scratch> mScratches;
+	std::vector<real> mColumnHeatMap; //column major, each column has mWordCount * DENSITY_KERNEL_WORD_BITS rows
+	std::vector<real> mHeatMap;
+};
@@ -16,10 +16,10 @@ public:
 		const auto image_width = 128;
 		const auto image_height = 72;
 
-		std::vector<LineSeries> data;
+		auto data = std::make_shared<LineSeriesBatch>(image_width, image_height);
 
 		for (size_t i = 0; i < 4; i++)
-			data.push_back(LineSeries::random_make(20,
+			data->push(LineSeries::random_make(20,
 				static_cast<real>(image_width),
 				static_cast<real>(image_height)));
 
@@ -0,0 +1,89 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+#undef max
+
+ThreadPool::ThreadPool(size_t thread_count) : mNextIndex(0) {
+	if (thread_count == 0) thread_count = hardware_concurrency();
+
+	for (size_t index = 1; index < thread_count; index++)
+		mThreads.push_back(std::thread(&ThreadPool::worker, this, index));
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		mExit = true;
+	}
+
+	mStartCondition.notify_all();
+
+	for (auto& thread : mThreads) thread.join();
+}
+
+void ThreadPool::parallel_for(size_t count, const ParallelFunction& function) {
+	if (count == 0) return;
+
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		mFunction = &function;
+		mCount = count;
+		mNextIndex = 0;
+		mRunning = mThreads.size();
+		mGeneration++;
+	}
+
+	mStartCondition.notify_all();
+
+	work(0);
+
+	//wait the workers, the function must be alive until they finished
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	mFinishCondition.wait(lock, [this]() { return mRunning == 0; });
+
+	mFunction = nullptr;
+}
+
+auto ThreadPool::size() const -> size_t {
+	return mThreads.size() + 1;
+}
+
+auto ThreadPool::hardware_concurrency() -> size_t {
+	return std::max(static_cast<size_t>(1), static_cast<size_t>(std::thread::hardware_concurrency()));
+}
+
+void ThreadPool::worker(size_t thread_index) {
+	size_t generation = 0;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+
+			mStartCondition.wait(lock, [&]() { return mExit == true || mGeneration != generation; });
+
+			if (mExit == true) return;
+
+			generation = mGeneration;
+		}
+
+		work(thread_index);
+
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+
+			mRunning--;
+		}
+
+		mFinishCondition.notify_one();
+	}
+}
+
+void ThreadPool::work(size_t thread_index) {
+	//the indices are taken one by one, so the threads are balanced if some indices are heavy
+	for (auto index = mNextIndex++; index < mCount; index = mNextIndex++)
+		(*mFunction)(thread_index, index);
+}
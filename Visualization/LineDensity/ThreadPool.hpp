@@ -0,0 +1,45 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <mutex>
+
+using ParallelFunction = std::function<void(size_t thread_index, size_t index)>;
+
+class ThreadPool {
+public:
+	//0 means the hardware concurrency
+	explicit ThreadPool(size_t thread_count = 0);
+
+	~ThreadPool();
+
+	//run function for index in [0, count), the caller thread is the thread 0
+	//it returns when all indices are finished
+	void parallel_for(size_t count, const ParallelFunction& function);
+
+	auto size() const -> size_t;
+
+	static auto hardware_concurrency() -> size_t;
+private:
+	void worker(size_t thread_index);
+
+	void work(size_t thread_index);
+private:
+	std::vector<std::thread> mThreads;
+
+	std::mutex mMutex;
+	std::condition_variable mStartCondition;
+	std::condition_variable mFinishCondition;
+
+	const ParallelFunction* mFunction = nullptr;
+
+	std::atomic<size_t> mNextIndex;
+	size_t mCount = 0;
+	size_t mGeneration = 0;
+	size_t mRunning = 0;
+
+	bool mExit = false;
+};
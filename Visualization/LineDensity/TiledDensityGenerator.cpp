@@ -0,0 +1,239 @@
+#include "TiledDensityGenerator.hpp"
+#include "LineRasterizer.hpp"
+
+#include <algorithm>
+
+#undef max
+#undef min
+
+namespace {
+
+	auto popcount(uint64_t value) -> unsigned {
+		value = value - ((value >> 1) & 0x5555555555555555ull);
+		value = (value & 0x3333333333333333ull) + ((value >> 2) & 0x3333333333333333ull);
+		value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+
+		return static_cast<unsigned>((value * 0x0101010101010101ull) >> 56);
+	}
+}
+
+static_assert(TILED_HEAT_MAP_TILE_SIZE == DENSITY_KERNEL_WORD_BITS, "the column of mark tile is one word.");
+
+TiledDensityGenerator::TiledDensityGenerator(
+	const std::shared_ptr<const LineSeriesBatch>& line_series,
+	size_t heatmap_width, size_t heatmap_height,
+	size_t thread_count,
+	size_t shard_index, size_t shard_count,
+	DensityKernelType kernel_type) :
+	mLineSeries(line_series),
+	mWidth(heatmap_width), mHeight(heatmap_height),
+	mShardIndex(shard_index), mShardCount(shard_count),
+	mSeriesBegin(line_series->size() * shard_index / shard_count),
+	mSeriesEnd(line_series->size() * (shard_index + 1) / shard_count),
+	mThreadPool(thread_count), mKernel(kernel_type),
+	mHeatMap(heatmap_width, heatmap_height) {
+
+	assert(shard_index < shard_count);
+
+	mScratches.resize(mThreadPool.size());
+}
+
+void TiledDensityGenerator::run() {
+	rasterize();
+	reduce();
+}
+
+void TiledDensityGenerator::rasterize() {
+	for (auto& scratch : mScratches) {
+		scratch.Directory.assign(mHeatMap.tile_count(), 0);
+		scratch.HeatMap = TiledHeatMap(mWidth, mHeight);
+	}
+
+	//each part of series accumulates into its own tiles, so no atomic is needed
+	//the parts do not depend on the schedule and they are summed in order, see CpuDensityGenerator
+	const auto part_count = mScratches.size();
+
+	mThreadPool.parallel_for(part_count, [&](size_t, size_t part)
+		{
+			const auto series_end = mLineSeries->split(mSeriesBegin, mSeriesEnd, part + 1, part_count);
+
+			for (auto index = mLineSeries->split(mSeriesBegin, mSeriesEnd, part, part_count); index < series_end; index++)
+				run_line_series((*mLineSeries)[index], mScratches[part]);
+		});
+}
+
+void TiledDensityGenerator::reduce() {
+	mHeatMap.clear();
+
+	//the tiles are allocated before the tasks, the pool is not thread safe
+	std::vector<size_t> tiles;
+
+	for (size_t tile = 0; tile < mHeatMap.tile_count(); tile++) {
+		for (auto& scratch : mScratches) {
+			if (scratch.HeatMap.tile(tile) == nullptr) continue;
+
+			mHeatMap.touch(tile);
+			tiles.push_back(tile);
+
+			break;
+		}
+	}
+
+	mThreadPool.parallel_for(tiles.size(), [&](size_t, size_t index)
+		{
+			const auto target = mHeatMap.tile(tiles[index]);
+
+			for (auto& scratch : mScratches) {
+				const auto source = scratch.HeatMap.tile(tiles[index]);
+
+				if (source == nullptr) continue;
+
+				for (size_t pixel = 0; pixel < TILED_HEAT_MAP_TILE_PIXELS; pixel++) target[pixel] += source[pixel];
+			}
+		});
+
+	for (auto& scratch : mScratches) {
+		scratch.Directory = std::vector<uint32_t>();
+		scratch.Marks = std::vector<uint64_t>();
+		scratch.Tiles = std::vector<uint32_t>();
+		scratch.HeatMap = TiledHeatMap();
+	}
+}
+
+auto TiledDensityGenerator::data() const -> const std::shared_ptr<const LineSeriesBatch>& {
+	return mLineSeries;
+}
+
+auto TiledDensityGenerator::heatmap() const -> const TiledHeatMap& {
+	return mHeatMap;
+}
+
+auto TiledDensityGenerator::series_begin() const -> size_t {
+	return mSeriesBegin;
+}
+
+auto TiledDensityGenerator::series_end() const -> size_t {
+	return mSeriesEnd;
+}
+
+auto TiledDensityGenerator::shard_index() const -> size_t {
+	return mShardIndex;
+}
+
+auto TiledDensityGenerator::shard_count() const -> size_t {
+	return mShardCount;
+}
+
+auto TiledDensityGenerator::width() const -> size_t {
+	return mWidth;
+}
+
+auto TiledDensityGenerator::height() const -> size_t {
+	return mHeight;
+}
+
+auto TiledDensityGenerator::kernel() const -> DensityKernelType {
+	return mKernel.type();
+}
+
+void TiledDensityGenerator::run_line_series(const LineSeriesView& line_series, Scratch& scratch) const {
+	assert(line_series.size() >= 1);
+
+	//draw pass, mark the pixels in the mark tiles
+	LineRasterizer::rasterize(line_series.data(), line_series.size() + 1, mWidth, mHeight,
+		[&](size_t column, size_t row_begin, size_t row_end)
+		{
+			mark(scratch, column, row_begin, row_end);
+		});
+
+	//merge pass, the count of column is the sum of the tiles in the same tile column
+	//so the tiles are sorted by tile column and the tiles of one tile column are merged together
+	const auto tile_columns = mHeatMap.tile_columns();
+
+	auto& tiles = scratch.Tiles;
+
+	std::sort(tiles.begin(), tiles.end(), [&](uint32_t left, uint32_t right)
+		{
+			const auto left_column = left % tile_columns;
+			const auto right_column = right % tile_columns;
+
+			return left_column != right_column ? left_column < right_column : left < right;
+		});
+
+	const auto marks_of = [&](uint32_t tile) { return &scratch.Marks[(scratch.Directory[tile] - 1) * TILED_HEAT_MAP_TILE_SIZE]; };
+
+	size_t group_begin = 0;
+
+	while (group_begin < tiles.size()) {
+		auto group_end = group_begin + 1;
+
+		while (group_end < tiles.size() && tiles[group_end] % tile_columns == tiles[group_begin] % tile_columns) group_end++;
+
+		//the column is in one tile, it is the same as CpuDensityGenerator with one word
+		if (group_end - group_begin == 1) {
+			const auto marks = marks_of(tiles[group_begin]);
+			const auto target = scratch.HeatMap.touch(tiles[group_begin]);
+
+			for (size_t column = 0; column < TILED_HEAT_MAP_TILE_SIZE; column++)
+				mKernel.merge(marks + column, 1, target + column * TILED_HEAT_MAP_TILE_SIZE);
+		}
+		else {
+			for (size_t column = 0; column < TILED_HEAT_MAP_TILE_SIZE; column++) {
+				unsigned count = 0;
+
+				for (auto index = group_begin; index < group_end; index++) count += popcount(marks_of(tiles[index])[column]);
+
+				if (count == 0) continue;
+
+				const auto scale = static_cast<real>(1) / static_cast<real>(count);
+
+				for (auto index = group_begin; index < group_end; index++) {
+					auto& word = marks_of(tiles[index])[column];
+
+					if (word == 0) continue;
+
+					const auto target = scratch.HeatMap.touch(tiles[index]) + column * TILED_HEAT_MAP_TILE_SIZE;
+
+					//visit the set bits only, the bits below the lowest set bit are its row
+					while (word != 0) {
+						target[popcount((word & (~word + 1)) - 1)] += scale;
+
+						word &= word - 1;
+					}
+				}
+			}
+		}
+
+		group_begin = group_end;
+	}
+
+	//the marks are cleared by merge, only the directory is reset
+	for (auto tile : tiles) scratch.Directory[tile] = 0;
+
+	tiles.clear();
+}
+
+void TiledDensityGenerator::mark(Scratch& scratch, size_t column, size_t row_begin, size_t row_end) const {
+	const auto tile_column = column / TILED_HEAT_MAP_TILE_SIZE;
+	const auto local_column = column % TILED_HEAT_MAP_TILE_SIZE;
+
+	//the span may cross the tiles of the column
+	for (auto tile_row = row_begin / TILED_HEAT_MAP_TILE_SIZE; tile_row <= row_end / TILED_HEAT_MAP_TILE_SIZE; tile_row++) {
+		const auto tile = static_cast<uint32_t>(tile_row * mHeatMap.tile_columns() + tile_column);
+
+		if (scratch.Directory[tile] == 0) {
+			scratch.Tiles.push_back(tile);
+			scratch.Directory[tile] = static_cast<uint32_t>(scratch.Tiles.size());
+
+			//the marks of slots are zero when they are released, so only the new slots need zero
+			if (scratch.Marks.size() < scratch.Tiles.size() * TILED_HEAT_MAP_TILE_SIZE)
+				scratch.Marks.resize(scratch.Tiles.size() * TILED_HEAT_MAP_TILE_SIZE, 0);
+		}
+
+		const auto row_offset = tile_row * TILED_HEAT_MAP_TILE_SIZE;
+
+		DensityKernel::mark(&scratch.Marks[(scratch.Directory[tile] - 1) * TILED_HEAT_MAP_TILE_SIZE + local_column],
+			std::max(row_begin, row_offset) - row_offset,
+			std::min(row_end, row_offset + TILED_HEAT_MAP_TILE_SIZE - 1) - row_offset);
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Common.hpp"
+#include "LineSeriesBatch.hpp"
+#include "DensityKernel.hpp"
+#include "TiledHeatMap.hpp"
+#include "ThreadPool.hpp"
+
+#include <memory>
+#include <vector>
+
+//the CPU density generator for the very large heat map, the heat map is the same as CpuDensityGenerator
+//the marks of series and the heat maps of threads are sparse tiles, so the memory scales with the touched area instead of the heat map size
+//the shard i of n only draws the series [size * i / n, size * (i + 1) / n), the heat maps of all shards sum to the whole heat map
+//mark tile : TILED_HEAT_MAP_TILE_SIZE words, word x is the column x of tile and bit y is the row y of tile
+class TiledDensityGenerator {
+public:
+	TiledDensityGenerator(
+		const std::shared_ptr<const LineSeriesBatch>& line_series,
+		size_t heatmap_width, size_t heatmap_height,
+		size_t thread_count = 0,
+		size_t shard_index = 0, size_t shard_count = 1,
+		DensityKernelType kernel_type = DensityKernel::detect());
+
+	void run();
+
+	//rasterize the series into the tiled heat maps of parts, the series of shard are split into one continuous part per thread
+	void rasterize();
+
+	//sum the tiles of parts into the heat map in the order of parts and release them, each tile is a task
+	void reduce();
+
+	auto data() const -> const std::shared_ptr<const LineSeriesBatch>&;
+
+	auto heatmap() const -> const TiledHeatMap&;
+
+	//the series of shard are [series_begin(), series_end())
+	auto series_begin()const -> size_t;
+
+	auto series_end()const -> size_t;
+
+	auto shard_index()const -> size_t;
+
+	auto shard_count()const -> size_t;
+
+	auto width()const -> size_t;
+
+	auto height()const -> size_t;
+
+	auto kernel()const -> DensityKernelType;
+private:
+	//the marks of one line series, it is reused by the series of the same part
+	struct Scratch {
+		std::vector<uint32_t> Directory; //the slot + 1 of mark tile
+		std::vector<uint64_t> Marks; //the mark tiles of slots
+		std::vector<uint32_t> Tiles; //the tiles of slots
+
+		TiledHeatMap HeatMap;
+	};
+
+	void run_line_series(const LineSeriesView& line_series, Scratch& scratch) const;
+
+	void mark(Scratch& scratch, size_t column, size_t row_begin, size_t row_end) const;
+private:
+	std::shared_ptr<const LineSeriesBatch> mLineSeries;
+
+	size_t mWidth;
+	size_t mHeight;
+
+	size_t mShardIndex;
+	size_t mShardCount;
+
+	size_t mSeriesBegin;
+	size_t mSeriesEnd;
+
+	ThreadPool mThreadPool;
+	DensityKernel mKernel;
+
+	std::vector<Scratch> mScratches;
+	TiledHeatMap mHeatMap;
+};
@@ -0,0 +1,183 @@
+#include "TiledHeatMap.hpp"
+#include "ImageWriter.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+#undef max
+#undef min
+
+TiledHeatMap::TiledHeatMap(size_t width, size_t height) :
+	mWidth(width), mHeight(height),
+	mTileColumns((width + TILED_HEAT_MAP_TILE_SIZE - 1) / TILED_HEAT_MAP_TILE_SIZE),
+	mTileRows((height + TILED_HEAT_MAP_TILE_SIZE - 1) / TILED_HEAT_MAP_TILE_SIZE),
+	mPoolNext(nullptr), mPoolFree(0) {
+
+	mDirectory.resize(mTileColumns * mTileRows, 0);
+}
+
+auto TiledHeatMap::tile(size_t index) -> real* {
+	return mDirectory[index] == 0 ? nullptr : mTiles[mDirectory[index] - 1];
+}
+
+auto TiledHeatMap::tile(size_t index) const -> const real* {
+	return mDirectory[index] == 0 ? nullptr : mTiles[mDirectory[index] - 1];
+}
+
+auto TiledHeatMap::touch(size_t index) -> real* {
+	if (mDirectory[index] != 0) return mTiles[mDirectory[index] - 1];
+
+	//the pool grows geometrically, so the small heat map does not take a whole chunk
+	if (mPoolFree == 0) {
+		const auto chunk_tiles = std::min(std::max(mTiles.size(), static_cast<size_t>(1)), static_cast<size_t>(TILED_HEAT_MAP_POOL_TILES));
+
+		mPool.push_back(std::unique_ptr<real[]>(new real[chunk_tiles * TILED_HEAT_MAP_TILE_PIXELS]()));
+		mPoolNext = mPool.back().get();
+		mPoolFree = chunk_tiles;
+	}
+
+	mTiles.push_back(mPoolNext);
+	mDirectory[index] = static_cast<uint32_t>(mTiles.size());
+
+	mPoolNext = mPoolNext + TILED_HEAT_MAP_TILE_PIXELS;
+	mPoolFree--;
+
+	return mTiles.back();
+}
+
+void TiledHeatMap::clear() {
+	std::fill(mDirectory.begin(), mDirectory.end(), 0);
+
+	mTiles = std::vector<real*>();
+	mPool = std::vector<std::unique_ptr<real[]>>();
+	mPoolNext = nullptr;
+	mPoolFree = 0;
+}
+
+auto TiledHeatMap::tile_count() const -> size_t {
+	return mDirectory.size();
+}
+
+auto TiledHeatMap::tile_columns() const -> size_t {
+	return mTileColumns;
+}
+
+auto TiledHeatMap::tile_rows() const -> size_t {
+	return mTileRows;
+}
+
+auto TiledHeatMap::allocated_count() const -> size_t {
+	return mTiles.size();
+}
+
+auto TiledHeatMap::bytes() const -> size_t {
+	return (mTiles.size() + mPoolFree) * TILED_HEAT_MAP_TILE_PIXELS * sizeof(real) + mDirectory.size() * sizeof(uint32_t);
+}
+
+auto TiledHeatMap::width() const -> size_t {
+	return mWidth;
+}
+
+auto TiledHeatMap::height() const -> size_t {
+	return mHeight;
+}
+
+auto TiledHeatMap::to_dense() const -> std::vector<real> {
+	std::vector<real> result(mWidth * mHeight, 0);
+
+	for (size_t index = 0; index < tile_count(); index++) {
+		const auto source = tile(index);
+
+		if (source == nullptr) continue;
+
+		const auto column_begin = (index % mTileColumns) * TILED_HEAT_MAP_TILE_SIZE;
+		const auto row_begin = (index / mTileColumns) * TILED_HEAT_MAP_TILE_SIZE;
+		const auto column_end = std::min(column_begin + TILED_HEAT_MAP_TILE_SIZE, mWidth);
+		const auto row_end = std::min(row_begin + TILED_HEAT_MAP_TILE_SIZE, mHeight);
+
+		for (auto row = row_begin; row < row_end; row++) {
+			for (auto column = column_begin; column < column_end; column++)
+				result[row * mWidth + column] = source[(column - column_begin) * TILED_HEAT_MAP_TILE_SIZE + row - row_begin];
+		}
+	}
+
+	return result;
+}
+
+auto TiledHeatMap::save(const std::string& fileName, size_t shard_index, size_t shard_count) const -> bool {
+	assert(shard_index < shard_count);
+
+	if (is_little_endian() == false) return false;
+
+	std::vector<uint64_t> indices;
+
+	for (size_t index = 0; index < tile_count(); index++)
+		if (mDirectory[index] != 0) indices.push_back(index);
+
+	TiledHeatMapHeader header;
+
+	header.Magic = TILED_HEAT_MAP_MAGIC;
+	header.Version = TILED_HEAT_MAP_VERSION;
+	header.Width = mWidth;
+	header.Height = mHeight;
+	header.TileSize = TILED_HEAT_MAP_TILE_SIZE;
+	header.Checksum = 0;
+	header.TileCount = indices.size();
+	header.IndicesSection = sizeof(TiledHeatMapHeader);
+	header.TilesSection = header.IndicesSection + sizeof(uint64_t) * indices.size();
+	header.ShardIndex = static_cast<uint32_t>(shard_index);
+	header.ShardCount = static_cast<uint32_t>(shard_count);
+
+	std::ofstream file(fileName, std::ios::binary);
+	assert(file.is_open() == true);
+
+	//the checksum is known after the tiles, the header is written again at the end
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(indices.data()), static_cast<std::streamsize>(sizeof(uint64_t) * indices.size()));
+
+	auto checksum = ImageWriter::crc32(reinterpret_cast<const unsigned char*>(indices.data()), sizeof(uint64_t) * indices.size());
+
+	//the tiles are transposed to row major, the same as the tiles of PyramidDensityGenerator
+	std::vector<float> values(TILED_HEAT_MAP_TILE_PIXELS);
+
+	for (auto index : indices) {
+		const auto source = tile(static_cast<size_t>(index));
+
+		for (size_t row = 0; row < TILED_HEAT_MAP_TILE_SIZE; row++) {
+			for (size_t column = 0; column < TILED_HEAT_MAP_TILE_SIZE; column++)
+				values[row * TILED_HEAT_MAP_TILE_SIZE + column] = source[column * TILED_HEAT_MAP_TILE_SIZE + row];
+		}
+
+		file.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(sizeof(float) * values.size()));
+
+		checksum = ImageWriter::crc32(reinterpret_cast<const unsigned char*>(values.data()), sizeof(float) * values.size(), checksum);
+	}
+
+	header.Checksum = checksum;
+
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.close();
+
+	return true;
+}
+
+auto TiledHeatMap::read_from_file(const std::string& fileName) -> std::shared_ptr<TiledHeatMap> {
+	TiledHeatMapFile file(fileName);
+
+	if (file.is_open() == false) return nullptr;
+
+	auto result = std::make_shared<TiledHeatMap>(file.width(), file.height());
+
+	for (size_t index = 0; index < file.tile_count(); index++) {
+		const auto source = file.tile(index);
+		const auto target = result->touch(file.index(index));
+
+		for (size_t row = 0; row < TILED_HEAT_MAP_TILE_SIZE; row++) {
+			for (size_t column = 0; column < TILED_HEAT_MAP_TILE_SIZE; column++)
+				target[column * TILED_HEAT_MAP_TILE_SIZE + row] = source[row * TILED_HEAT_MAP_TILE_SIZE + column];
+		}
+	}
+
+	return result;
+}
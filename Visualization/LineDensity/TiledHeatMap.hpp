@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Common.hpp"
+#include "TiledHeatMapFile.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+//the max number of tiles allocated at once, the pool grows by the number of tiles it has until this
+#define TILED_HEAT_MAP_POOL_TILES 256
+
+//the sparse heat map, only the tiles that are touched are allocated
+//tile t is (t % tile_columns(), t / tile_columns()), each tile is column major, pixel(x, y) of tile is tile[x * size + y]
+//the tiles at right and bottom edge have the same size, the pixels out of heat map are zero
+class TiledHeatMap {
+public:
+	TiledHeatMap(size_t width = 0, size_t height = 0);
+
+	//the tile or nullptr if it is not allocated
+	auto tile(size_t index) -> real*;
+
+	auto tile(size_t index) const -> const real*;
+
+	//the tile is allocated from pool with zero if it is not allocated
+	auto touch(size_t index) -> real*;
+
+	//release all tiles
+	void clear();
+
+	//the number of tiles of heat map, allocated or not
+	auto tile_count() const -> size_t;
+
+	auto tile_columns() const -> size_t;
+
+	auto tile_rows() const -> size_t;
+
+	//the number of allocated tiles
+	auto allocated_count() const -> size_t;
+
+	//the memory of allocated tiles and directory
+	auto bytes() const -> size_t;
+
+	auto width() const -> size_t;
+
+	auto height() const -> size_t;
+
+	//the row major heat map, the same layout as CpuDensityGenerator
+	auto to_dense() const -> std::vector<real>;
+
+	//only the allocated tiles are saved, see TiledHeatMapFile
+	//the shard is the part of series that the heat map has, the whole heat map is shard 0 of 1
+	//false if the host is not little endian, the file is not written
+	auto save(const std::string& fileName, size_t shard_index = 0, size_t shard_count = 1) const -> bool;
+
+	//nullptr if the file is invalid
+	static auto read_from_file(const std::string& fileName) -> std::shared_ptr<TiledHeatMap>;
+private:
+	size_t mWidth;
+	size_t mHeight;
+
+	size_t mTileColumns;
+	size_t mTileRows;
+
+	//the slot + 1 of tile, 0 means the tile is not allocated
+	std::vector<uint32_t> mDirectory;
+
+	//the tiles of slots, they are in the chunks of pool
+	std::vector<real*> mTiles;
+	std::vector<std::unique_ptr<real[]>> mPool;
+
+	//the next tile and the number of tiles that the last chunk can still give
+	real* mPoolNext;
+	size_t mPoolFree;
+};
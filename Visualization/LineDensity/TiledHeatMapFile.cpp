@@ -0,0 +1,80 @@
+#include "TiledHeatMapFile.hpp"
+#include "ImageWriter.hpp"
+
+static_assert(sizeof(TiledHeatMapHeader) == 64, "the header should be 64 bytes.");
+
+TiledHeatMapFile::TiledHeatMapFile(const std::string& fileName) :
+	mFile(std::make_shared<MappedFile>(fileName)), mHeader(nullptr) {
+
+	if (mFile->is_open() == false || is_little_endian() == false) return;
+	if (mFile->size() < sizeof(TiledHeatMapHeader)) return;
+
+	const auto header = reinterpret_cast<const TiledHeatMapHeader*>(mFile->data());
+
+	if (header->Magic != TILED_HEAT_MAP_MAGIC || header->Version != TILED_HEAT_MAP_VERSION) return;
+	if (header->TileSize != TILED_HEAT_MAP_TILE_SIZE || header->IndicesSection != sizeof(TiledHeatMapHeader)) return;
+	if (header->ShardCount == 0 || header->ShardIndex >= header->ShardCount) return;
+	if (header->Width > UINT32_MAX || header->Height > UINT32_MAX) return;
+
+	//each tile takes 8 bytes of index at least, it also avoids overflow
+	if (header->TileCount > mFile->size() / sizeof(uint64_t)) return;
+	if (header->TilesSection != header->IndicesSection + sizeof(uint64_t) * header->TileCount) return;
+	if (header->TilesSection > mFile->size() ||
+		(mFile->size() - header->TilesSection) / (sizeof(float) * TILED_HEAT_MAP_TILE_PIXELS) < header->TileCount) return;
+
+	//the indices are used to place the tiles, so they should be increasing and in heat map
+	const auto indices = reinterpret_cast<const uint64_t*>(mFile->data() + header->IndicesSection);
+	const auto grid_count = grid_tile_count(static_cast<size_t>(header->Width), static_cast<size_t>(header->Height));
+
+	for (uint64_t index = 0; index < header->TileCount; index++) {
+		if (indices[index] >= grid_count) return;
+		if (index != 0 && indices[index] <= indices[index - 1]) return;
+	}
+
+	//the partial heat maps are moved between machines, so the data is checked before it is merged
+	const auto data = reinterpret_cast<const unsigned char*>(mFile->data() + header->IndicesSection);
+	const auto size = static_cast<size_t>(header->TilesSection - header->IndicesSection) +
+		sizeof(float) * TILED_HEAT_MAP_TILE_PIXELS * static_cast<size_t>(header->TileCount);
+
+	if (ImageWriter::crc32(data, size) != header->Checksum) return;
+
+	mHeader = header;
+}
+
+auto TiledHeatMapFile::is_open() const -> bool {
+	return mHeader != nullptr;
+}
+
+auto TiledHeatMapFile::width() const -> size_t {
+	return static_cast<size_t>(mHeader->Width);
+}
+
+auto TiledHeatMapFile::height() const -> size_t {
+	return static_cast<size_t>(mHeader->Height);
+}
+
+auto TiledHeatMapFile::shard_index() const -> size_t {
+	return static_cast<size_t>(mHeader->ShardIndex);
+}
+
+auto TiledHeatMapFile::shard_count() const -> size_t {
+	return static_cast<size_t>(mHeader->ShardCount);
+}
+
+auto TiledHeatMapFile::tile_count() const -> size_t {
+	return static_cast<size_t>(mHeader->TileCount);
+}
+
+auto TiledHeatMapFile::index(size_t tile) const -> size_t {
+	return static_cast<size_t>(reinterpret_cast<const uint64_t*>(mFile->data() + mHeader->IndicesSection)[tile]);
+}
+
+auto TiledHeatMapFile::tile(size_t tile) const -> const float* {
+	return reinterpret_cast<const float*>(mFile->data() + mHeader->TilesSection) + tile * TILED_HEAT_MAP_TILE_PIXELS;
+}
+
+auto TiledHeatMapFile::grid_tile_count(size_t width, size_t height) -> size_t {
+	return
+		((width + TILED_HEAT_MAP_TILE_SIZE - 1) / TILED_HEAT_MAP_TILE_SIZE) *
+		((height + TILED_HEAT_MAP_TILE_SIZE - 1) / TILED_HEAT_MAP_TILE_SIZE);
+}
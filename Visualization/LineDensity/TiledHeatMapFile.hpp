@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Common.hpp"
+#include "MappedFile.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#define TILED_HEAT_MAP_TILE_SIZE 64
+#define TILED_HEAT_MAP_TILE_PIXELS (TILED_HEAT_MAP_TILE_SIZE * TILED_HEAT_MAP_TILE_SIZE)
+
+#define TILED_HEAT_MAP_MAGIC 0x31484C54 //"TLH1"
+#define TILED_HEAT_MAP_VERSION 2
+
+//the header of tiled heat map file, all values are little-endian
+//the sections are : indices(uint64 * tile count), tiles(float32 * tile size * tile size * tile count)
+struct TiledHeatMapHeader {
+	uint32_t Magic;
+	uint32_t Version;
+
+	uint64_t Width;
+	uint64_t Height;
+
+	uint32_t TileSize;
+
+	//the crc32 of indices and tiles sections
+	uint32_t Checksum;
+
+	//the number of tiles in file, the tiles not in file are zero
+	uint64_t TileCount;
+
+	//the byte offsets of sections from the begin of file
+	uint64_t IndicesSection;
+	uint64_t TilesSection;
+
+	//the partial heat map of shard index in shard count, the whole heat map is 0 of 1
+	uint32_t ShardIndex;
+	uint32_t ShardCount;
+};
+
+//the tiled heat map file, it is memory-mapped and the tiles are used without copy
+//the indices are increasing, the tile t is (t % ceil(width / tile size), t / ceil(width / tile size)) and it is row major
+class TiledHeatMapFile {
+public:
+	//the checksum is verified when the file is opened
+	explicit TiledHeatMapFile(const std::string& fileName);
+
+	//the file is mapped, the header is valid and the checksum is matched
+	auto is_open() const -> bool;
+
+	auto width() const -> size_t;
+
+	auto height() const -> size_t;
+
+	auto shard_index() const -> size_t;
+
+	auto shard_count() const -> size_t;
+
+	//the number of tiles in file
+	auto tile_count() const -> size_t;
+
+	//the index of i-th tile in file
+	auto index(size_t tile) const -> size_t;
+
+	//the density of i-th tile in file, row major
+	auto tile(size_t tile) const -> const float*;
+
+	//the number of tiles of heat map with width x height
+	static auto grid_tile_count(size_t width, size_t height) -> size_t;
+private:
+	std::shared_ptr<MappedFile> mFile;
+
+	const TiledHeatMapHeader* mHeader;
+};
@@ -1,20 +1,9 @@
 #pragma once
 
-#include <memory>
-#include <fstream>
-
-#include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
+#include "Common.hpp"
 
 #include <WindowsFramework.hpp>
 
-using real = float;
-using vec2 = glm::vec<2, real, glm::defaultp>;
-using vec3 = glm::vec<3, real, glm::defaultp>;
-using vec4 = glm::vec<4, real, glm::defaultp>;
-using mat4 = glm::mat<4, 4, real, glm::defaultp>;
-using byte = unsigned char;
-
 class ShaderFile {
 public:
 	static auto read(const std::string& fileName)->std::vector<byte> {
@@ -1,23 +1,38 @@
+#include "CpuDensityGenerator.hpp"
+#include "TiledDensityGenerator.hpp"
+#include "HeatMapMerger.hpp"
+#include "StreamDensityGenerator.hpp"
+#include "PyramidDensityGenerator.hpp"
+#include "CategoryDensityGenerator.hpp"
+#include "IncrementalDensity.hpp"
+#include "SeriesTileIndex.hpp"
+#include "ColorLookupTable.hpp"
+#include "ImageWriter.hpp"
+#include "CpuSharpGenerator.hpp"
+#include "RandomLineGenerator.hpp"
+#include "Benchmark.hpp"
+#include "ColorMapped.hpp"
+#include "CommandList.hpp"
+
+#ifdef LINE_DENSITY_GPU
 #include "DensityGenerator.hpp"
 #include "ImageGenerator.hpp"
 #include "SharpGenerator.hpp"
-#include "ColorMapped.hpp"
-#include "CommandList.hpp"
 #include "TestUnit.hpp"
 
 #include <WindowsFactory.hpp>
 #include <WindowsGraphics.hpp>
+#endif
 
 #include <chrono>
+#include <deque>
+#include <sstream>
 
 using time_point = std::chrono::high_resolution_clock;
 
 class DensityContext {
 public:
 	DensityContext() {
-		mGraphics = std::make_shared<WindowsGraphics>();
-		mFactory = std::make_shared<WindowsFactory>(mGraphics.get());
-
 		mColorMapped = std::make_shared<ColorMapped>(
 			std::vector<vec4>({
 				vec4(0.0f,0.0f,0.0f,1.0f),
@@ -26,11 +41,28 @@ public:
 	}
 
 	void run() {
-		input_line_data();
 		input_color_mapped();
+
+		//the benchmark generates its own data, so the other outputs are skipped
+		if (mBenchmarkName.empty() == false) {
+			benchmark();
+			return;
+		}
+
+		//the partial heat maps are merged without line data
+		if (mMergeNames.empty() == false) {
+			merge_heat_map();
+			return;
+		}
+
+		input_line_data();
 		random_line_data();
 		output_line_data();
 		output_heat_map();
+		output_tiled_heat_map();
+		output_heat_pyramid();
+		output_category_heat_map();
+		output_series_index();
 		output_line_image();
 		output_color_mapped();
 	}
@@ -38,14 +70,30 @@ private:
 	void input_line_data() {
 		if (mInputLineName.empty() == true) return;
 
-		std::cout << "start read data from file[" << mInputLineName << "]." << std::endl;
+		//the data is read in chunks when the heat map is built, only the header is read here
+		if (is_streaming() == true) {
+			//the reader is kept for the window, the feed(pipe) can only be opened once
+			mLineSeriesReader = std::make_shared<LineSeriesReader>(mInputLineName);
+			assert(mLineSeriesReader->is_open() == true);
+
+			mLineSeries = std::make_shared<LineSeriesBatch>(mLineSeriesReader->width(), mLineSeriesReader->height());
+			mHeatMapWidth = mLineSeriesReader->width();
+			mHeatMapHeight = mLineSeriesReader->height();
+			mBackend = "cpu";
 
-		const auto data = LineSeries::read_from_file(mInputLineName);
+			if (mWindowSize != 0)
+				std::cout << "stream data from file[" << mInputLineName << "] with window of " << mWindowSize << " line series." << std::endl;
+			else
+				std::cout << "stream data from file[" << mInputLineName << "] with memory budget " << mStreamBudget << "MB." << std::endl;
+
+			return;
+		}
+
+		std::cout << "start read data from file[" << mInputLineName << "]." << std::endl;
 
-		mDensityGenerator = std::make_shared<DensityGenerator>(mFactory.get(), 
-			std::get<0>(data), 
-			std::get<1>(data),
-			std::get<2>(data));
+		mLineSeries = LineSeriesBatch::read_from_file(mInputLineName, mThreadCount);
+		mHeatMapWidth = mLineSeries->width();
+		mHeatMapHeight = mLineSeries->height();
 
 		std::cout << "end read data from file." << std::endl;
 	}
@@ -71,19 +119,17 @@ private:
 		if (mInputLineName.empty() == false) return;
 
 		std::cout << "start build data randomly." << std::endl;
-		std::cout << "build " << mRandomLineSeriesCount << " line series with " << mRandomLineCount << " lines." << std::endl;
+		std::cout << "build " << mRandomLineSeriesCount << " line series with " << mRandomLineCount << " lines, seed " << mRandomSeed << "." << std::endl;
 
 		const auto start_time = time_point::now();
 
-		std::vector<LineSeries> data;
+		//the data only depends on the seed, the thread count does not change it
+		const auto data = RandomLineGenerator::make(mRandomLineSeriesCount, mRandomLineCount,
+			mRandomHeatMapWidth, mRandomHeatMapHeight, mRandomSeed, mThreadCount);
 
-		const auto width = static_cast<real>(mRandomHeatMapWidth);
-		const auto height = static_cast<real>(mRandomHeatMapHeight);
-
-		for (size_t index = 0; index < mRandomLineSeriesCount;index++) 
-			data.push_back(LineSeries::random_make(mRandomLineCount, width, height));
-
-		mDensityGenerator = std::make_shared<DensityGenerator>(mFactory.get(), data, mRandomHeatMapWidth, mRandomHeatMapHeight);
+		mLineSeries = data;
+		mHeatMapWidth = mRandomHeatMapWidth;
+		mHeatMapHeight = mRandomHeatMapHeight;
 
 		const auto end_time = time_point::now();
 
@@ -92,30 +138,123 @@ private:
 	}
 
 	void output_line_data() const {
-		if (mOutputDataName.empty() == true ||
-			mDensityGenerator == nullptr) {
-			if (mDensityGenerator == nullptr) std::cout << "error : output line data is not existed." << std::endl;
-			
+		if (mOutputDataName.empty() == true) return;
+
+		if (is_streaming() == true) {
+			std::cout << "error : output line data is not supported with stream data." << std::endl;
 			return;
 		}
 
 		std::cout << "output line data to file[" << mOutputDataName << "]." << std::endl;
 
-		LineSeries::save_to_file(mOutputDataName, 
-			std::make_tuple(mDensityGenerator->data(), mDensityGenerator->width(), mDensityGenerator->height()));
+		LineSeriesBatch::save_to_file(mOutputDataName, *mLineSeries);
 	}
 
 	void output_heat_map() {
 		if (mOutputHeatMapName.empty() == true) return;
 
-		std::cout << "start build heat map." << std::endl;
-		std::cout << "heat map width : " << mDensityGenerator->width() << ", heat map height : " << mDensityGenerator->height() << "." << std::endl;
+		std::cout << "start build heat map with " << mBackend << " backend." << std::endl;
+		std::cout << "heat map width : " << mHeatMapWidth << ", heat map height : " << mHeatMapHeight << "." << std::endl;
 		
 		const auto start_time = time_point::now();
 
-		mImageGenerator = std::make_shared<ImageGenerator>(mDensityGenerator, mColorMapped);		
-		
-		mDensityGenerator->run();
+		//the heat map is built by CPU when streaming or using cpu or tiled backend, row major
+		const auto cpu_heat_map = is_streaming() == true || mBackend == "cpu" || mBackend == "tiled";
+
+		std::vector<real> heatmap;
+
+		if (is_streaming() == true && mWindowSize != 0) {
+			if (mWindowSnapshotInterval != 0 && ImageWriter::is_supported(mOutputHeatMapName) == false) {
+				std::cout << "error : output heat map file should be \".png\" or \".rgba\" with snapshots of window." << std::endl;
+				return;
+			}
+
+			IncrementalDensity density(mHeatMapWidth, mHeatMapHeight);
+
+			//the ids of series in window, the oldest is removed when a new series comes
+			std::deque<size_t> window;
+
+			size_t series_count = 0;
+
+			//the feed is read series by series if the snapshots are written, so the snapshot does not wait for a full chunk
+			const size_t chunk_bytes = mWindowSnapshotInterval != 0 ? 0 : 1 << 20;
+
+			while (true) {
+				LineSeriesBatch chunk(mHeatMapWidth, mHeatMapHeight);
+
+				if (mLineSeriesReader->read(chunk, chunk_bytes) == false) break;
+
+				for (size_t index = 0; index < chunk.size(); index++) {
+					window.push_back(density.add(chunk[index]));
+
+					if (window.size() > mWindowSize) {
+						density.remove(window.front());
+						window.pop_front();
+					}
+
+					if (mWindowSnapshotInterval == 0 || ++series_count % mWindowSnapshotInterval != 0) continue;
+
+					std::vector<uint32_t> image;
+
+					ColorLookupTable(*mColorMapped).map(density.snapshot(), mHeatMapWidth, mHeatMapHeight, image, mThreadCount);
+
+					std::cout << "output snapshot of window after " << series_count << " line series to file[" << mOutputHeatMapName << "]." << std::endl;
+
+					ImageWriter::save(mOutputHeatMapName, image, mHeatMapWidth, mHeatMapHeight, mThreadCount);
+				}
+			}
+
+			heatmap = density.snapshot();
+		}
+		else if (is_streaming() == true) {
+			StreamDensityGenerator generator(mInputLineName, mStreamBudget << 20, mThreadCount, mDecimation);
+
+			std::cout << "stream chunk size : " << (generator.chunk_bytes() >> 10) << "KB." << std::endl;
+
+			generator.run();
+
+			std::cout << "cpu kernel : " << DensityKernel::name(generator.kernel()) << "." << std::endl;
+
+			heatmap = generator.heatmap();
+		}
+		else if (mBackend == "cpu") {
+			mCpuDensityGenerator = std::make_shared<CpuDensityGenerator>(mLineSeries, mHeatMapWidth, mHeatMapHeight, mThreadCount, mDecimation);
+			mCpuDensityGenerator->run();
+
+			std::cout << "cpu kernel : " << DensityKernel::name(mCpuDensityGenerator->kernel()) << "." << std::endl;
+
+			heatmap = mCpuDensityGenerator->heatmap();
+		}
+		else if (mBackend == "tiled") {
+			std::cout << "cpu kernel : " << DensityKernel::name(tiled_density_generator()->kernel()) << "." << std::endl;
+
+			heatmap = tiled_density_generator()->heatmap().to_dense();
+		}
+#ifdef LINE_DENSITY_GPU
+		else density_generator()->run();
+#endif
+
+		//the color mapped is done by CPU too if the image can be written without device
+		if (cpu_heat_map == true && ImageWriter::is_supported(mOutputHeatMapName) == true) {
+			std::vector<uint32_t> image;
+
+			ColorLookupTable(*mColorMapped).map(heatmap, mHeatMapWidth, mHeatMapHeight, image, mThreadCount);
+
+			const auto end_time = time_point::now();
+
+			std::cout << "end build heat map, cost " <<
+				std::chrono::duration_cast<std::chrono::duration<float>>(end_time - start_time).count() << "s." << std::endl;
+			std::cout << "output heat map to file[" << mOutputHeatMapName << "]." << std::endl;
+
+			ImageWriter::save(mOutputHeatMapName, image, mHeatMapWidth, mHeatMapHeight, mThreadCount);
+
+			return;
+		}
+
+#ifdef LINE_DENSITY_GPU
+		if (cpu_heat_map == true) density_generator()->upload(heatmap);
+
+		mImageGenerator = std::make_shared<ImageGenerator>(density_generator(), mColorMapped);
 		mImageGenerator->run();
 
 		const auto end_time = time_point::now();
@@ -125,17 +264,237 @@ private:
 		std::cout << "output heat map to file[" << mOutputHeatMapName << "]." << std::endl;
 		
 		mImageGenerator->save(simple_to_wstring(mOutputHeatMapName));
+#else
+		std::cout << "error : output heat map file should be \".png\" or \".rgba\" without gpu backend." << std::endl;
+#endif
+	}
+
+	void output_tiled_heat_map() {
+		if (mOutputTiledName.empty() == true) return;
+
+		if (is_streaming() == true) {
+			std::cout << "error : output tiled heat map is not supported with stream data." << std::endl;
+			return;
+		}
+
+		std::cout << "start build tiled heat map." << std::endl;
+
+		const auto start_time = time_point::now();
+		const auto generator = tiled_density_generator();
+		const auto& heatmap = generator->heatmap();
+		const auto end_time = time_point::now();
+
+		if (generator->shard_count() > 1) {
+			std::cout << "shard " << generator->shard_index() << "/" << generator->shard_count() << " : line series [" <<
+				generator->series_begin() << ", " << generator->series_end() << ")." << std::endl;
+		}
+
+		std::cout << "end build tiled heat map with " << heatmap.allocated_count() << " of " << heatmap.tile_count() << " tiles(" <<
+			(heatmap.bytes() >> 20) << "MB), cost " <<
+			std::chrono::duration_cast<std::chrono::duration<float>>(end_time - start_time).count() << "s." << std::endl;
+		std::cout << "output tiled heat map to file[" << mOutputTiledName << "]." << std::endl;
+
+		if (heatmap.save(mOutputTiledName, generator->shard_index(), generator->shard_count()) == false)
+			std::cout << "error : tiled heat map file is little endian, the host is not supported." << std::endl;
+	}
+
+	void merge_heat_map() {
+		std::cout << "start merge " << mMergeNames.size() << " partial heat maps." << std::endl;
+
+		const auto start_time = time_point::now();
+
+		HeatMapMerger merger(mMergeNames);
+
+		for (auto& fileName : merger.invalid_files())
+			std::cout << "error : partial heat map file[" << fileName << "] is invalid or has different size." << std::endl;
+
+		if (merger.is_open() == false) return;
+
+		if (merger.is_complete() == false)
+			std::cout << "warning : the partial heat maps are not the shards of one run, the heat map may miss or repeat line series." << std::endl;
+
+		std::cout << "heat map width : " << merger.width() << ", heat map height : " << merger.height() <<
+			", tiles : " << merger.tile_count() << "." << std::endl;
+
+		if (mOutputTiledName.empty() == false) {
+			std::cout << "output tiled heat map to file[" << mOutputTiledName << "]." << std::endl;
+
+			merger.save(mOutputTiledName);
+		}
+
+		if (mOutputHeatMapName.empty() == false) {
+			if (ImageWriter::is_supported(mOutputHeatMapName) == false) {
+				std::cout << "error : output merged heat map file should be \".png\" or \".rgba\"." << std::endl;
+				return;
+			}
+
+			if (merger.is_image_too_large() == true) {
+				std::cout << "error : merged heat map is too large to output as image, use \"-ot\" to output tiled heat map." << std::endl;
+				return;
+			}
+
+			std::vector<uint32_t> image;
+
+			merger.map(ColorLookupTable(*mColorMapped), image);
+
+			std::cout << "output heat map to file[" << mOutputHeatMapName << "]." << std::endl;
+
+			ImageWriter::save(mOutputHeatMapName, image, merger.width(), merger.height(), mThreadCount);
+		}
+
+		const auto end_time = time_point::now();
+
+		std::cout << "end merge partial heat maps, cost " <<
+			std::chrono::duration_cast<std::chrono::duration<float>>(end_time - start_time).count() << "s." << std::endl;
+	}
+
+	void output_heat_pyramid() {
+		if (mOutputPyramidName.empty() == true) return;
+
+		if (is_streaming() == true) {
+			std::cout << "error : output heat map pyramid is not supported with stream data." << std::endl;
+			return;
+		}
+
+		std::cout << "start build heat map pyramid." << std::endl;
+
+		const auto start_time = time_point::now();
+
+		PyramidDensityGenerator generator(mLineSeries, mHeatMapWidth, mHeatMapHeight, mPyramidLevelCount, mThreadCount);
+
+		generator.run();
+
+		const auto end_time = time_point::now();
+
+		std::cout << "end build heat map pyramid with " << generator.level_count() << " levels, cost " <<
+			std::chrono::duration_cast<std::chrono::duration<float>>(end_time - start_time).count() << "s." << std::endl;
+		std::cout << "output heat map pyramid to file[" << mOutputPyramidName << "]." << std::endl;
+
+		generator.save(mOutputPyramidName);
+	}
+
+	void output_category_heat_map() {
+		if (mOutputCategoryName.empty() == true && mOutputBlendedName.empty() == true) return;
+
+		if (is_streaming() == true) {
+			std::cout << "error : output category heat map is not supported with stream data." << std::endl;
+			return;
+		}
+
+		std::cout << "start build category heat map." << std::endl;
+
+		const auto start_time = time_point::now();
+
+		CategoryDensityGenerator generator(mLineSeries, mHeatMapWidth, mHeatMapHeight, mThreadCount, mMaxCategoryCount);
+
+		if (generator.is_valid() == false) {
+			std::cout << "error : line data has more than " << mMaxCategoryCount << " categories(colors), use -kl to set the max number of categories." << std::endl;
+			return;
+		}
+
+		generator.run();
+
+		const auto end_time = time_point::now();
+
+		std::cout << "end build category heat map with " << generator.category_count() << " categories, cost " <<
+			std::chrono::duration_cast<std::chrono::duration<float>>(end_time - start_time).count() << "s." << std::endl;
+
+		if (mOutputCategoryName.empty() == false) {
+			std::cout << "output category heat map to file[" << mOutputCategoryName << "]." << std::endl;
+
+			generator.save(mOutputCategoryName, *mColorMapped);
+		}
+
+		if (mOutputBlendedName.empty() == false) {
+			std::cout << "output blended heat map to file[" << mOutputBlendedName << "]." << std::endl;
+
+			generator.save_blended(mOutputBlendedName);
+		}
+	}
+
+	void output_series_index() {
+		if (mOutputIndexName.empty() == true && mQueryRectangle.empty() == true) return;
+
+		if (is_streaming() == true) {
+			std::cout << "error : series index is not supported with stream data." << std::endl;
+			return;
+		}
+
+		std::shared_ptr<SeriesTileIndex> index;
+
+		if (mInputIndexName.empty() == false) {
+			std::cout << "read series index from file[" << mInputIndexName << "]." << std::endl;
+
+			index = std::make_shared<SeriesTileIndex>(mInputIndexName, mLineSeries, mHeatMapWidth, mHeatMapHeight);
+
+			if (index->is_open() == false) {
+				std::cout << "error : series index file[" << mInputIndexName << "] is invalid or is not built from the line data(" <<
+					mLineSeries->size() << " line series, " << mHeatMapWidth << "x" << mHeatMapHeight << " heatmap)." << std::endl;
+				return;
+			}
+		}
+		else {
+			std::cout << "start build series index." << std::endl;
+
+			const auto start_time = time_point::now();
+
+			index = std::make_shared<SeriesTileIndex>(mLineSeries, mHeatMapWidth, mHeatMapHeight, SERIES_TILE_INDEX_TILE_SIZE, mThreadCount);
+
+			const auto end_time = time_point::now();
+
+			std::cout << "end build series index, cost " <<
+				std::chrono::duration_cast<std::chrono::duration<float>>(end_time - start_time).count() << "s." << std::endl;
+		}
+
+		if (mOutputIndexName.empty() == false) {
+			std::cout << "output series index to file[" << mOutputIndexName << "]." << std::endl;
+
+			index->save(mOutputIndexName);
+		}
+
+		if (mQueryRectangle.empty() == false) {
+			const auto query_start_time = time_point::now();
+			const auto result = index->query(mQueryRectangle[0], mQueryRectangle[1], mQueryRectangle[2], mQueryRectangle[3]);
+			const auto query_end_time = time_point::now();
+
+			std::cout << "query [" << mQueryRectangle[0] << ", " << mQueryRectangle[2] << ") x [" <<
+				mQueryRectangle[1] << ", " << mQueryRectangle[3] << ") : " << result.size() << " line series, cost " <<
+				std::chrono::duration_cast<std::chrono::duration<float>>(query_end_time - query_start_time).count() << "s." << std::endl;
+		}
 	}
 
 	void output_line_image() {
 		if (mOutputImageName.empty() == true) return;
 
+		if (is_streaming() == true) {
+			std::cout << "error : output line image is not supported with stream data." << std::endl;
+			return;
+		}
+
 		std::cout << "start build image with line width " << mLineWidth << "." << std::endl;
 		std::cout << "image width : " << mImageWidth << ", image height : " << mImageHeight << "." << std::endl;
 
 		const auto start_time = time_point::now();
 
-		mSharpGenerator = std::make_shared<SharpGenerator>(mFactory.get(), mDensityGenerator, mImageWidth, mImageHeight);
+		//the line image of cpu backends is rasterized by CPU if the image can be written without device
+		if (mBackend != "gpu" && ImageWriter::is_supported(mOutputImageName) == true) {
+			CpuSharpGenerator generator(mLineSeries, mImageWidth, mImageHeight, mThreadCount);
+
+			generator.run(mLineWidth);
+
+			const auto end_time = time_point::now();
+
+			std::cout << "end build image, cost " <<
+				std::chrono::duration_cast<std::chrono::duration<float>>(end_time - start_time).count() << "s." << std::endl;
+			std::cout << "output image to file[" << mOutputImageName << "]." << std::endl;
+
+			generator.save(mOutputImageName);
+
+			return;
+		}
+
+#ifdef LINE_DENSITY_GPU
+		mSharpGenerator = std::make_shared<SharpGenerator>(factory(), density_generator(), mImageWidth, mImageHeight);
 		mSharpGenerator->run(mLineWidth);
 
 		const auto end_time = time_point::now();
@@ -145,6 +504,32 @@ private:
 		std::cout << "output image to file[" << mOutputImageName << "]." << std::endl;
 
 		mSharpGenerator->save(simple_to_wstring(mOutputImageName));
+#else
+		std::cout << "error : output line image file should be \".png\" or \".rgba\" without gpu backend." << std::endl;
+#endif
+	}
+
+	void benchmark() {
+		std::cout << "start benchmark with config file[" << mBenchmarkName << "]." << std::endl;
+
+#ifdef LINE_DENSITY_GPU
+		Benchmark benchmark(mBenchmarkName, mColorMapped, mThreadCount, [this]() { return factory(); });
+#else
+		Benchmark benchmark(mBenchmarkName, mColorMapped, mThreadCount);
+#endif
+
+		if (benchmark.is_valid() == false) return;
+
+		benchmark.run();
+
+		if (mBenchmarkOutputName.empty() == true) {
+			std::cout << benchmark.to_json();
+			return;
+		}
+
+		std::cout << "output benchmark result to file[" << mBenchmarkOutputName << "]." << std::endl;
+
+		benchmark.save(mBenchmarkOutputName);
 	}
 
 	void output_color_mapped() const {
@@ -159,6 +544,42 @@ private:
 		file.close();
 	}
 
+#ifdef LINE_DENSITY_GPU
+	//the device is created when it is first used, so the cpu backend can run without GPU
+	auto factory() -> Factory* {
+		if (mFactory == nullptr) {
+			mGraphics = std::make_shared<WindowsGraphics>();
+			mFactory = std::make_shared<WindowsFactory>(mGraphics.get());
+		}
+
+		return mFactory.get();
+	}
+
+	auto density_generator() -> std::shared_ptr<DensityGenerator> {
+		if (mDensityGenerator == nullptr)
+			mDensityGenerator = std::make_shared<DensityGenerator>(factory(), mLineSeries, mHeatMapWidth, mHeatMapHeight);
+
+		return mDensityGenerator;
+	}
+#endif
+
+	//the tiled heat map is built once, it is used by the heat map and the tiled output
+	//with shards, only the series of shard are in it
+	auto tiled_density_generator() -> std::shared_ptr<TiledDensityGenerator> {
+		if (mTiledDensityGenerator == nullptr) {
+			mTiledDensityGenerator = std::make_shared<TiledDensityGenerator>(mLineSeries, mHeatMapWidth, mHeatMapHeight,
+				mThreadCount, mShardIndex, mShardCount);
+			mTiledDensityGenerator->run();
+		}
+
+		return mTiledDensityGenerator;
+	}
+
+	auto is_streaming() const -> bool {
+		return (mStreamBudget != 0 || mWindowSize != 0) && mInputLineName.empty() == false;
+	}
+
+#ifdef LINE_DENSITY_GPU
 	static auto simple_to_wstring(const std::string &str) -> std::wstring {
 		std::wstring result;
 
@@ -167,6 +588,7 @@ private:
 
 		return result;
 	}
+#endif
 public:
 	std::string mInputLineName;
 	std::string mInputColorMappedName;
@@ -174,6 +596,23 @@ public:
 	std::string mOutputImageName;
 	std::string mOutputDataName;
 	std::string mOutputColorMappedName;
+	std::string mOutputPyramidName;
+	std::string mOutputTiledName;
+	std::string mOutputCategoryName;
+	std::string mOutputBlendedName;
+	std::string mBenchmarkName;
+	std::string mBenchmarkOutputName;
+	std::string mOutputIndexName;
+	std::string mInputIndexName;
+
+	//the partial heat maps(tiled heat map files) to merge
+	std::vector<std::string> mMergeNames;
+
+#ifdef LINE_DENSITY_GPU
+	std::string mBackend = "gpu";
+#else
+	std::string mBackend = "cpu";
+#endif
 
 	float mLineWidth = 1.0f;
 
@@ -185,19 +624,51 @@ public:
 
 	size_t mRandomLineCount = 20;
 	size_t mRandomLineSeriesCount = 1000;
+
+	uint64_t mRandomSeed = 0;
+
+	size_t mThreadCount = 0;
+
+	bool mDecimation = false;
+
+	size_t mStreamBudget = 0;
+
+	size_t mPyramidLevelCount = 0;
+
+	size_t mMaxCategoryCount = CATEGORY_DENSITY_MAX_CATEGORY_COUNT;
+
+	size_t mWindowSize = 0;
+	size_t mWindowSnapshotInterval = 0;
+
+	size_t mShardIndex = 0;
+	size_t mShardCount = 1;
+
+	//column begin, row begin, column end, row end
+	std::vector<size_t> mQueryRectangle;
 private:
+	std::shared_ptr<const LineSeriesBatch> mLineSeries;
+	std::shared_ptr<LineSeriesReader> mLineSeriesReader;
+
+	size_t mHeatMapWidth = 0;
+	size_t mHeatMapHeight = 0;
+
+	std::shared_ptr<ColorMapped> mColorMapped;
+	std::shared_ptr<CpuDensityGenerator> mCpuDensityGenerator;
+	std::shared_ptr<TiledDensityGenerator> mTiledDensityGenerator;
+
+#ifdef LINE_DENSITY_GPU
 	std::shared_ptr<WindowsGraphics> mGraphics;
 	std::shared_ptr<WindowsFactory> mFactory;
 
-	std::shared_ptr<ColorMapped> mColorMapped;
 	std::shared_ptr<DensityGenerator> mDensityGenerator;
 	std::shared_ptr<ImageGenerator> mImageGenerator;
 	std::shared_ptr<SharpGenerator> mSharpGenerator;
+#endif
 };
 
 /*
  * Density Command List
- * -id fileName : input the line file.
+ * -id fileName : input the line file, ".lsb" is the binary line file.
  * -wl width : set the line width.
  * -ic fileName : input the color mapped file.
  * -rw width : set the random heat map width.
@@ -206,10 +677,30 @@ private:
  * -lh height : set the line image height.
  * -rl count : set the random line count.
  * -rs count : set the random line series count.
- * -om fileName : output the heat map.
- * -ol fileName : output the line image.
- * -od fileName : output the line data.
+ * -sd seed : set the seed of random line data.
+ * -om fileName : output the heat map, with cpu backend ".png" and ".rgba" are written without device.
+ * -ol fileName : output the line image, with cpu backend ".png" and ".rgba" are written without device.
+ * -od fileName : output the line data, ".lsb" is the binary line file.
  * -oc fileName : output the color mapped.
+ * -bk backend : set the backend of heat map, gpu, cpu or tiled, only cpu and tiled without gpu build(default is cpu).
+ * -tc count : set the thread count of cpu backend, 0 means hardware concurrency.
+ * -dc enable : decimate the line series(M4) before cpu backend, 0 or 1.
+ * -sm budget : stream the input line data with memory budget(MB), 0 means reading all data.
+ * -wn count : stream the input line data and only keep the last count line series in heat map.
+ * -wk count : with -wn, output the heat map of window after every count line series, 0 means only at the end.
+ * -oi fileName : output the series index of tiles.
+ * -ii fileName : input the series index of tiles, it is used by query.
+ * -qr c0,r0,c1,r1 : query the line series that pass the pixels [c0, c1) x [r0, r1) of heat map.
+ * -ot fileName : output the sparse tiled heat map, only the touched tiles are saved.
+ * -sh i/n : only build the tiled heat map of shard i of n, the shards split the line series into n parts.
+ * -mg f0,f1,... : merge the partial tiled heat maps into "-om" or "-ot", the line data is not used.
+ * -op prefix : output the heat map pyramid, the manifest is "prefix.txt".
+ * -pl count : set the level count of heat map pyramid, 0 means all levels.
+ * -ok prefix : output the heat map of each category(color of series) as "prefix_k.png", the categories are in "prefix.txt".
+ * -ob fileName : output the heat map that blends the colors of categories, ".png" or ".rgba".
+ * -kl count : set the max number of categories of -ok and -ob, default is 256.
+ * -bm fileName : run the benchmark with the config file, see Benchmark.
+ * -bo fileName : output the benchmark result(JSON), it is printed if not set.
  */
 int main(int argc, char** argv) {
 	CommandList commandList;
@@ -274,6 +765,11 @@ int main(int argc, char** argv) {
 			static_cast<DensityContext*>(ctx)->mRandomLineSeriesCount = std::stoull(count);
 			return true;
 		});
+	commandList.setCommand("-sd", [](void* ctx, const std::string& seed)
+		{
+			static_cast<DensityContext*>(ctx)->mRandomSeed = std::stoull(seed);
+			return true;
+		});
 	commandList.setCommand("-om", [](void* ctx, const std::string& fileName)
 		{
 			if (fileName.size() == 0) {
@@ -319,6 +815,205 @@ int main(int argc, char** argv) {
 			return true;
 		});
 
+	commandList.setCommand("-bk", [](void* ctx, const std::string& backend)
+		{
+			if (backend != "gpu" && backend != "cpu" && backend != "tiled") {
+				std::cout << "error : backend should be gpu, cpu or tiled." << std::endl;
+				return false;
+			}
+
+#ifndef LINE_DENSITY_GPU
+			if (backend == "gpu") {
+				std::cout << "error : gpu backend is not built, only cpu and tiled are supported." << std::endl;
+				return false;
+			}
+#endif
+
+			static_cast<DensityContext*>(ctx)->mBackend = backend;
+
+			return true;
+		});
+	commandList.setCommand("-tc", [](void* ctx, const std::string& count)
+		{
+			static_cast<DensityContext*>(ctx)->mThreadCount = std::stoull(count);
+			return true;
+		});
+	commandList.setCommand("-dc", [](void* ctx, const std::string& enable)
+		{
+			if (enable != "0" && enable != "1") {
+				std::cout << "error : decimation should be 0 or 1." << std::endl;
+				return false;
+			}
+
+			static_cast<DensityContext*>(ctx)->mDecimation = enable == "1";
+
+			return true;
+		});
+	commandList.setCommand("-sm", [](void* ctx, const std::string& budget)
+		{
+			static_cast<DensityContext*>(ctx)->mStreamBudget = std::stoull(budget);
+			return true;
+		});
+	commandList.setCommand("-wn", [](void* ctx, const std::string& count)
+		{
+			static_cast<DensityContext*>(ctx)->mWindowSize = std::stoull(count);
+			return true;
+		});
+	commandList.setCommand("-wk", [](void* ctx, const std::string& count)
+		{
+			static_cast<DensityContext*>(ctx)->mWindowSnapshotInterval = std::stoull(count);
+			return true;
+		});
+	commandList.setCommand("-oi", [](void* ctx, const std::string& fileName)
+		{
+			if (fileName.size() == 0) {
+				std::cout << "error : output series index file is invalid." << std::endl;
+				return false;
+			}
+
+			static_cast<DensityContext*>(ctx)->mOutputIndexName = fileName;
+
+			return true;
+		});
+	commandList.setCommand("-ii", [](void* ctx, const std::string& fileName)
+		{
+			if (fileName.size() == 0) {
+				std::cout << "error : input series index file is invalid." << std::endl;
+				return false;
+			}
+
+			static_cast<DensityContext*>(ctx)->mInputIndexName = fileName;
+
+			return true;
+		});
+	commandList.setCommand("-qr", [](void* ctx, const std::string& rectangle)
+		{
+			std::vector<size_t> values;
+			std::stringstream stream(rectangle);
+			std::string value;
+
+			while (std::getline(stream, value, ',')) values.push_back(std::stoull(value));
+
+			if (values.size() != 4) {
+				std::cout << "error : query rectangle should be c0,r0,c1,r1." << std::endl;
+				return false;
+			}
+
+			static_cast<DensityContext*>(ctx)->mQueryRectangle = values;
+
+			return true;
+		});
+	commandList.setCommand("-ot", [](void* ctx, const std::string& fileName)
+		{
+			if (fileName.size() == 0) {
+				std::cout << "error : output tiled heat map file is invalid." << std::endl;
+				return false;
+			}
+
+			static_cast<DensityContext*>(ctx)->mOutputTiledName = fileName;
+
+			return true;
+		});
+	commandList.setCommand("-sh", [](void* ctx, const std::string& shard)
+		{
+			const auto separator = shard.find('/');
+
+			if (separator == std::string::npos || separator == 0 || separator + 1 == shard.size()) {
+				std::cout << "error : shard should be i/n." << std::endl;
+				return false;
+			}
+
+			const auto index = std::stoull(shard.substr(0, separator));
+			const auto count = std::stoull(shard.substr(separator + 1));
+
+			if (count == 0 || index >= count) {
+				std::cout << "error : shard index should be less than shard count." << std::endl;
+				return false;
+			}
+
+			static_cast<DensityContext*>(ctx)->mShardIndex = index;
+			static_cast<DensityContext*>(ctx)->mShardCount = count;
+
+			return true;
+		});
+	commandList.setCommand("-mg", [](void* ctx, const std::string& fileNames)
+		{
+			std::vector<std::string> values;
+			std::stringstream stream(fileNames);
+			std::string value;
+
+			while (std::getline(stream, value, ',')) if (value.empty() == false) values.push_back(value);
+
+			if (values.empty() == true) {
+				std::cout << "error : partial heat map files are invalid." << std::endl;
+				return false;
+			}
+
+			static_cast<DensityContext*>(ctx)->mMergeNames = values;
+
+			return true;
+		});
+	commandList.setCommand("-op", [](void* ctx, const std::string& prefix)
+		{
+			if (prefix.size() == 0) {
+				std::cout << "error : output heat map pyramid file is invalid." << std::endl;
+				return false;
+			}
+
+			static_cast<DensityContext*>(ctx)->mOutputPyramidName = prefix;
+
+			return true;
+		});
+	commandList.setCommand("-pl", [](void* ctx, const std::string& count)
+		{
+			static_cast<DensityContext*>(ctx)->mPyramidLevelCount = std::stoull(count);
+			return true;
+		});
+	commandList.setCommand("-ok", [](void* ctx, const std::string& prefix)
+		{
+			if (prefix.size() == 0) {
+				std::cout << "error : output category heat map file is invalid." << std::endl;
+				return false;
+			}
+
+			static_cast<DensityContext*>(ctx)->mOutputCategoryName = prefix;
+
+			return true;
+		});
+	commandList.setCommand("-ob", [](void* ctx, const std::string& fileName)
+		{
+			if (ImageWriter::is_supported(fileName) == false) {
+				std::cout << "error : output blended heat map file should be \".png\" or \".rgba\"." << std::endl;
+				return false;
+			}
+
+			static_cast<DensityContext*>(ctx)->mOutputBlendedName = fileName;
+
+			return true;
+		});
+	commandList.setCommand("-kl", [](void* ctx, const std::string& count)
+		{
+			static_cast<DensityContext*>(ctx)->mMaxCategoryCount = std::stoull(count);
+			return true;
+		});
+
+	commandList.setCommand("-bm", [](void* ctx, const std::string& fileName)
+		{
+			if (fileName.size() == 0) {
+				std::cout << "error : benchmark config file is invalid." << std::endl;
+				return false;
+			}
+
+			static_cast<DensityContext*>(ctx)->mBenchmarkName = fileName;
+
+			return true;
+		});
+	commandList.setCommand("-bo", [](void* ctx, const std::string& fileName)
+		{
+			static_cast<DensityContext*>(ctx)->mBenchmarkOutputName = fileName;
+			return true;
+		});
+
 	if (commandList.execute(&context, CommandList::read_from_argv(argc, argv)) == false) return -1;
 
 	context.run();
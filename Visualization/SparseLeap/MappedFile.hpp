@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+
+//size(bytes) of the blocks that the key of file samples
+#define MAPPED_FILE_KEY_BLOCK_SIZE 4096
+
+//count of the blocks that the key of file samples
+#define MAPPED_FILE_KEY_BLOCK_COUNT 64
+
+/**
+ * @brief read-only memory-mapped file, the mapping is released when the object is destroyed
+ */
+class MappedFile {
+private:
+	const unsigned char* mData; //mapped data
+	size_t mSize; //file size
+	unsigned long long mModifiedTime; //last write time of file
+
+	void* mFile; //file handle(Windows) or descriptor
+	void* mMapping; //mapping handle(Windows)
+public:
+	MappedFile(const std::string &fileName);
+
+	~MappedFile();
+
+	MappedFile(const MappedFile &) = delete;
+
+	MappedFile& operator = (const MappedFile &) = delete;
+
+	/**
+	 * @brief is the file mapped, empty file is not
+	 */
+	auto isOpen() const -> bool;
+
+	auto data() const -> const unsigned char*;
+
+	auto size() const -> size_t;
+
+	/**
+	 * @brief key of the file, it is the hash of size, last write time and MAPPED_FILE_KEY_BLOCK_COUNT blocks spread over the file
+	 * only the blocks are read, so the key of large file is cheap, the file that is not larger than the blocks is hashed whole
+	 */
+	auto key() const -> unsigned long long;
+
+	/**
+	 * @brief FNV-1a 64 hash of data
+	 */
+	static auto hash(const void* data, size_t size) -> unsigned long long;
+};
@@ -1,8 +1,11 @@
 #include "OccupancyHistogramTree.hpp"
 
 #include "Helper.hpp"
+#include "MappedFile.hpp"
 
+#include <fstream>
 #include <queue>
+#include <thread>
 
 #undef max
 
@@ -147,6 +150,111 @@ void OccupancyHistogramTree::insert(OccupancyHistogramNode * node, const glm::ve
 	}
 }
 
+auto OccupancyHistogramTree::build(OccupancyHistogramNode * node, const OccupancyGrid & grid, int x, int y, int z, int depth) -> int
+{
+	//if get the end, the type comes from grid
+	if (depth >= mMaxDepth) {
+		node->OccupancyTypeCount[(int)grid.at(x, y, z)] = 1;
+
+		node->update();
+
+		return 0;
+	}
+
+	//half of the leaf count that node contained(each axis)
+	int half = 1 << (mMaxDepth - depth - 1);
+	int nodeCount = 0;
+
+	//build children first, so we only sum the histogram once for each node
+	for (int order = 0; order < (int)SpaceOrder::Count; order++) {
+		node->Children[order] = new OccupancyHistogramNode(node, (SpaceOrder)order, depth + 1);
+
+		nodeCount += 1 + build(node->Children[order], grid,
+			x + ((order & 1) != 0 ? half : 0),
+			y + ((order & 2) != 0 ? half : 0),
+			z + ((order & 4) != 0 ? half : 0), depth + 1);
+	}
+
+	return nodeCount - collapse(node, depth);
+}
+
+auto OccupancyHistogramTree::collapse(OccupancyHistogramNode * node, int depth) -> int
+{
+	node->update();
+
+	//the number of leaves that node contained
+	int target = 1 << (3 * (mMaxDepth - depth));
+
+	if (node->OccupancyTypeCount[(int)node->Type] != target) return 0;
+
+	//all leaves are same, the children are collapsed before, so we only free them
+	for (int i = 0; i < (int)SpaceOrder::Count; i++) {
+		Utility::Delete(node->Children[i]);
+	}
+
+	return (int)SpaceOrder::Count;
+}
+
+void OccupancyHistogramTree::release(OccupancyHistogramNode * node)
+{
+	for (int i = 0; i < (int)SpaceOrder::Count; i++) {
+		if (node->Children[i] == nullptr) continue;
+
+		release(node->Children[i]);
+
+		Utility::Delete(node->Children[i]);
+	}
+}
+
+auto OccupancyHistogramTree::save(const OccupancyHistogramNode * node, std::ostream & stream) const -> int
+{
+	OccupancyHistogramTreeFileNode fileNode;
+
+	memset(&fileNode, 0, sizeof(fileNode));
+
+	for (int i = 0; i < (int)SpaceOrder::Count; i++)
+		if (node->Children[i] != nullptr) fileNode.ChildMask |= (unsigned char)(1 << i);
+
+	fileNode.Type = (unsigned char)node->Type;
+
+	memcpy(fileNode.OccupancyTypeCount, node->OccupancyTypeCount, sizeof(fileNode.OccupancyTypeCount));
+
+	stream.write((const char*)&fileNode, sizeof(fileNode));
+
+	int nodeCount = 1;
+
+	for (int i = 0; i < (int)SpaceOrder::Count; i++)
+		if (node->Children[i] != nullptr) nodeCount += save(node->Children[i], stream);
+
+	return nodeCount;
+}
+
+auto OccupancyHistogramTree::load(OccupancyHistogramNode * node, const OccupancyHistogramTreeFileNode * nodes, int nodeCount, int & cursor) -> bool
+{
+	if (cursor >= nodeCount) return false;
+
+	const auto &fileNode = nodes[cursor++];
+
+	if (fileNode.Type >= (unsigned char)OccupancyType::Count) return false;
+
+	//node at max depth can not have children
+	if (fileNode.ChildMask != 0 && node->Depth >= mMaxDepth) return false;
+
+	node->Type = (OccupancyType)fileNode.Type;
+
+	memcpy(node->OccupancyTypeCount, fileNode.OccupancyTypeCount, sizeof(node->OccupancyTypeCount));
+
+	for (int i = 0; i < (int)SpaceOrder::Count; i++) {
+		if ((fileNode.ChildMask & (1 << i)) == 0) continue;
+
+		node->Children[i] = getOccupancyHistogramNode(node, (SpaceOrder)i, node->Depth + 1);
+
+		if (load(node->Children[i], nodes, nodeCount, cursor) == false) return false;
+	}
+
+	return true;
+}
+
 void OccupancyHistogramTree::insertVirtualTree(VirtualNode * virtualNode, OccupancyHistogramNode * node)
 {
 	SpaceOrder order = Helper::getSpaceOrder(virtualNode->Target->AxiallyAlignedBoundingBox, node->AxiallyAlignedBoundingBox);
@@ -246,6 +354,115 @@ void OccupancyHistogramTree::insertNoEmpty(const glm::vec3 &position, OccupancyT
 	insert(&mRoot, position, type, 1);
 }
 
+void OccupancyHistogramTree::build(const OccupancyGrid & grid)
+{
+	assert(grid.Resolution == (1 << (mMaxDepth - 1)));
+	assert(mRoot.isLeaf() == true);
+
+	//only root
+	if (mMaxDepth <= 1) {
+		build(&mRoot, grid, 0, 0, 0, 1);
+
+		return;
+	}
+
+	int half = grid.Resolution / 2;
+	int nodeCount[(int)SpaceOrder::Count];
+
+	std::vector<std::thread> threads;
+
+	//each top-level octant is built in its own thread
+	//the sub trees are disjoint, so they do not need any lock
+	for (int order = 0; order < (int)SpaceOrder::Count; order++) {
+		mRoot.Children[order] = new OccupancyHistogramNode(&mRoot, (SpaceOrder)order, 2);
+
+		threads.push_back(std::thread([this, &grid, &nodeCount, half, order]() {
+			nodeCount[order] = build(mRoot.Children[order], grid,
+				(order & 1) != 0 ? half : 0,
+				(order & 2) != 0 ? half : 0,
+				(order & 4) != 0 ? half : 0, 2);
+		}));
+	}
+
+	for (auto &thread : threads) thread.join();
+
+	mNodeCount = (int)SpaceOrder::Count;
+
+	for (int order = 0; order < (int)SpaceOrder::Count; order++)
+		mNodeCount += nodeCount[order];
+
+	mNodeCount -= collapse(&mRoot, 1);
+}
+
+auto OccupancyHistogramTree::save(const std::string & fileName, unsigned long long volumeKey, float emptyLimit) const -> bool
+{
+	std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+
+	if (file.is_open() == false) return false;
+
+	OccupancyHistogramTreeFileHeader header;
+
+	memset(&header, 0, sizeof(header));
+
+	header.Magic = OCCUPANCY_HISTOGRAM_TREE_FILE_MAGIC;
+	header.Version = OCCUPANCY_HISTOGRAM_TREE_FILE_VERSION;
+	header.VolumeKey = volumeKey;
+	header.MaxDepth = mMaxDepth;
+	header.EmptyLimit = emptyLimit;
+
+	//write the header again when we know the node count
+	file.write((const char*)&header, sizeof(header));
+
+	header.NodeCount = save(&mRoot, file);
+
+	file.seekp(0, std::ios::beg);
+	file.write((const char*)&header, sizeof(header));
+
+	return file.good();
+}
+
+auto OccupancyHistogramTree::load(const std::string & fileName, unsigned long long volumeKey, float emptyLimit) -> bool
+{
+	MappedFile file(fileName);
+
+	if (file.isOpen() == false || file.size() < sizeof(OccupancyHistogramTreeFileHeader)) return false;
+
+	OccupancyHistogramTreeFileHeader header;
+
+	memcpy(&header, file.data(), sizeof(header));
+
+	//the file is built from other volume or setting, or it is broken
+	if (header.Magic != OCCUPANCY_HISTOGRAM_TREE_FILE_MAGIC ||
+		header.Version != OCCUPANCY_HISTOGRAM_TREE_FILE_VERSION ||
+		header.VolumeKey != volumeKey ||
+		header.MaxDepth != mMaxDepth ||
+		header.EmptyLimit != emptyLimit ||
+		header.NodeCount <= 0 ||
+		file.size() != sizeof(header) + (size_t)header.NodeCount * sizeof(OccupancyHistogramTreeFileNode)) return false;
+
+	//the records are read from the mapped view, the nodes of tree are allocated again
+	auto nodes = (const OccupancyHistogramTreeFileNode*)(file.data() + sizeof(header));
+	int cursor = 0;
+
+	release(&mRoot);
+
+	mNodeCount = 0;
+
+	if (load(&mRoot, nodes, header.NodeCount, cursor) == false || cursor != header.NodeCount) {
+		release(&mRoot);
+
+		mNodeCount = 0;
+
+		mRoot.Type = OccupancyType::Unknown;
+
+		memset(mRoot.OccupancyTypeCount, 0, sizeof(mRoot.OccupancyTypeCount));
+
+		return false;
+	}
+
+	return true;
+}
+
 void OccupancyHistogramTree::buildVirtualTree()
 {
 	mVirtualRoot.Target = &mRoot;
@@ -253,6 +470,11 @@ void OccupancyHistogramTree::buildVirtualTree()
 	buildVirtualTree(&mRoot, &mVirtualRoot);
 }
 
+auto OccupancyHistogramTree::root() const -> const OccupancyHistogramNode *
+{
+	return &mRoot;
+}
+
 void OccupancyHistogramTree::getOccupancyGeometry(std::vector<OccupancyHistogramNodeCompareComponent>& geometry, bool sort)
 {
 	geometry.push_back(OccupancyHistogramNodeCompareComponent(&mRoot, true, mVirtualRoot.FrontOrder));
@@ -3,6 +3,7 @@
 #include <memory>
 #include <vector>
 #include <iostream>
+#include <string>
 #include <glm\glm.hpp>
 
 /**
@@ -56,6 +57,22 @@ struct AxiallyAlignedBoundingBox {
 		Min(min), Max(max) {}
 };
 
+/**
+ * @brief dense occupancy type of leaves, index = z * Resolution * Resolution + y * Resolution + x
+ */
+struct OccupancyGrid {
+	int Resolution; //leaf count of each axis
+
+	std::vector<OccupancyType> Types; //leaf types
+
+	OccupancyGrid(int resolution = 0) :
+		Resolution(resolution), Types(size_t(resolution) * resolution * resolution, OccupancyType::Empty) {}
+
+	auto at(int x, int y, int z) const -> OccupancyType {
+		return Types[(size_t(z) * Resolution + y) * Resolution + x];
+	}
+};
+
 /**
  * @brief OccupancyHistogramTree Node
  */
@@ -131,6 +148,35 @@ struct OccupancyHistogramNodeCompareComponent {
 	}
 };
 
+//magic of the tree file, "OHTR"
+#define OCCUPANCY_HISTOGRAM_TREE_FILE_MAGIC 0x5254484F
+
+//version of the tree file, change it if the layout is changed
+#define OCCUPANCY_HISTOGRAM_TREE_FILE_VERSION 2
+
+/**
+ * @brief header of the tree file, the nodes follow it in preorder
+ */
+struct OccupancyHistogramTreeFileHeader {
+	unsigned int Magic;
+	unsigned int Version;
+	unsigned long long VolumeKey; //key of the volume file that the tree is built from, see MappedFile::key
+	int MaxDepth;
+	float EmptyLimit;
+	int NodeCount; //node count with root
+	int Reserved;
+};
+
+/**
+ * @brief node of the tree file
+ */
+struct OccupancyHistogramTreeFileNode {
+	unsigned char ChildMask; //bit i is set if Children[i] is existed
+	unsigned char Type;
+	unsigned short Reserved;
+	int OccupancyTypeCount[(int)OccupancyType::Count];
+};
+
 /**
  * @brief Occupancy Histogram Tree
  */
@@ -162,6 +208,31 @@ private:
 	 */
 	void insert(OccupancyHistogramNode* node, const glm::vec3 &position, OccupancyType type , int depth);
 
+	/**
+	 * @brief build the sub tree of node from the leaf grid(bottom-up), return the count of new nodes
+	 */
+	auto build(OccupancyHistogramNode* node, const OccupancyGrid &grid, int x, int y, int z, int depth) -> int;
+
+	/**
+	 * @brief update node from its children and free them if all leaves are same, return the count of freed nodes
+	 */
+	auto collapse(OccupancyHistogramNode* node, int depth) -> int;
+
+	/**
+	 * @brief free the sub tree of node, node will be a leaf
+	 */
+	void release(OccupancyHistogramNode* node);
+
+	/**
+	 * @brief write the sub tree of node in preorder, return the count of written nodes
+	 */
+	auto save(const OccupancyHistogramNode* node, std::ostream &stream) const -> int;
+
+	/**
+	 * @brief read the sub tree of node from nodes[cursor], return false if the nodes are broken
+	 */
+	auto load(OccupancyHistogramNode* node, const OccupancyHistogramTreeFileNode* nodes, int nodeCount, int &cursor) -> bool;
+
 	/**
 	 * @brief insert a new virtual node
 	 */
@@ -202,11 +273,33 @@ public:
 	 */
 	void insertNoEmpty(const glm::vec3 &position, OccupancyType type);
 
+	/**
+	 * @brief build tree from the dense leaf grid, the resolution of grid must be 2^(max depth - 1)
+	 */
+	void build(const OccupancyGrid &grid);
+
+	/**
+	 * @brief save tree to file, the volume key, max depth and empty limit are the key of file
+	 */
+	auto save(const std::string &fileName, unsigned long long volumeKey, float emptyLimit) const -> bool;
+
+	/**
+	 * @brief load tree from file, return false if the file is not existed or the key is not same
+	 * the nodes of tree have the pointers and bounding boxes, so the tree can not use the mapped file directly
+	 * the nodes are allocated again from the records in file, the mapping only avoids reading the file to a buffer
+	 */
+	auto load(const std::string &fileName, unsigned long long volumeKey, float emptyLimit) -> bool;
+
 	/**
 	 * @brief build virtual tree
 	 */
 	void buildVirtualTree();
 
+	/**
+	 * @brief get the root of tree
+	 */
+	auto root() const -> const OccupancyHistogramNode*;
+
 	/**
 	 * @brief get occupancy geometry, some aabb with right order
 	 */
@@ -0,0 +1,195 @@
+#include "RayPacketTraversal.hpp"
+
+#include "Helper.hpp"
+
+#include <algorithm>
+
+#undef max
+#undef min
+
+template<int N>
+RayPacket<N>::RayPacket()
+{
+	for (int lane = 0; lane < N; lane++) {
+		OriginX[lane] = OriginY[lane] = OriginZ[lane] = 0.0f;
+		InverseDirectionX[lane] = InverseDirectionY[lane] = InverseDirectionZ[lane] = 0.0f;
+		Active[lane] = false;
+	}
+}
+
+template<int N>
+void RayPacket<N>::set(int lane, const glm::vec3 & origin, const glm::vec3 & direction)
+{
+	OriginX[lane] = origin.x;
+	OriginY[lane] = origin.y;
+	OriginZ[lane] = origin.z;
+
+	InverseDirectionX[lane] = 1.0f / direction.x;
+	InverseDirectionY[lane] = 1.0f / direction.y;
+	InverseDirectionZ[lane] = 1.0f / direction.z;
+
+	Active[lane] = true;
+}
+
+template<int N>
+auto RayPacket<N>::signMask(int lane) const -> int
+{
+	return (InverseDirectionX[lane] < 0.0f ? 1 : 0) | (InverseDirectionY[lane] < 0.0f ? 2 : 0) | (InverseDirectionZ[lane] < 0.0f ? 4 : 0);
+}
+
+template<int N>
+bool RayPacketTraversal<N>::intersect(const AxiallyAlignedBoundingBox & box, const RayPacket<N>& packet, const bool active[N],
+	float nearDistance[N], float farDistance[N], bool hit[N])
+{
+	int hitCount = 0;
+
+	//no branch in the loop, so it is vectorized
+	for (int lane = 0; lane < N; lane++) {
+		const float x0 = (box.Min.x - packet.OriginX[lane]) * packet.InverseDirectionX[lane];
+		const float x1 = (box.Max.x - packet.OriginX[lane]) * packet.InverseDirectionX[lane];
+		const float y0 = (box.Min.y - packet.OriginY[lane]) * packet.InverseDirectionY[lane];
+		const float y1 = (box.Max.y - packet.OriginY[lane]) * packet.InverseDirectionY[lane];
+		const float z0 = (box.Min.z - packet.OriginZ[lane]) * packet.InverseDirectionZ[lane];
+		const float z1 = (box.Max.z - packet.OriginZ[lane]) * packet.InverseDirectionZ[lane];
+
+		//the part behind origin is not used
+		const float nearValue = std::max(std::max(std::min(x0, x1), std::min(y0, y1)), std::max(std::min(z0, z1), 0.0f));
+		const float farValue = std::min(std::min(std::max(x0, x1), std::max(y0, y1)), std::max(z0, z1));
+
+		nearDistance[lane] = nearValue;
+		farDistance[lane] = farValue;
+		hit[lane] = active[lane] & (nearValue < farValue);
+
+		hitCount += hit[lane];
+	}
+
+	return hitCount != 0;
+}
+
+template<int N>
+void RayPacketTraversal<N>::emit(OccupancyType type, const float nearDistance[N], const float farDistance[N], const bool hit[N],
+	std::vector<OccupancyInterval> intervals[N])
+{
+	for (int lane = 0; lane < N; lane++) {
+		if (hit[lane] == false) continue;
+
+		auto &laneIntervals = intervals[lane];
+
+		//merge with the interval before if they are next to each other
+		if (laneIntervals.empty() == false && laneIntervals.back().Type == type &&
+			laneIntervals.back().Near <= nearDistance[lane] && laneIntervals.back().Far >= nearDistance[lane]) {
+			laneIntervals.back().Far = std::max(laneIntervals.back().Far, farDistance[lane]);
+
+			continue;
+		}
+
+		laneIntervals.push_back(OccupancyInterval(nearDistance[lane], farDistance[lane], type));
+	}
+}
+
+template<int N>
+void RayPacketTraversal<N>::traverse(const OccupancyHistogramNode * node, const RayPacket<N>& packet, const bool active[N], int signMask,
+	std::vector<OccupancyInterval> intervals[N]) const
+{
+	float nearDistance[N];
+	float farDistance[N];
+	bool hit[N];
+
+	if (intersect(node->AxiallyAlignedBoundingBox, packet, active, nearDistance, farDistance, hit) == false) return;
+
+	bool isLeaf = true;
+
+	for (int i = 0; i < (int)SpaceOrder::Count; i++)
+		if (node->Children[i] != nullptr) isLeaf = false;
+
+	//all leaves in node are same type
+	if (isLeaf == true) {
+		emit(node->Type, nearDistance, farDistance, hit, intervals);
+
+		return;
+	}
+
+	//visit children front-to-back, the first child is the one on the negative side of direction
+	for (int i = 0; i < (int)SpaceOrder::Count; i++) {
+		const int order = i ^ signMask;
+
+		if (node->Children[order] != nullptr) {
+			traverse(node->Children[order], packet, hit, signMask, intervals);
+
+			continue;
+		}
+
+		//the child is not existed, so the space is the type of node
+		float childNearDistance[N];
+		float childFarDistance[N];
+		bool childHit[N];
+
+		const auto childBox = Helper::divideAxiallyAlignedBoundingBox(node->AxiallyAlignedBoundingBox, (SpaceOrder)order);
+
+		if (intersect(childBox, packet, hit, childNearDistance, childFarDistance, childHit) == true)
+			emit(node->Type, childNearDistance, childFarDistance, childHit, intervals);
+	}
+}
+
+template<int N>
+RayPacketTraversal<N>::RayPacketTraversal(const OccupancyHistogramTree & tree) :
+	mRoot(tree.root())
+{
+}
+
+template<int N>
+void RayPacketTraversal<N>::trace(const RayPacket<N>& packet, std::vector<OccupancyInterval> intervals[N]) const
+{
+	int signMask = -1;
+	bool sameSign = true;
+
+	for (int lane = 0; lane < N; lane++) {
+		intervals[lane].clear();
+
+		if (packet.Active[lane] == false) continue;
+
+		if (signMask == -1) signMask = packet.signMask(lane);
+		if (signMask != packet.signMask(lane)) sameSign = false;
+	}
+
+	if (signMask == -1) return;
+
+	traverse(mRoot, packet, packet.Active, signMask, intervals);
+
+	if (sameSign == true) return;
+
+	//the order is only front-to-back for the lanes with the same sign as first lane
+	for (int lane = 0; lane < N; lane++) {
+		if (packet.Active[lane] == false || packet.signMask(lane) == signMask) continue;
+
+		auto &laneIntervals = intervals[lane];
+
+		std::sort(laneIntervals.begin(), laneIntervals.end(), [](const OccupancyInterval &first, const OccupancyInterval &second) {
+			return first.Near < second.Near;
+		});
+
+		//merge again after sort
+		size_t count = 0;
+
+		for (size_t i = 0; i < laneIntervals.size(); i++) {
+			if (count != 0 && laneIntervals[count - 1].Type == laneIntervals[i].Type &&
+				laneIntervals[count - 1].Far >= laneIntervals[i].Near) {
+				laneIntervals[count - 1].Far = std::max(laneIntervals[count - 1].Far, laneIntervals[i].Far);
+
+				continue;
+			}
+
+			laneIntervals[count++] = laneIntervals[i];
+		}
+
+		laneIntervals.resize(count);
+	}
+}
+
+template struct RayPacket<4>;
+template struct RayPacket<8>;
+template struct RayPacket<16>;
+
+template class RayPacketTraversal<4>;
+template class RayPacketTraversal<8>;
+template class RayPacketTraversal<16>;
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <glm\glm.hpp>
+
+#include "OccupancyHistogramTree.hpp"
+
+/**
+ * @brief a packet of N rays in SoA layout, so the slab tests of all rays can be vectorized
+ */
+template<int N>
+struct RayPacket {
+	float OriginX[N], OriginY[N], OriginZ[N];
+	float InverseDirectionX[N], InverseDirectionY[N], InverseDirectionZ[N];
+
+	bool Active[N]; //inactive lane is ignored, e.g. the pixel is out of screen
+
+	RayPacket();
+
+	/**
+	 * @brief set the ray of lane, direction should be normalized so t is the distance from origin
+	 */
+	void set(int lane, const glm::vec3 &origin, const glm::vec3 &direction);
+
+	/**
+	 * @brief the sign mask of lane direction, bit 0(1, 2) is set if x(y, z) is negative
+	 */
+	auto signMask(int lane) const -> int;
+};
+
+/**
+ * @brief part of ray that is in a occupancy type
+ */
+struct OccupancyInterval {
+	float Near; //distance from origin
+	float Far;
+	OccupancyType Type;
+
+	OccupancyInterval(float nearDistance = 0, float farDistance = 0, OccupancyType type = OccupancyType::Empty) :
+		Near(nearDistance), Far(farDistance), Type(type) {}
+};
+
+/**
+ * @brief trace ray packets through the occupancy histogram tree
+ * the children are visited front-to-back, and each uniform node gives one interval to the rays that hit it
+ */
+template<int N>
+class RayPacketTraversal {
+private:
+	const OccupancyHistogramNode* mRoot;
+
+	/**
+	 * @brief slab test of all lanes with box, return true if any lane hits it
+	 */
+	static bool intersect(const AxiallyAlignedBoundingBox &box, const RayPacket<N> &packet, const bool active[N],
+		float nearDistance[N], float farDistance[N], bool hit[N]);
+
+	/**
+	 * @brief add interval of type to the lanes that hit
+	 */
+	static void emit(OccupancyType type, const float nearDistance[N], const float farDistance[N], const bool hit[N],
+		std::vector<OccupancyInterval> intervals[N]);
+
+	void traverse(const OccupancyHistogramNode* node, const RayPacket<N> &packet, const bool active[N], int signMask,
+		std::vector<OccupancyInterval> intervals[N]) const;
+public:
+	RayPacketTraversal(const OccupancyHistogramTree &tree);
+
+	/**
+	 * @brief get the intervals of each ray, intervals of same type next to each other are merged
+	 * the intervals are sorted by distance
+	 */
+	void trace(const RayPacket<N> &packet, std::vector<OccupancyInterval> intervals[N]) const;
+};
@@ -0,0 +1,321 @@
+#include "RaySegmentListGenerator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+#undef max
+#undef min
+
+RaySegmentListGenerator::RaySegmentListGenerator(int width, int height, int maxRaySegmentCount) :
+	mWidth(width), mHeight(height), mMaxRaySegmentCount(maxRaySegmentCount)
+{
+	mCount.resize((size_t)width * height, 0);
+	mDepth.resize((size_t)width * height * maxRaySegmentCount, 0);
+	mBoxType.resize((size_t)width * height * maxRaySegmentCount, 0);
+	mEventType.resize((size_t)width * height * maxRaySegmentCount, 0);
+
+	const int tileCountX = (width + RAY_SEGMENT_LIST_TILE_SIZE - 1) / RAY_SEGMENT_LIST_TILE_SIZE;
+	const int tileCountY = (height + RAY_SEGMENT_LIST_TILE_SIZE - 1) / RAY_SEGMENT_LIST_TILE_SIZE;
+
+	mTileGeometry.resize((size_t)tileCountX * tileCountY);
+}
+
+void RaySegmentListGenerator::addRaySegment(RaySegment * list, unsigned int & count, float depth, unsigned char boxType, RaySegmentEventType eventType)
+{
+	const unsigned int raySegmentListCount = count;
+
+	//set the event
+	list[raySegmentListCount] = { depth, boxType, (unsigned char)eventType };
+	count = raySegmentListCount + 1;
+
+	//do not need merge or delete
+	if (raySegmentListCount == 0) return;
+
+	const RaySegment &before = list[raySegmentListCount - 1];
+
+	//the depth is not same
+	if (std::abs(before.Depth - depth) > RAY_SEGMENT_LIST_EPS) return;
+
+	//case 1, the same event type, delete the first
+	if (before.EventType == (unsigned char)eventType) {
+		list[raySegmentListCount - 1] = list[raySegmentListCount];
+		count = raySegmentListCount;
+
+		return;
+	}
+
+	//case 2, first is exit and second is entry
+	if (before.EventType == (unsigned char)RaySegmentEventType::Exit && eventType == RaySegmentEventType::Entry) {
+		//before the first
+		if (raySegmentListCount == 1) return;
+
+		//same, delete all
+		if (boxType == list[raySegmentListCount - 2].BoxType) count = raySegmentListCount - 1;
+
+		return;
+	}
+
+	//case 3, first is entry and second is exit
+	if (before.EventType == (unsigned char)RaySegmentEventType::Entry && eventType == RaySegmentEventType::Exit)
+		count = raySegmentListCount - 1;
+}
+
+void RaySegmentListGenerator::addOccupancyIntervals(RaySegment * list, unsigned int & count, int maxCount, const std::vector<OccupancyInterval>& intervals)
+{
+	OccupancyType currentType = OccupancyType::Empty;
+	float currentFar = 0.0f;
+
+	//the same limit as the shader, the first events are kept and the events after the list is full are dropped
+	auto add = [&](float depth, OccupancyType type, RaySegmentEventType eventType) {
+		if (count + 1 >= (unsigned int)maxCount) return false;
+
+		list[count++] = { depth, (unsigned char)type, (unsigned char)eventType };
+
+		return true;
+	};
+
+	for (auto &interval : intervals) {
+		//there is a gap between intervals, so the ray is out of tree
+		if (interval.Near > currentFar + RAY_SEGMENT_LIST_EPS && currentType != OccupancyType::Empty) {
+			if (add(currentFar, OccupancyType::Empty, RaySegmentEventType::Exit) == false) return;
+
+			currentType = OccupancyType::Empty;
+		}
+
+		//only the change of type is needed, so the empty space is skipped
+		if (interval.Type != currentType && add(interval.Near, interval.Type, RaySegmentEventType::Entry) == false) return;
+
+		currentType = interval.Type;
+		currentFar = interval.Far;
+	}
+
+	if (currentType != OccupancyType::Empty) add(currentFar, OccupancyType::Empty, RaySegmentEventType::Exit);
+}
+
+void RaySegmentListGenerator::forEachTile(const std::function<void(int)>& work, int threadCount)
+{
+	if (threadCount <= 0) threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+
+	//tiles are taken one by one, so the threads are balanced if some tiles are heavy
+	std::atomic<int> nextTile(0);
+	std::vector<std::thread> threads;
+
+	auto run = [&]() {
+		for (int tile = nextTile++; tile < (int)mTileGeometry.size(); tile = nextTile++) work(tile);
+	};
+
+	for (int i = 1; i < threadCount; i++) threads.push_back(std::thread(run));
+
+	run();
+
+	for (auto &thread : threads) thread.join();
+}
+
+auto RaySegmentListGenerator::rayDirection(int x, int y, const glm::mat4 & inverseViewProjection, const glm::vec3 & eyePosition) const -> glm::vec3
+{
+	//the ray from eye through the pixel center
+	glm::vec4 farPosition = inverseViewProjection * glm::vec4(
+		((x + 0.5f) / mWidth) * 2.0f - 1.0f,
+		1.0f - ((y + 0.5f) / mHeight) * 2.0f, 1.0f, 1.0f);
+
+	return glm::normalize(glm::vec3(farPosition.x, farPosition.y, farPosition.z) / farPosition.w - eyePosition);
+}
+
+void RaySegmentListGenerator::storeRaySegmentList(int x, int y, const RaySegment * list, unsigned int count)
+{
+	const size_t slicePitch = (size_t)mWidth * mHeight;
+	const size_t pixel = (size_t)y * mWidth + x;
+
+	mCount[pixel] = count;
+
+	for (unsigned int i = 0; i < count; i++) {
+		mDepth[i * slicePitch + pixel] = list[i].Depth;
+		mBoxType[i * slicePitch + pixel] = list[i].BoxType;
+		mEventType[i * slicePitch + pixel] = list[i].EventType;
+	}
+}
+
+void RaySegmentListGenerator::binGeometry(const std::vector<OccupancyHistogramNodeCompareComponent>& geometry, const glm::mat4 & viewProjection)
+{
+	const int tileCountX = (mWidth + RAY_SEGMENT_LIST_TILE_SIZE - 1) / RAY_SEGMENT_LIST_TILE_SIZE;
+	const int tileCountY = (mHeight + RAY_SEGMENT_LIST_TILE_SIZE - 1) / RAY_SEGMENT_LIST_TILE_SIZE;
+
+	for (auto &tile : mTileGeometry) tile.clear();
+
+	for (int i = 0; i < (int)geometry.size(); i++) {
+		const auto &box = geometry[i].Node->AxiallyAlignedBoundingBox;
+
+		float minX = (float)mWidth, minY = (float)mHeight;
+		float maxX = 0.0f, maxY = 0.0f;
+
+		bool behindEye = false;
+
+		//project the corners to find the screen rectangle of box
+		for (int corner = 0; corner < 8; corner++) {
+			const glm::vec4 position = viewProjection * glm::vec4(
+				(corner & 1) ? box.Max.x : box.Min.x,
+				(corner & 2) ? box.Max.y : box.Min.y,
+				(corner & 4) ? box.Max.z : box.Min.z, 1.0f);
+
+			if (position.w <= 0.0f) { behindEye = true; break; }
+
+			const float x = (position.x / position.w * 0.5f + 0.5f) * mWidth;
+			const float y = (0.5f - position.y / position.w * 0.5f) * mHeight;
+
+			minX = std::min(minX, x); maxX = std::max(maxX, x);
+			minY = std::min(minY, y); maxY = std::max(maxY, y);
+		}
+
+		//the box crosses the eye plane, we can not bound it on screen
+		if (behindEye == true) {
+			minX = 0.0f; minY = 0.0f;
+			maxX = (float)mWidth; maxY = (float)mHeight;
+		}
+
+		if (minX > maxX || minY > maxY) continue;
+
+		const int fromX = std::max(0, (int)std::floor(minX) / RAY_SEGMENT_LIST_TILE_SIZE);
+		const int fromY = std::max(0, (int)std::floor(minY) / RAY_SEGMENT_LIST_TILE_SIZE);
+		const int toX = std::min(tileCountX - 1, (int)std::floor(maxX) / RAY_SEGMENT_LIST_TILE_SIZE);
+		const int toY = std::min(tileCountY - 1, (int)std::floor(maxY) / RAY_SEGMENT_LIST_TILE_SIZE);
+
+		for (int y = fromY; y <= toY; y++)
+			for (int x = fromX; x <= toX; x++) mTileGeometry[y * tileCountX + x].push_back(i);
+	}
+}
+
+void RaySegmentListGenerator::generateTile(int tile, const std::vector<OccupancyHistogramNodeCompareComponent>& geometry,
+	const glm::mat4 & inverseViewProjection, const glm::vec3 & eyePosition)
+{
+	const int tileCountX = (mWidth + RAY_SEGMENT_LIST_TILE_SIZE - 1) / RAY_SEGMENT_LIST_TILE_SIZE;
+
+	const int fromX = (tile % tileCountX) * RAY_SEGMENT_LIST_TILE_SIZE;
+	const int fromY = (tile / tileCountX) * RAY_SEGMENT_LIST_TILE_SIZE;
+	const int toX = std::min(mWidth, fromX + RAY_SEGMENT_LIST_TILE_SIZE);
+	const int toY = std::min(mHeight, fromY + RAY_SEGMENT_LIST_TILE_SIZE);
+
+	const auto &tileGeometry = mTileGeometry[tile];
+
+	std::vector<RaySegment> list(mMaxRaySegmentCount);
+
+	for (int y = fromY; y < toY; y++) {
+		for (int x = fromX; x < toX; x++) {
+			const glm::vec3 direction = rayDirection(x, y, inverseViewProjection, eyePosition);
+			const glm::vec3 inverseDirection = glm::vec3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+			unsigned int count = 0;
+
+			for (auto index : tileGeometry) {
+				//the list is full, the shader stops adding in this case
+				if (count + 1 >= (unsigned int)mMaxRaySegmentCount) break;
+
+				const auto &component = geometry[index];
+				const auto &box = component.Node->AxiallyAlignedBoundingBox;
+
+				//slab test, the direction is normalized so t is the distance from eye
+				const glm::vec3 t0 = (box.Min - eyePosition) * inverseDirection;
+				const glm::vec3 t1 = (box.Max - eyePosition) * inverseDirection;
+
+				const float tNear = std::max(std::max(std::min(t0.x, t1.x), std::min(t0.y, t1.y)), std::min(t0.z, t1.z));
+				const float tFar = std::min(std::min(std::max(t0.x, t1.x), std::max(t0.y, t1.y)), std::max(t0.z, t1.z));
+
+				if (tNear > tFar) continue;
+
+				//front face is visible if the box is in front of eye
+				if (component.IsFrontFace == true && tNear > 0.0f)
+					addRaySegment(&list[0], count, tNear, (unsigned char)component.Node->Type, RaySegmentEventType::Entry);
+
+				//back face is visible if the box is not behind eye
+				if (component.IsFrontFace == false && tFar > 0.0f)
+					addRaySegment(&list[0], count, tFar, (unsigned char)(component.Node->Parent != nullptr ?
+						component.Node->Parent->Type : OccupancyType::Empty), RaySegmentEventType::Exit);
+			}
+
+			storeRaySegmentList(x, y, &list[0], count);
+		}
+	}
+}
+
+void RaySegmentListGenerator::generateTile(int tile, const RayPacketTraversal<RAY_PACKET_SIZE>& traversal,
+	const glm::mat4 & inverseViewProjection, const glm::vec3 & eyePosition)
+{
+	const int tileCountX = (mWidth + RAY_SEGMENT_LIST_TILE_SIZE - 1) / RAY_SEGMENT_LIST_TILE_SIZE;
+	const int packetHeight = RAY_PACKET_SIZE / RAY_PACKET_WIDTH;
+
+	const int fromX = (tile % tileCountX) * RAY_SEGMENT_LIST_TILE_SIZE;
+	const int fromY = (tile / tileCountX) * RAY_SEGMENT_LIST_TILE_SIZE;
+	const int toX = std::min(mWidth, fromX + RAY_SEGMENT_LIST_TILE_SIZE);
+	const int toY = std::min(mHeight, fromY + RAY_SEGMENT_LIST_TILE_SIZE);
+
+	std::vector<OccupancyInterval> intervals[RAY_PACKET_SIZE];
+	std::vector<RaySegment> list(mMaxRaySegmentCount);
+
+	//the rays of near pixels go through the same nodes, so trace them as a packet
+	for (int packetY = fromY; packetY < toY; packetY += packetHeight) {
+		for (int packetX = fromX; packetX < toX; packetX += RAY_PACKET_WIDTH) {
+			RayPacket<RAY_PACKET_SIZE> packet;
+
+			for (int lane = 0; lane < RAY_PACKET_SIZE; lane++) {
+				const int x = packetX + lane % RAY_PACKET_WIDTH;
+				const int y = packetY + lane / RAY_PACKET_WIDTH;
+
+				if (x < toX && y < toY) packet.set(lane, eyePosition, rayDirection(x, y, inverseViewProjection, eyePosition));
+			}
+
+			traversal.trace(packet, intervals);
+
+			for (int lane = 0; lane < RAY_PACKET_SIZE; lane++) {
+				if (packet.Active[lane] == false) continue;
+
+				unsigned int count = 0;
+
+				addOccupancyIntervals(&list[0], count, mMaxRaySegmentCount, intervals[lane]);
+
+				storeRaySegmentList(packetX + lane % RAY_PACKET_WIDTH, packetY + lane / RAY_PACKET_WIDTH, &list[0], count);
+			}
+		}
+	}
+}
+
+void RaySegmentListGenerator::generate(const std::vector<OccupancyHistogramNodeCompareComponent>& geometry,
+	const glm::mat4 & view, const glm::mat4 & projection, const glm::vec3 & eyePosition, int threadCount)
+{
+	const glm::mat4 viewProjection = projection * view;
+	const glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+
+	binGeometry(geometry, viewProjection);
+
+	forEachTile([&](int tile) { generateTile(tile, geometry, inverseViewProjection, eyePosition); }, threadCount);
+}
+
+void RaySegmentListGenerator::generate(const OccupancyHistogramTree & tree,
+	const glm::mat4 & view, const glm::mat4 & projection, const glm::vec3 & eyePosition, int threadCount)
+{
+	const glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+
+	RayPacketTraversal<RAY_PACKET_SIZE> traversal(tree);
+
+	forEachTile([&](int tile) { generateTile(tile, traversal, inverseViewProjection, eyePosition); }, threadCount);
+}
+
+auto RaySegmentListGenerator::count() const -> const std::vector<unsigned int>&
+{
+	return mCount;
+}
+
+auto RaySegmentListGenerator::depth() const -> const std::vector<float>&
+{
+	return mDepth;
+}
+
+auto RaySegmentListGenerator::boxType() const -> const std::vector<unsigned char>&
+{
+	return mBoxType;
+}
+
+auto RaySegmentListGenerator::eventType() const -> const std::vector<unsigned char>&
+{
+	return mEventType;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <glm\glm.hpp>
+
+#include "OccupancyHistogramTree.hpp"
+#include "RayPacketTraversal.hpp"
+
+//tile size(pixel) that we bin the occupancy geometry
+#define RAY_SEGMENT_LIST_TILE_SIZE 16
+
+//ray count of packet when we trace the tree, 4, 8 or 16
+#define RAY_PACKET_SIZE 8
+
+//pixel count of packet in x axis, the packet covers RAY_PACKET_WIDTH * (RAY_PACKET_SIZE / RAY_PACKET_WIDTH) pixels
+#define RAY_PACKET_WIDTH 4
+
+//the depth of two events are same if the difference is not greater than it
+#define RAY_SEGMENT_LIST_EPS 0.0000001
+
+/**
+ * @brief ray segment event type, same as the shader
+ */
+enum class RaySegmentEventType : unsigned char {
+	Entry = 0,
+	Exit = 1
+};
+
+/**
+ * @brief one event in ray segment list
+ */
+struct RaySegment {
+	float Depth; //distance from eye
+	unsigned char BoxType; //occupancy type after the event
+	unsigned char EventType; //entry or exit
+};
+
+/**
+ * @brief generate the ray segment list of each pixel on CPU, same as OccupancyGeometryPixelShader
+ * the ray of each pixel is traced against the occupancy geometry that covers its tile
+ * the result is stored as the layout of ray segment list textures
+ */
+class RaySegmentListGenerator {
+private:
+	int mWidth;
+	int mHeight;
+	int mMaxRaySegmentCount;
+
+	std::vector<unsigned int> mCount; //count of pixel(x, y) is at y * width + x
+	std::vector<float> mDepth; //event i of pixel(x, y) is at (i * height + y) * width + x
+	std::vector<unsigned char> mBoxType;
+	std::vector<unsigned char> mEventType;
+
+	std::vector<std::vector<int>> mTileGeometry; //index of geometry that covers the tile, keep the draw order
+
+	/**
+	 * @brief add event to the list with the merge and delete rules of shader
+	 */
+	static void addRaySegment(RaySegment* list, unsigned int &count, float depth, unsigned char boxType, RaySegmentEventType eventType);
+
+	/**
+	 * @brief add the type changes of intervals to the list, the last event is leaving the tree
+	 * if the list is full, the later events are dropped as the shader does, so the ray casting stops at the last event
+	 */
+	static void addOccupancyIntervals(RaySegment* list, unsigned int &count, int maxCount, const std::vector<OccupancyInterval> &intervals);
+
+	/**
+	 * @brief run work for each tile with threads
+	 */
+	void forEachTile(const std::function<void(int)> &work, int threadCount);
+
+	/**
+	 * @brief the direction of ray from eye through the pixel center
+	 */
+	auto rayDirection(int x, int y, const glm::mat4 &inverseViewProjection, const glm::vec3 &eyePosition) const -> glm::vec3;
+
+	/**
+	 * @brief store the list of pixel
+	 */
+	void storeRaySegmentList(int x, int y, const RaySegment* list, unsigned int count);
+
+	/**
+	 * @brief find the tiles that each geometry covers
+	 */
+	void binGeometry(const std::vector<OccupancyHistogramNodeCompareComponent> &geometry, const glm::mat4 &viewProjection);
+
+	/**
+	 * @brief generate the ray segment list of pixels in tile
+	 */
+	void generateTile(int tile, const std::vector<OccupancyHistogramNodeCompareComponent> &geometry,
+		const glm::mat4 &inverseViewProjection, const glm::vec3 &eyePosition);
+
+	/**
+	 * @brief generate the ray segment list of pixels in tile by tracing ray packets through tree
+	 */
+	void generateTile(int tile, const RayPacketTraversal<RAY_PACKET_SIZE> &traversal,
+		const glm::mat4 &inverseViewProjection, const glm::vec3 &eyePosition);
+public:
+	RaySegmentListGenerator(int width, int height, int maxRaySegmentCount);
+
+	/**
+	 * @brief generate ray segment list, geometry is sorted by getOccupancyGeometry
+	 * @param[in] threadCount the max number of threads, 0 means hardware concurrency
+	 */
+	void generate(const std::vector<OccupancyHistogramNodeCompareComponent> &geometry,
+		const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &eyePosition, int threadCount = 0);
+
+	/**
+	 * @brief generate ray segment list by tracing the tree directly, no occupancy geometry is needed
+	 * the list only has the events that the occupancy type is changed, it is enough for ray casting
+	 * @param[in] threadCount the max number of threads, 0 means hardware concurrency
+	 */
+	void generate(const OccupancyHistogramTree &tree,
+		const glm::mat4 &view, const glm::mat4 &projection, const glm::vec3 &eyePosition, int threadCount = 0);
+
+	auto count() const -> const std::vector<unsigned int>&;
+
+	auto depth() const -> const std::vector<float>&;
+
+	auto boxType() const -> const std::vector<unsigned char>&;
+
+	auto eventType() const -> const std::vector<unsigned char>&;
+};
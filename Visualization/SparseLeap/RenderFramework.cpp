@@ -2,16 +2,34 @@
 
 #include "Helper.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#undef max
+#undef min
+
 void RenderFramework::update(void * sender, float deltaTime)
 {
 	mOccupancyGeometry.clear();
 
+	//the traversal does not need the occupancy geometry
+	if (mTraceTree == true) {
+		traceRaySegmentList();
+
+		return;
+	}
+
 	//new occupancy geometry
 	mOccupancyHistogramTree->setEyePosition(mPosition);
 	mOccupancyHistogramTree->getOccupancyGeometry(mOccupancyGeometry);
 	
 	//new ray segment list
-	renderRaySegmentList();
+	//the draw loop is one draw per node, so we use CPU if there are too many nodes
+	if (mOccupancyGeometry.size() > MAX_GPU_OCCUPANCY_GEOMETRY)
+		generateRaySegmentList();
+	else
+		renderRaySegmentList();
 }
 
 void RenderFramework::render(void * sender, float deltaTime)
@@ -53,6 +71,12 @@ void RenderFramework::render(void * sender, float deltaTime)
 	mSwapChain->present(false);
 }
 
+void RenderFramework::keyUp(void * sender, KeyBoardEvent * eventArg)
+{
+	if (eventArg->getKeyCode() == KeyCode::T) mTraceTree = !mTraceTree;
+	if (eventArg->getKeyCode() == KeyCode::C) compareRaySegmentList();
+}
+
 void RenderFramework::renderInstance(int requireInstanceCount)
 {
 	//instance 
@@ -133,35 +157,99 @@ void RenderFramework::renderRaySegmentList()
 	if (mInstanceData.size() != (size_t)0) renderInstance((int)mInstanceData.size());
 }
 
-auto RenderFramework::sampleVolumeData(AxiallyAlignedBoundingBox sampleBox, int width, int height, int depth, std::vector<unsigned char>& volumeData) -> float
+void RenderFramework::generateRaySegmentList()
+{
+	mRaySegmentListGenerator->generate(mOccupancyGeometry, mMatrix[1], mMatrix[2], mPosition);
+
+	uploadRaySegmentList();
+}
+
+void RenderFramework::traceRaySegmentList()
 {
-	int startX, startY, startZ;
-	int endX, endY, endZ;
+	//trace the tree with ray packets, so the empty space is skipped without the occupancy geometry
+	mRaySegmentListGenerator->generate(*mOccupancyHistogramTree, mMatrix[1], mMatrix[2], mPosition);
 
-	//find the area where we want to sample
-	startX = (int)(sampleBox.Min.x * width);
-	startY = (int)(sampleBox.Min.y * height);
-	startZ = (int)(sampleBox.Min.z * depth);
+	uploadRaySegmentList();
+}
+
+void RenderFramework::uploadRaySegmentList()
+{
+	//the layout of generator is same as the textures
+	mRaySegmentListCountTexture->update((void*)mRaySegmentListGenerator->count().data());
+	mRaySegmentListDepthTexture->update((void*)mRaySegmentListGenerator->depth().data());
+	mRaySegmentListBoxTypeTexture->update((void*)mRaySegmentListGenerator->boxType().data());
+	mRaySegmentListEventTypeTexture->update((void*)mRaySegmentListGenerator->eventType().data());
+}
+
+void RenderFramework::compareRaySegmentList()
+{
+	mOccupancyGeometry.clear();
+
+	mOccupancyHistogramTree->setEyePosition(mPosition);
+	mOccupancyHistogramTree->getOccupancyGeometry(mOccupancyGeometry);
+
+	//the GPU result is read back by copying to the textures that CPU can read
+	renderRaySegmentList();
 
-	endX = (int)(sampleBox.Max.x * width);
-	endY = (int)(sampleBox.Max.y * height);
-	endZ = (int)(sampleBox.Max.z * depth);
+	mRaySegmentListCountReadTexture->copy(mRaySegmentListCountTexture);
+	mRaySegmentListDepthReadTexture->copy(mRaySegmentListDepthTexture);
+	mRaySegmentListBoxTypeReadTexture->copy(mRaySegmentListBoxTypeTexture);
+	mRaySegmentListEventTypeReadTexture->copy(mRaySegmentListEventTypeTexture);
 
-	float sum = 0;
-	int count = 0;
+	mRaySegmentListGenerator->generate(mOccupancyGeometry, mMatrix[1], mMatrix[2], mPosition);
 
-	for (int x = startX; x < endX; x++) {
-		for (int y = startY; y < endY; y++) {
-			for (int z = startZ; z < endZ; z++) {
-				int index = z * width * height + y * width + x;
+	const auto &count = mRaySegmentListGenerator->count();
+	const auto &depth = mRaySegmentListGenerator->depth();
+	const auto &boxType = mRaySegmentListGenerator->boxType();
+	const auto &eventType = mRaySegmentListGenerator->eventType();
 
-				sum = sum + volumeData[index] / 255.0f;
-				count = count + 1;
+	MappedData countData = mRaySegmentListCountReadTexture->map();
+	MappedData depthData = mRaySegmentListDepthReadTexture->map();
+	MappedData boxTypeData = mRaySegmentListBoxTypeReadTexture->map();
+	MappedData eventTypeData = mRaySegmentListEventTypeReadTexture->map();
+
+	const size_t slicePitch = (size_t)mWidth * mHeight;
+
+	int differentPixelCount = 0;
+	float maxDepthError = 0.0f;
+
+	for (int y = 0; y < mHeight; y++) {
+		for (int x = 0; x < mWidth; x++) {
+			const size_t pixel = (size_t)y * mWidth + x;
+
+			//the pitches of mapped data may be larger than the rows of texture
+			auto gpuCount = *((unsigned int*)((char*)countData.Data + y * countData.RowPitch) + x);
+			bool isSame = gpuCount == count[pixel];
+
+			for (unsigned int i = 0; i < gpuCount && isSame == true; i++) {
+				const size_t offset = (size_t)i * depthData.DepthPitch + (size_t)y * depthData.RowPitch;
+				const size_t typeOffset = (size_t)i * boxTypeData.DepthPitch + (size_t)y * boxTypeData.RowPitch;
+				const size_t eventOffset = (size_t)i * eventTypeData.DepthPitch + (size_t)y * eventTypeData.RowPitch;
+
+				auto gpuDepth = *((float*)((char*)depthData.Data + offset) + x);
+				auto gpuBoxType = *((unsigned char*)boxTypeData.Data + typeOffset + x);
+				auto gpuEventType = *((unsigned char*)eventTypeData.Data + eventOffset + x);
+
+				const float depthError = std::abs(gpuDepth - depth[i * slicePitch + pixel]);
+
+				maxDepthError = std::max(maxDepthError, depthError);
+
+				isSame = depthError <= RAY_SEGMENT_LIST_COMPARE_EPS &&
+					gpuBoxType == boxType[i * slicePitch + pixel] &&
+					gpuEventType == eventType[i * slicePitch + pixel];
 			}
+
+			if (isSame == false) differentPixelCount++;
 		}
 	}
 
-	return sum / count;
+	mRaySegmentListCountReadTexture->unmap();
+	mRaySegmentListDepthReadTexture->unmap();
+	mRaySegmentListBoxTypeReadTexture->unmap();
+	mRaySegmentListEventTypeReadTexture->unmap();
+
+	printf("Ray Segment List Compare : %d of %d pixels are different, max depth error %f with %d occupancy geometry\n",
+		differentPixelCount, mWidth * mHeight, maxDepthError, (int)mOccupancyGeometry.size());
 }
 
 void RenderFramework::buildState()
@@ -227,19 +315,23 @@ void RenderFramework::buildTexture()
 	mRaySegmentListDepthSRVUsage = mFactory->createResourceUsage(mRaySegmentListDepthTexture, PixelFormat::R32Float);
 	mRaySegmentListBoxTypeSRVUsage = mFactory->createResourceUsage(mRaySegmentListBoxTypeTexture, PixelFormat::R8Uint);
 	mRaySegmentListEventTypeSRVUsage = mFactory->createResourceUsage(mRaySegmentListEventTypeTexture, PixelFormat::R8Uint);
+
+	const auto readInfo = ResourceInfo(BindUsage::None, CpuAccessFlag::Read, HeapType::Staging);
+
+	mRaySegmentListCountReadTexture = mFactory->createTexture2D(mWidth, mHeight, PixelFormat::R32Uint, readInfo);
+	mRaySegmentListDepthReadTexture = mFactory->createTexture3D(mWidth, mHeight, MAX_RAYSEGMENT, PixelFormat::R32Float, readInfo);
+	mRaySegmentListBoxTypeReadTexture = mFactory->createTexture3D(mWidth, mHeight, MAX_RAYSEGMENT, PixelFormat::R8Uint, readInfo);
+	mRaySegmentListEventTypeReadTexture = mFactory->createTexture3D(mWidth, mHeight, MAX_RAYSEGMENT, PixelFormat::R8Uint, readInfo);
+
+	mRaySegmentListGenerator = new RaySegmentListGenerator(mWidth, mHeight, MAX_RAYSEGMENT);
 }
 
 void RenderFramework::buildVolumeData()
 {
-	std::ifstream file("Teddybear.raw", std::ios::ate | std::ios::binary);
-
-	size_t fileSize = (size_t)file.tellg();
+	//the volume file is mapped, so the key of cache is computed without reading the file again
+	const MappedFile volumeFile(VOLUME_FILE);
 
-	mVolumeData.resize(fileSize);
-
-	file.seekg(0, std::ios::beg);
-	file.read((char*)&mVolumeData[0], fileSize);
-	file.close();
+	mVolumeData.assign(volumeFile.data(), volumeFile.data() + volumeFile.size());
 
 	mOccupancyHistogramTree = new OccupancyHistogramTree();
 
@@ -250,32 +342,18 @@ void RenderFramework::buildVolumeData()
 	int height = 128;
 	int depth = 62;
 
-	int size = (int)std::pow(2, MAX_DEPTH - 1);
-
-	for (int x = 0; x < size; x++) {
-		for (int y = 0; y < size; y++) {
-			for (int z = 0; z < size; z++) {
-				glm::vec3 position;
-
-				position.x = ((float)x + 0.5f) / size;
-				position.y = ((float)y + 0.5f) / size;
-				position.z = ((float)z + 0.5f) / size;
+	//the tree file is keyed by volume file(size, write time and sampled blocks, see MappedFile::key), max depth and empty limit
+	//so it is rebuilt only if one of them is changed
+	auto volumeKey = volumeFile.key();
 
-				position = position * CUBE_SIZE - CUBE_SIZE * 0.5f;
+	if (mOccupancyHistogramTree->load(TREE_FILE, volumeKey, (float)EMPTY_LIMIT) == false) {
+		int size = 1 << (MAX_DEPTH - 1);
 
-				AxiallyAlignedBoundingBox sampleBox;
+		//classify each leaf with one pass over the volume, then build the tree from bottom to top
+		auto classification = VolumeClassifier::classify(&mVolumeData[0], width, height, depth, size, size, size);
 
-				sampleBox.Min = glm::vec3((float)x / size, (float)y / size, (float)z / size);
-				sampleBox.Max = glm::vec3((float)(x + 1) / size, (float)(y + 1) / size, (float)(z + 1) / size);
-
-				float sampleValue = sampleVolumeData(sampleBox, width, height, depth, mVolumeData);
-
-				if (sampleValue <= EMPTY_LIMIT)
-					mOccupancyHistogramTree->insertNoEmpty(position, OccupancyType::Empty);
-				else
-					mOccupancyHistogramTree->insertNoEmpty(position, OccupancyType::NoEmpty);
-			}
-		}
+		mOccupancyHistogramTree->build(VolumeClassifier::toOccupancyGrid(classification, (float)EMPTY_LIMIT));
+		mOccupancyHistogramTree->save(TREE_FILE, volumeKey, (float)EMPTY_LIMIT);
 	}
 
 	mOccupancyHistogramTree->buildVirtualTree();
@@ -333,6 +411,11 @@ void RenderFramework::destoryTexture()
 	mFactory->destroyTexture3D(mRaySegmentListBoxTypeTexture);
 	mFactory->destroyTexture3D(mRaySegmentListEventTypeTexture);
 
+	mFactory->destroyTexture2D(mRaySegmentListCountReadTexture);
+	mFactory->destroyTexture3D(mRaySegmentListDepthReadTexture);
+	mFactory->destroyTexture3D(mRaySegmentListBoxTypeReadTexture);
+	mFactory->destroyTexture3D(mRaySegmentListEventTypeReadTexture);
+
 	mFactory->destroyRenderTarget(mOccupancyGeometryRenderTarget);
 
 	mFactory->destroyUnorderedAccessUsage(mRaySegmentListCountUAVUsage);
@@ -344,6 +427,8 @@ void RenderFramework::destoryTexture()
 	mFactory->destroyResourceUsage(mRaySegmentListDepthSRVUsage);
 	mFactory->destroyResourceUsage(mRaySegmentListBoxTypeSRVUsage);
 	mFactory->destroyResourceUsage(mRaySegmentListEventTypeSRVUsage);
+
+	Utility::Delete(mRaySegmentListGenerator);
 }
 
 void RenderFramework::destoryVolumeData()
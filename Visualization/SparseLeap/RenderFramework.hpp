@@ -8,6 +8,9 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "OccupancyHistogramTree.hpp"
+#include "VolumeClassifier.hpp"
+#include "MappedFile.hpp"
+#include "RaySegmentListGenerator.hpp"
 #include "Helper.hpp"
 
 //max instance count, because some problem , we can not use it now.
@@ -25,6 +28,19 @@
 //max ray segment list count
 #define MAX_RAYSEGMENT 30
 
+//max occupancy geometry count that we generate ray segment list on GPU
+//if there are more geometry, we generate it on CPU
+#define MAX_GPU_OCCUPANCY_GEOMETRY 4096
+
+//max depth difference that the events of GPU and CPU are same, the depth of GPU is interpolated from the vertices
+#define RAY_SEGMENT_LIST_COMPARE_EPS 0.001f
+
+//volume data file
+#define VOLUME_FILE "Teddybear.raw"
+
+//cache of the tree built from volume data file
+#define TREE_FILE "Teddybear.raw.ohtree"
+
 /**
  * @brief framework for rendering
  */
@@ -52,6 +68,11 @@ private:
 	Texture3D* mRaySegmentListDepthTexture; //ray segment list depth texture
 	Texture3D* mRaySegmentListBoxTypeTexture; //ray segment list occupancy type texture
 	Texture3D* mRaySegmentListEventTypeTexture; //ray segment list event type texture
+
+	Texture2D* mRaySegmentListCountReadTexture; //read back ray segment list count texture, used in compare
+	Texture3D* mRaySegmentListDepthReadTexture; //read back ray segment list depth texture, used in compare
+	Texture3D* mRaySegmentListBoxTypeReadTexture; //read back ray segment list occupancy type texture, used in compare
+	Texture3D* mRaySegmentListEventTypeReadTexture; //read back ray segment list event type texture, used in compare
 	
 	Texture3D* mVolumeTexture; //volume data texture
 
@@ -70,6 +91,10 @@ private:
 
 	OccupancyHistogramTree* mOccupancyHistogramTree; //tree
 
+	RaySegmentListGenerator* mRaySegmentListGenerator; //generate ray segment list on CPU
+
+	bool mTraceTree = false; //trace the tree with ray packets instead of the occupancy geometry, switched by key T
+
 	glm::vec3 mPosition;
 	glm::vec3 mLookAt;
 	glm::vec3 mUp;
@@ -89,6 +114,11 @@ private:
 	 * @brief render function
 	 */
 	virtual void render(void* sender, float deltaTime)override;
+
+	/**
+	 * @brief key up function
+	 */
+	virtual void keyUp(void* sender, KeyBoardEvent* eventArg)override;
 	
 	/**
 	 * @brief render current instance
@@ -101,10 +131,25 @@ private:
 	void renderRaySegmentList();
 
 	/**
-	 * @sample volume data, return the average value
+	 * @brief generate ray segment list from the occupancy geometry on CPU and upload it, same as renderRaySegmentList
+	 */
+	void generateRaySegmentList();
+
+	/**
+	 * @brief generate ray segment list by tracing the tree on CPU and upload it
+	 * the list only has the changes of occupancy type, so it is not same as renderRaySegmentList but the ray casting is same
+	 */
+	void traceRaySegmentList();
+
+	/**
+	 * @brief upload the ray segment list of generator to the textures
+	 */
+	void uploadRaySegmentList();
+
+	/**
+	 * @brief generate ray segment list on GPU and CPU with the same occupancy geometry and print the different pixels, key C
 	 */
-	static auto sampleVolumeData(AxiallyAlignedBoundingBox sampleBox,
-		int width, int height, int depth, std::vector<unsigned char> &volumeData) -> float;
+	void compareRaySegmentList();
 
 	void buildState();
 	void buildCamera();
@@ -0,0 +1,149 @@
+#include "MappedFile.hpp"
+
+#include <cstdint>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+MappedFile::MappedFile(const std::string & fileName) :
+	mData(nullptr), mSize(0), mModifiedTime(0), mFile(nullptr), mMapping(nullptr)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE) return;
+
+	LARGE_INTEGER fileSize;
+
+	//we can not map a empty file
+	if (GetFileSizeEx(file, &fileSize) == FALSE || fileSize.QuadPart == 0) {
+		CloseHandle(file);
+
+		return;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (mapping == nullptr) {
+		CloseHandle(file);
+
+		return;
+	}
+
+	mData = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+	if (mData == nullptr) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+
+		return;
+	}
+
+	FILETIME writeTime;
+
+	//the time is only a part of key, so it is 0 if we can not get it
+	if (GetFileTime(file, nullptr, nullptr, &writeTime) == TRUE)
+		mModifiedTime = (static_cast<unsigned long long>(writeTime.dwHighDateTime) << 32) | writeTime.dwLowDateTime;
+
+	mSize = size_t(fileSize.QuadPart);
+	mFile = file;
+	mMapping = mapping;
+#else
+	int file = open(fileName.c_str(), O_RDONLY);
+
+	if (file < 0) return;
+
+	struct stat fileState;
+
+	//we can not map a empty file
+	if (fstat(file, &fileState) != 0 || fileState.st_size == 0) {
+		close(file);
+
+		return;
+	}
+
+	void* data = mmap(nullptr, size_t(fileState.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+	if (data == MAP_FAILED) {
+		close(file);
+
+		return;
+	}
+
+	mData = static_cast<const unsigned char*>(data);
+	mSize = size_t(fileState.st_size);
+	mModifiedTime = static_cast<unsigned long long>(fileState.st_mtime);
+	mFile = reinterpret_cast<void*>(intptr_t(file));
+#endif // _WIN32
+}
+
+MappedFile::~MappedFile()
+{
+	if (mData == nullptr) return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(mData);
+	CloseHandle(mMapping);
+	CloseHandle(mFile);
+#else
+	munmap(const_cast<unsigned char*>(mData), mSize);
+	close(int(reinterpret_cast<intptr_t>(mFile)));
+#endif // _WIN32
+}
+
+auto MappedFile::isOpen() const -> bool
+{
+	return mData != nullptr;
+}
+
+auto MappedFile::data() const -> const unsigned char *
+{
+	return mData;
+}
+
+auto MappedFile::size() const -> size_t
+{
+	return mSize;
+}
+
+auto MappedFile::key() const -> unsigned long long
+{
+	const size_t blockSize = MAPPED_FILE_KEY_BLOCK_SIZE;
+	const size_t blockCount = MAPPED_FILE_KEY_BLOCK_COUNT;
+
+	unsigned long long values[2 + MAPPED_FILE_KEY_BLOCK_COUNT] = { mSize, mModifiedTime };
+	size_t valueCount = 2;
+
+	if (mSize <= blockSize * blockCount) values[valueCount++] = hash(mData, mSize);
+	else {
+		//the first block is at the begin of file and the last block is at the end of file
+		for (size_t i = 0; i < blockCount; i++) {
+			const size_t offset = (mSize - blockSize) * i / (blockCount - 1);
+
+			values[valueCount++] = hash(mData + offset, blockSize);
+		}
+	}
+
+	return hash(values, valueCount * sizeof(unsigned long long));
+}
+
+auto MappedFile::hash(const void * data, size_t size) -> unsigned long long
+{
+	auto bytes = static_cast<const unsigned char*>(data);
+
+	unsigned long long value = 14695981039346656037ull;
+
+	for (size_t i = 0; i < size; i++) {
+		value = value ^ bytes[i];
+		value = value * 1099511628211ull;
+	}
+
+	return value;
+}
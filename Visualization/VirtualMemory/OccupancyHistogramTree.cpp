@@ -1,7 +1,9 @@
 #include "OccupancyHistogramTree.hpp"
 
 #include "Helper.hpp"
+#include "MappedFile.hpp"
 
+#include <fstream>
 #include <queue>
 
 #undef max
@@ -218,6 +220,66 @@ void OccupancyHistogramTree::setEyePosition(OccupancyHistogramNode* node, const
 	node->BackOrder = travelTimes++;
 }
 
+void OccupancyHistogramTree::release(OccupancyHistogramNode * node)
+{
+	for (auto i = 0; i < int(SpaceOrder::Count); i++) {
+		if (node->Children[i] == nullptr) continue;
+
+		release(node->Children[i]);
+
+		Utility::Delete(node->Children[i]);
+	}
+}
+
+auto OccupancyHistogramTree::save(const OccupancyHistogramNode * node, std::ostream & stream) const -> int
+{
+	OccupancyHistogramTreeFileNode fileNode;
+
+	std::memset(&fileNode, 0, sizeof(fileNode));
+
+	for (auto i = 0; i < int(SpaceOrder::Count); i++)
+		if (node->Children[i] != nullptr) fileNode.ChildMask |= static_cast<unsigned char>(1 << i);
+
+	fileNode.Type = static_cast<unsigned char>(node->Type);
+
+	std::memcpy(fileNode.OccupancyTypeCount, node->OccupancyTypeCount, sizeof(fileNode.OccupancyTypeCount));
+
+	stream.write(reinterpret_cast<const char*>(&fileNode), sizeof(fileNode));
+
+	auto nodeCount = 1;
+
+	for (auto i = 0; i < int(SpaceOrder::Count); i++)
+		if (node->Children[i] != nullptr) nodeCount += save(node->Children[i], stream);
+
+	return nodeCount;
+}
+
+auto OccupancyHistogramTree::load(OccupancyHistogramNode * node, const OccupancyHistogramTreeFileNode * nodes, int nodeCount, int & cursor) -> bool
+{
+	if (cursor >= nodeCount) return false;
+
+	const auto &fileNode = nodes[cursor++];
+
+	if (fileNode.Type >= static_cast<unsigned char>(OccupancyType::Count)) return false;
+
+	//node at max depth can not have children
+	if (fileNode.ChildMask != 0 && node->Depth >= mMaxDepth) return false;
+
+	node->Type = OccupancyType(fileNode.Type);
+
+	std::memcpy(node->OccupancyTypeCount, fileNode.OccupancyTypeCount, sizeof(node->OccupancyTypeCount));
+
+	for (auto i = 0; i < int(SpaceOrder::Count); i++) {
+		if ((fileNode.ChildMask & (1 << i)) == 0) continue;
+
+		node->Children[i] = getOccupancyHistogramNode(node, SpaceOrder(i), node->Depth + 1);
+
+		if (load(node->Children[i], nodes, nodeCount, cursor) == false) return false;
+	}
+
+	return true;
+}
+
 void OccupancyHistogramTree::setSize(const AxiallyAlignedBoundingBox &box)
 {
 	mRoot.AxiallyAlignedBoundingBox = box;
@@ -255,6 +317,74 @@ auto OccupancyHistogramTree::maxDepth() const -> int
 	return mMaxDepth;
 }
 
+auto OccupancyHistogramTree::save(const std::string & fileName, unsigned long long volumeKey, float emptyLimit) const -> bool
+{
+	std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+
+	if (file.is_open() == false) return false;
+
+	OccupancyHistogramTreeFileHeader header;
+
+	std::memset(&header, 0, sizeof(header));
+
+	header.Magic = OCCUPANCY_HISTOGRAM_TREE_FILE_MAGIC;
+	header.Version = OCCUPANCY_HISTOGRAM_TREE_FILE_VERSION;
+	header.VolumeKey = volumeKey;
+	header.MaxDepth = mMaxDepth;
+	header.EmptyLimit = emptyLimit;
+
+	//write the header again when we know the node count
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	header.NodeCount = save(&mRoot, file);
+
+	file.seekp(0, std::ios::beg);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	return file.good();
+}
+
+auto OccupancyHistogramTree::load(const std::string & fileName, unsigned long long volumeKey, float emptyLimit) -> bool
+{
+	const MappedFile file(fileName);
+
+	if (file.isOpen() == false || file.size() < sizeof(OccupancyHistogramTreeFileHeader)) return false;
+
+	OccupancyHistogramTreeFileHeader header;
+
+	std::memcpy(&header, file.data(), sizeof(header));
+
+	//the file is built from other volume or setting, or it is broken
+	if (header.Magic != OCCUPANCY_HISTOGRAM_TREE_FILE_MAGIC ||
+		header.Version != OCCUPANCY_HISTOGRAM_TREE_FILE_VERSION ||
+		header.VolumeKey != volumeKey ||
+		header.MaxDepth != mMaxDepth ||
+		header.EmptyLimit != emptyLimit ||
+		header.NodeCount <= 0 ||
+		file.size() != sizeof(header) + size_t(header.NodeCount) * sizeof(OccupancyHistogramTreeFileNode)) return false;
+
+	//the records are read from the mapped view, the nodes of tree are allocated again
+	const auto nodes = reinterpret_cast<const OccupancyHistogramTreeFileNode*>(file.data() + sizeof(header));
+	auto cursor = 0;
+
+	release(&mRoot);
+
+	mNodeCount = 0;
+
+	if (load(&mRoot, nodes, header.NodeCount, cursor) == false || cursor != header.NodeCount) {
+		release(&mRoot);
+
+		mNodeCount = 0;
+		mRoot.Type = OccupancyType::Unknown;
+
+		std::memset(mRoot.OccupancyTypeCount, 0, sizeof(mRoot.OccupancyTypeCount));
+
+		return false;
+	}
+
+	return true;
+}
+
 void OccupancyHistogramTree::getOccupancyGeometry(std::vector<OccupancyHistogramNodeCompareComponent>& geometry, bool sort)
 {
 	geometry.push_back(OccupancyHistogramNodeCompareComponent(&mRoot, true, mRoot.FrontOrder));
@@ -3,6 +3,7 @@
 #include <memory>
 #include <vector>
 #include <iostream>
+#include <string>
 #include <glm\glm.hpp>
 
 /**
@@ -133,6 +134,35 @@ struct OccupancyHistogramNodeCompareComponent {
 	}
 };
 
+//magic of the tree file, "OHTR"
+#define OCCUPANCY_HISTOGRAM_TREE_FILE_MAGIC 0x5254484F
+
+//version of the tree file, change it if the layout is changed
+#define OCCUPANCY_HISTOGRAM_TREE_FILE_VERSION 2
+
+/**
+ * @brief header of the tree file, the nodes follow it in preorder
+ */
+struct OccupancyHistogramTreeFileHeader {
+	unsigned int Magic;
+	unsigned int Version;
+	unsigned long long VolumeKey; //key of the volume file that the tree is built from, see MappedFile::key
+	int MaxDepth;
+	float EmptyLimit;
+	int NodeCount; //node count with root
+	int Reserved;
+};
+
+/**
+ * @brief node of the tree file
+ */
+struct OccupancyHistogramTreeFileNode {
+	unsigned char ChildMask; //bit i is set if Children[i] is existed
+	unsigned char Type;
+	unsigned short Reserved;
+	int OccupancyTypeCount[int(OccupancyType::Count)];
+};
+
 /**
  * @brief Occupancy Histogram Tree
  */
@@ -173,6 +203,21 @@ private:
 	 */
 	void setEyePosition(OccupancyHistogramNode* node, const glm::vec3 &eyePosition, int &travelTimes) const;
 
+	/**
+	 * @brief free the sub tree of node, node will be a leaf
+	 */
+	void release(OccupancyHistogramNode* node);
+
+	/**
+	 * @brief write the sub tree of node in preorder, return the count of written nodes
+	 */
+	auto save(const OccupancyHistogramNode* node, std::ostream &stream) const -> int;
+
+	/**
+	 * @brief read the sub tree of node from nodes[cursor], return false if the nodes are broken
+	 */
+	auto load(OccupancyHistogramNode* node, const OccupancyHistogramTreeFileNode* nodes, int nodeCount, int &cursor) -> bool;
+
 public:
 	OccupancyHistogramTree() {
 		mRoot.Depth = 1;
@@ -213,6 +258,18 @@ public:
 	 */
 	auto maxDepth() const -> int;
 
+	/**
+	 * @brief save tree to file, the volume key, max depth and empty limit are the key of file
+	 */
+	auto save(const std::string &fileName, unsigned long long volumeKey, float emptyLimit) const -> bool;
+
+	/**
+	 * @brief load tree from file, return false if the file is not existed or the key is not same
+	 * the nodes of tree have the pointers and bounding boxes, so the tree can not use the mapped file directly
+	 * the nodes are allocated again from the records in file, the mapping only avoids reading the file to a buffer
+	 */
+	auto load(const std::string &fileName, unsigned long long volumeKey, float emptyLimit) -> bool;
+
 	/**
 	 * @brief get occupancy geometry, some aabb with right order
 	 */
@@ -1,5 +1,6 @@
 #include "SparseLeapManager.hpp"
 #include "SharedMacro.hpp"
+#include "MappedFile.hpp"
 
 SparseLeapManager::SparseLeapManager(Factory* factory, int width, int height) :
 	mFactory(factory), mWidth(width), mHeight(height), mCube(), mOccupancyGeometryVertexShader(nullptr),
@@ -18,10 +19,11 @@ SparseLeapManager::SparseLeapManager(Factory* factory, int width, int height) :
 	mRaySegmentListDepthSRVUsage(nullptr),
 	mRaySegmentListBoxTypeSRVUsage(nullptr),
 	mRaySegmentListEventTypeSRVUsage(nullptr),
-	mOccupancyHistogramTree(nullptr) {
+	mOccupancyHistogramTree(nullptr),
+	mVolumeKey(0) {
 }
 
-void SparseLeapManager::initialize(const glm::vec3 &cube)
+void SparseLeapManager::initialize(const glm::vec3 &cube, const std::string &volumeFileName)
 {
 	mCube = cube;
 
@@ -58,6 +60,16 @@ void SparseLeapManager::initialize(const glm::vec3 &cube)
 
 	mOccupancyHistogramTree->setMaxDepth(MAX_DEPTH);
 	mOccupancyHistogramTree->setSize(AxiallyAlignedBoundingBox(-cube * 0.5f, cube * 0.5f));
+
+	//load the tree built in last run, it is keyed by volume file, max depth and empty limit
+	const MappedFile volumeFile(volumeFileName);
+
+	if (volumeFile.isOpen() == false) return;
+
+	mTreeFileName = volumeFileName + ".ohtree";
+	mVolumeKey = volumeFile.key();
+
+	mOccupancyHistogramTree->load(mTreeFileName, mVolumeKey, float(EMPTY_LIMIT));
 }
 
 void SparseLeapManager::finalize()
@@ -84,6 +96,9 @@ void SparseLeapManager::finalize()
 	mFactory->destroyResourceUsage(mRaySegmentListBoxTypeSRVUsage);
 	mFactory->destroyResourceUsage(mRaySegmentListEventTypeSRVUsage);
 
+	if (mTreeFileName.empty() == false)
+		mOccupancyHistogramTree->save(mTreeFileName, mVolumeKey, float(EMPTY_LIMIT));
+
 	Utility::Delete(mOccupancyHistogramTree);
 }
 
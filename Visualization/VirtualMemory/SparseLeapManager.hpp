@@ -6,6 +6,8 @@
 #include "SharedTexture3D.hpp"
 #include "Helper.hpp"
 
+#include <string>
+
 class SparseLeapManager {
 private:
 	Factory* mFactory;
@@ -38,14 +40,23 @@ private:
 
 	OccupancyHistogramTree* mOccupancyHistogramTree; //tree
 
+	std::string mTreeFileName; //cache of tree, empty if the volume file is not existed
+	unsigned long long mVolumeKey; //key of volume file, see MappedFile::key
+
 	std::vector<OccupancyHistogramNodeCompareComponent> mOccupancyGeometry; //aabb node
 
 	friend class VMRenderFramework;
 public:
 	SparseLeapManager(Factory* factory, int width, int height);
 
-	void initialize(const glm::vec3 &cube);
+	/**
+	 * @brief initialize resource, the tree is loaded from the cache of volume file if it is valid
+	 */
+	void initialize(const glm::vec3 &cube, const std::string &volumeFileName);
 
+	/**
+	 * @brief destroy resource, the tree is saved to the cache of volume file
+	 */
 	void finalize();
 
 	void update(const glm::vec3& cameraPosition);
@@ -322,9 +322,11 @@ void VMRenderFramework::initialize()
 	multiResolution.push_back(glm::vec3(0.3f, 0.3f, 0.3f));
 	multiResolution.push_back(glm::vec3(0.1f, 0.1f, 0.1f));
 
+	const std::string volumeFileName = "volume";
+
 #ifdef _SPARSE_LEAP
-	mSparseLeapManager->initialize(mCubeSize);
+	mSparseLeapManager->initialize(mCubeSize, volumeFileName);
 #endif // _SPARSE_LEAP
-	mVirtualMemoryManager->initialize("volume", multiResolution);
+	mVirtualMemoryManager->initialize(volumeFileName, multiResolution);
 }
 
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include "SharedMacro.hpp"
+#include "VolumeClassifier.hpp"
 
 #undef min
 
@@ -321,24 +322,21 @@ void VirtualMemoryManager::mapAddress(int resolution, int blockID)
 		auto tree = mSparseLeapManager->tree();
 		auto cube = mSparseLeapManager->cube();
 
-		auto xOffset = float(BLOCK_SIZE_XYZ) / (maxRange.X - minRange.X);
-		auto yOffset = float(BLOCK_SIZE_XYZ) / (maxRange.Y - minRange.Y);
-		auto zOffset = float(BLOCK_SIZE_XYZ) / (maxRange.Z - minRange.Z);
-		auto offset = glm::vec3(xOffset, yOffset, zOffset);
+		//classify all leaves covered by this block with one pass over its voxels
+		auto classification = VolumeClassifier::classify(output.getDataPointer(),
+			BLOCK_SIZE_XYZ, BLOCK_SIZE_XYZ, BLOCK_SIZE_XYZ,
+			maxRange.X - minRange.X, maxRange.Y - minRange.Y, maxRange.Z - minRange.Z, 1);
 
-		for (size_t x = minRange.X; x < maxRange.X; x++) {
-			for (size_t y = minRange.Y; y < maxRange.Y; y++) {
-				for (size_t z = minRange.Z; z < maxRange.Z; z++) {
+		for (int z = minRange.Z; z < maxRange.Z; z++) {
+			for (int y = minRange.Y; y < maxRange.Y; y++) {
+				for (int x = minRange.X; x < maxRange.X; x++) {
 					auto center = (glm::vec3(
 						(x + 0.5f) / treeBlockSize,
 						(y + 0.5f) / treeBlockSize,
 						(z + 0.5f) / treeBlockSize) - glm::vec3(0.5f)) * cube;
 
-					auto address = VirtualAddress(int(x) - minRange.X, int(y) - minRange.Y, int(z) - minRange.Z);
-
-					auto average = output.average(
-						Helper::multiple(address, offset),
-						Helper::multiple(Helper::add(address, VirtualAddress(1)), offset));
+					auto id = classification.index(x - minRange.X, y - minRange.Y, z - minRange.Z);
+					auto average = byte(classification.Sum[id] / classification.Count[id]);
 
 					tree->updateBlock(center, (average > byte(255 * EMPTY_LIMIT)) ? OccupancyType::NoEmpty : OccupancyType::Empty);
 				}
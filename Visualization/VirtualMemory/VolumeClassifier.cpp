@@ -0,0 +1,199 @@
+#include "VolumeClassifier.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VOLUME_CLASSIFIER_SSE2
+#endif
+
+VolumeClassification::VolumeClassification(int resolutionX, int resolutionY, int resolutionZ) :
+	ResolutionX(resolutionX), ResolutionY(resolutionY), ResolutionZ(resolutionZ)
+{
+	Sum.resize(size_t(resolutionX) * resolutionY * resolutionZ, 0);
+	Count.resize(size_t(resolutionX) * resolutionY * resolutionZ, 0);
+	Max.resize(size_t(resolutionX) * resolutionY * resolutionZ, 0);
+}
+
+auto VolumeClassification::index(int x, int y, int z) const -> int
+{
+	return (z * ResolutionY + y) * ResolutionX + x;
+}
+
+auto VolumeClassification::average(int x, int y, int z) const -> float
+{
+	const int id = index(x, y, z);
+
+	return float(double(Sum[id]) / (double(Count[id]) * 255.0));
+}
+
+auto VolumeClassifier::leafStart(int size, int resolution) -> std::vector<int>
+{
+	std::vector<int> start(resolution + 1);
+
+	//same boundary as int(leaf / resolution * size), but without the float error
+	for (int i = 0; i <= resolution; i++)
+		start[i] = int((long long)(i) * size / resolution);
+
+	return start;
+}
+
+auto VolumeClassifier::leafOf(const std::vector<int>& start, int size) -> std::vector<int>
+{
+	std::vector<int> leaf(size);
+
+	//if there are more leaves than voxels, some leaves cover nothing
+	//and the voxel belongs to the last leaf that starts at it
+	for (int i = 0; i + 1 < int(start.size()); i++)
+		for (int v = start[i]; v < start[i + 1]; v++) leaf[v] = i;
+
+	return leaf;
+}
+
+auto VolumeClassifier::leafCenter(int leaf, int size, int resolution) -> int
+{
+	return std::min(size - 1, int(((long long)(leaf) * 2 + 1) * size / (resolution * 2)));
+}
+
+void VolumeClassifier::accumulateRow(const unsigned char* row, int width, unsigned int* sum, unsigned char* max)
+{
+	int x = 0;
+
+#ifdef VOLUME_CLASSIFIER_SSE2
+	const __m128i zero = _mm_setzero_si128();
+
+	//16 voxels per step, widen u8 -> u16 -> u32 for the sum
+	for (; x + 16 <= width; x += 16) {
+		const __m128i value = _mm_loadu_si128((const __m128i*)(row + x));
+
+		_mm_storeu_si128((__m128i*)(max + x), _mm_max_epu8(_mm_loadu_si128((const __m128i*)(max + x)), value));
+
+		const __m128i low = _mm_unpacklo_epi8(value, zero);
+		const __m128i high = _mm_unpackhi_epi8(value, zero);
+
+		__m128i* target = (__m128i*)(sum + x);
+
+		_mm_storeu_si128(target + 0, _mm_add_epi32(_mm_loadu_si128(target + 0), _mm_unpacklo_epi16(low, zero)));
+		_mm_storeu_si128(target + 1, _mm_add_epi32(_mm_loadu_si128(target + 1), _mm_unpackhi_epi16(low, zero)));
+		_mm_storeu_si128(target + 2, _mm_add_epi32(_mm_loadu_si128(target + 2), _mm_unpacklo_epi16(high, zero)));
+		_mm_storeu_si128(target + 3, _mm_add_epi32(_mm_loadu_si128(target + 3), _mm_unpackhi_epi16(high, zero)));
+	}
+#endif // VOLUME_CLASSIFIER_SSE2
+
+	for (; x < width; x++) {
+		sum[x] = sum[x] + row[x];
+		max[x] = std::max(max[x], row[x]);
+	}
+}
+
+void VolumeClassifier::classifyLayers(const unsigned char * volumeData, int width, int height, int depth,
+	const std::vector<int> start[3], const std::vector<int>& leafOfY,
+	int fromLayer, int toLayer, VolumeClassification & classification)
+{
+	const int resolutionX = classification.ResolutionX;
+	const int resolutionY = classification.ResolutionY;
+	const int resolutionZ = classification.ResolutionZ;
+
+	//column accumulators of one leaf layer, one row of columns per leaf row
+	std::vector<unsigned int> columnSum(size_t(resolutionY) * width);
+	std::vector<unsigned char> columnMax(size_t(resolutionY) * width);
+
+	for (int layer = fromLayer; layer < toLayer; layer++) {
+		std::fill(columnSum.begin(), columnSum.end(), 0);
+		std::fill(columnMax.begin(), columnMax.end(), 0);
+
+		//stream the voxels of this layer in memory order
+		for (int z = start[2][layer]; z < start[2][layer + 1]; z++) {
+			const unsigned char* slice = volumeData + size_t(z) * width * height;
+
+			for (int y = 0; y < height; y++) {
+				const size_t offset = size_t(leafOfY[y]) * width;
+
+				accumulateRow(slice + size_t(y) * width, width, &columnSum[offset], &columnMax[offset]);
+			}
+		}
+
+		//reduce the columns of each leaf
+		for (int y = 0; y < resolutionY; y++) {
+			for (int x = 0; x < resolutionX; x++) {
+				const int id = classification.index(x, y, layer);
+
+				const int sizeX = start[0][x + 1] - start[0][x];
+				const int sizeY = start[1][y + 1] - start[1][y];
+				const int sizeZ = start[2][layer + 1] - start[2][layer];
+
+				//the leaf is smaller than a voxel, so we sample the voxel at its center
+				if (sizeX == 0 || sizeY == 0 || sizeZ == 0) {
+					const size_t address =
+						(size_t(leafCenter(layer, depth, resolutionZ)) * height +
+							leafCenter(y, height, resolutionY)) * width +
+						leafCenter(x, width, resolutionX);
+
+					classification.Sum[id] = volumeData[address];
+					classification.Count[id] = 1;
+					classification.Max[id] = volumeData[address];
+
+					continue;
+				}
+
+				unsigned long long sum = 0;
+				unsigned char max = 0;
+
+				for (int column = start[0][x]; column < start[0][x + 1]; column++) {
+					sum = sum + columnSum[size_t(y) * width + column];
+					max = std::max(max, columnMax[size_t(y) * width + column]);
+				}
+
+				classification.Sum[id] = sum;
+				classification.Count[id] = unsigned(sizeX * sizeY * sizeZ);
+				classification.Max[id] = max;
+			}
+		}
+	}
+}
+
+auto VolumeClassifier::classify(const unsigned char * volumeData, int width, int height, int depth,
+	int resolutionX, int resolutionY, int resolutionZ, int threadCount) -> VolumeClassification
+{
+	assert(width > 0 && height > 0 && depth > 0);
+	assert(resolutionX > 0 && resolutionY > 0 && resolutionZ > 0);
+
+	VolumeClassification classification(resolutionX, resolutionY, resolutionZ);
+
+	std::vector<int> start[3] = {
+		leafStart(width, resolutionX),
+		leafStart(height, resolutionY),
+		leafStart(depth, resolutionZ)
+	};
+
+	auto leafOfY = leafOf(start[1], height);
+
+	if (threadCount <= 0) threadCount = std::max(1, int(std::thread::hardware_concurrency()));
+
+	threadCount = std::min(threadCount, resolutionZ);
+
+	if (threadCount == 1) {
+		classifyLayers(volumeData, width, height, depth, start, leafOfY, 0, resolutionZ, classification);
+
+		return classification;
+	}
+
+	//each thread owns a slab of leaf layers, so they never write the same leaf
+	std::vector<std::thread> threads;
+
+	const int layerPerThread = (resolutionZ + threadCount - 1) / threadCount;
+
+	for (int fromLayer = 0; fromLayer < resolutionZ; fromLayer += layerPerThread) {
+		const int toLayer = std::min(resolutionZ, fromLayer + layerPerThread);
+
+		threads.push_back(std::thread([&, fromLayer, toLayer]() {
+			classifyLayers(volumeData, width, height, depth, start, leafOfY, fromLayer, toLayer, classification);
+		}));
+	}
+
+	for (auto &thread : threads) thread.join();
+
+	return classification;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+
+/**
+ * @brief per-leaf statistics of a volume, indexed by (z * ResolutionY + y) * ResolutionX + x
+ */
+struct VolumeClassification {
+	int ResolutionX;
+	int ResolutionY;
+	int ResolutionZ;
+
+	std::vector<unsigned long long> Sum;
+	std::vector<unsigned int> Count;
+	std::vector<unsigned char> Max;
+
+	VolumeClassification(int resolutionX = 0, int resolutionY = 0, int resolutionZ = 0);
+
+	auto index(int x, int y, int z) const -> int;
+
+	auto average(int x, int y, int z) const -> float;
+};
+
+/**
+ * @brief classify the leaves of the occupancy tree with one pass over the volume
+ */
+class VolumeClassifier {
+private:
+	/**
+	 * @brief the first voxel of each leaf along one axis, the last element is the size of axis
+	 */
+	static auto leafStart(int size, int resolution) -> std::vector<int>;
+
+	/**
+	 * @brief the leaf that each voxel along one axis belongs to
+	 */
+	static auto leafOf(const std::vector<int> &start, int size) -> std::vector<int>;
+
+	/**
+	 * @brief the voxel at the center of a leaf along one axis, used when the leaf covers no voxel
+	 */
+	static auto leafCenter(int leaf, int size, int resolution) -> int;
+
+	/**
+	 * @brief accumulate one row of voxels into the column sums and max
+	 */
+	static void accumulateRow(const unsigned char* row, int width, unsigned int* sum, unsigned char* max);
+
+	/**
+	 * @brief classify the leaf layers [fromLayer, toLayer)
+	 */
+	static void classifyLayers(const unsigned char* volumeData, int width, int height, int depth,
+		const std::vector<int> start[3], const std::vector<int> &leafOfY,
+		int fromLayer, int toLayer, VolumeClassification &classification);
+public:
+	/**
+	 * @brief classify the volume(width * height * depth bytes, x is the fastest axis) into resolution leaves
+	 * the volume is split into slabs of leaf layers and each slab is handled by one thread
+	 * @param[in] threadCount the max number of threads, 0 means hardware concurrency
+	 */
+	static auto classify(const unsigned char* volumeData, int width, int height, int depth,
+		int resolutionX, int resolutionY, int resolutionZ, int threadCount = 0) -> VolumeClassification;
+
+};